@@ -409,28 +409,31 @@ vector<operation_history_object> history_api::get_account_history_operations(con
       return result;
    }
 
-   const auto &stats = account(db).statistics(db);
-   if (stats.most_recent_op == account_transaction_history_id_type())
-      return result;
-   const account_transaction_history_object *node = &stats.most_recent_op(db);
-   if (start == operation_history_id_type())
-      start = node->operation_id;
-
-   while (node && node->operation_id.instance.value > stop.instance.value && result.size() < limit) {
-      if (node->operation_id.instance.value <= start.instance.value) {
-
-         if (node->operation_id(db).op.which() == operation_id)
-            result.push_back(node->operation_id(db));
-      }
-      if (node->next == account_transaction_history_id_type())
-         node = nullptr;
-      else
-         node = &node->next(db);
+   const auto &hist_idx = db.get_index_type<account_transaction_history_index>();
+   const auto &by_op_idx = hist_idx.indices().get<by_op>();
+   const auto &by_type_seq_idx = hist_idx.indices().get<by_type_seq>();
+
+   // within an account the sequence grows with the operation id, so the most recent entry at or before start
+   // gives the sequence to continue from among the operations of the asked type
+   uint32_t start_seq = std::numeric_limits<uint32_t>::max();
+   if (start != operation_history_id_type()) {
+      auto op_itr = by_op_idx.upper_bound(boost::make_tuple(account, start));
+      if (op_itr == by_op_idx.begin())
+         return result;
+      --op_itr;
+      if (op_itr->account != account)
+         return result;
+      start_seq = op_itr->sequence;
    }
-   if (stop.instance.value == 0 && result.size() < limit) {
-      auto head = db.find(account_transaction_history_id_type());
-      if (head != nullptr && head->account == account && head->operation_id(db).op.which() == operation_id)
-         result.push_back(head->operation_id(db));
+
+   auto itr = by_type_seq_idx.upper_bound(boost::make_tuple(account, operation_id, start_seq));
+   while (itr != by_type_seq_idx.begin() && result.size() < limit) {
+      --itr;
+      if (itr->account != account || itr->operation_type != operation_id)
+         break;
+      if (stop != operation_history_id_type() && itr->operation_id.instance.value <= stop.instance.value)
+         break;
+      result.push_back(itr->operation_id(db));
    }
    return result;
 }
@@ -473,6 +476,43 @@ vector<operation_history_object> history_api::get_relative_account_history(const
    return result;
 }
 
+vector<operation_history_object> history_api::get_relative_account_history_operations(const std::string account_id_or_name,
+                                                                                      int operation_id,
+                                                                                      uint32_t stop,
+                                                                                      unsigned limit,
+                                                                                      uint32_t start) const {
+   FC_ASSERT(_app.chain_database());
+   const auto &db = *_app.chain_database();
+   FC_ASSERT(limit <= api_limit_get_relative_account_history,
+             "Number of querying accounts can not be greater than ${configured_limit}",
+             ("configured_limit", api_limit_get_relative_account_history));
+
+   vector<operation_history_object> result;
+   account_id_type account;
+   try {
+      account = database_api.get_account_id_from_string(account_id_or_name);
+   } catch (...) {
+      return result;
+   }
+   const auto &stats = account(db).statistics(db);
+   if (start == 0)
+      start = stats.total_ops;
+   else
+      start = min(stats.total_ops, start);
+
+   const auto &hist_idx = db.get_index_type<account_transaction_history_index>();
+   const auto &by_type_seq_idx = hist_idx.indices().get<by_type_seq>();
+
+   auto itr = by_type_seq_idx.upper_bound(boost::make_tuple(account, operation_id, start));
+   while (itr != by_type_seq_idx.begin() && result.size() < limit) {
+      --itr;
+      if (itr->account != account || itr->operation_type != operation_id || itr->sequence < stop)
+         break;
+      result.push_back(itr->operation_id(db));
+   }
+   return result;
+}
+
 vector<account_balance_object> history_api::list_core_accounts() const {
    auto list = _app.get_plugin<accounts_list_plugin>("accounts_list");
    FC_ASSERT(list);
@@ -524,6 +564,15 @@ asset_api::asset_api(graphene::app::application &app) :
 asset_api::~asset_api() {
 }
 
+namespace {
+/// Number of balance objects of an asset, found from the ranks of the ends of its range
+int64_t asset_balance_count(const graphene::chain::database &db, asset_id_type asset_id) {
+   const auto &bal_idx = db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
+   return int64_t(bal_idx.rank(bal_idx.upper_bound(boost::make_tuple(asset_id)))) -
+          int64_t(bal_idx.rank(bal_idx.lower_bound(boost::make_tuple(asset_id))));
+}
+} // namespace
+
 vector<account_asset_balance> asset_api::get_asset_holders(std::string asset, uint32_t start, uint32_t limit) const {
    FC_ASSERT(limit <= api_limit_get_asset_holders,
              "Number of querying asset holder accounts can not be greater than ${configured_limit}",
@@ -531,27 +580,23 @@ vector<account_asset_balance> asset_api::get_asset_holders(std::string asset, ui
 
    asset_id_type asset_id = database_api.get_asset_id_from_string(asset);
    const auto &bal_idx = _db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
-   auto range = bal_idx.equal_range(boost::make_tuple(asset_id));
+   // balances are ordered descending, so the zero balances of an asset come after all of its holders
+   auto holders_begin = bal_idx.lower_bound(boost::make_tuple(asset_id));
+   auto holders_end = bal_idx.lower_bound(boost::make_tuple(asset_id, share_type(0)));
+   auto first_rank = bal_idx.rank(holders_begin);
+   if (start >= bal_idx.rank(holders_end) - first_rank)
+      return {};
 
    vector<account_asset_balance> result;
+   result.reserve(limit);
 
-   uint32_t index = 0;
-   for (const account_balance_object &bal : boost::make_iterator_range(range.first, range.second)) {
-      if (result.size() >= limit)
-         break;
-
-      if (bal.balance.value == 0)
-         continue;
-
-      if (index++ < start)
-         continue;
-
-      const auto account = _db.find(bal.owner);
+   for (auto itr = bal_idx.nth(first_rank + start); itr != holders_end && result.size() < limit; ++itr) {
+      const auto account = _db.find(itr->owner);
 
       account_asset_balance aab;
       aab.name = account->name;
       aab.account_id = account->id;
-      aab.amount = bal.balance.value;
+      aab.amount = itr->balance.value;
 
       result.push_back(aab);
    }
@@ -561,10 +606,8 @@ vector<account_asset_balance> asset_api::get_asset_holders(std::string asset, ui
 // get number of asset holders.
 int asset_api::get_asset_holders_count(std::string asset) const {
 
-   const auto &bal_idx = _db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
    asset_id_type asset_id = database_api.get_asset_id_from_string(asset);
-   auto range = bal_idx.equal_range(boost::make_tuple(asset_id));
-   int count = boost::distance(range) - 1;
+   int count = asset_balance_count(_db, asset_id) - 1;
 
    return count;
 }
@@ -580,10 +623,7 @@ vector<asset_holders> asset_api::get_all_asset_holders() const {
       asset_id_type asset_id;
       asset_id = dasset_obj.id;
 
-      const auto &bal_idx = _db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
-      auto range = bal_idx.equal_range(boost::make_tuple(asset_id));
-
-      int count = boost::distance(range) - 1;
+      int count = asset_balance_count(_db, asset_id) - 1;
 
       asset_holders ah;
       ah.asset_id = asset_id;
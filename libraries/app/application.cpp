@@ -50,6 +50,7 @@
 
 #include <atomic>
 #include <iostream>
+#include <list>
 
 #include <fc/log/file_appender.hpp>
 #include <fc/log/logger.hpp>
@@ -103,6 +104,52 @@ genesis_state_type create_example_genesis() {
    return initial_state;
 }
 
+/**
+ * The block messages most recently served to peers, up to a total size.  Peers syncing from us request the same
+ * blocks at about the same time, and a block's message never changes once it is known by id.
+ */
+class served_block_cache {
+public:
+   explicit served_block_cache(size_t max_bytes) :
+         _max_bytes(max_bytes) {
+   }
+
+   const net::message *find(const block_id_type &id) {
+      auto itr = _by_id.find(id);
+      if (itr == _by_id.end())
+         return nullptr;
+      _entries.splice(_entries.begin(), _entries, itr->second);
+      return &itr->second->second;
+   }
+
+   const net::message &insert(const block_id_type &id, net::message msg) {
+      auto itr = _by_id.find(id);
+      if (itr != _by_id.end())
+         erase(itr->second);
+      _bytes += msg.data.size();
+      _entries.emplace_front(id, std::move(msg));
+      _by_id[id] = _entries.begin();
+      // the block just inserted is kept even if it is larger than the limit, it is returned by reference
+      while (_bytes > _max_bytes && _entries.size() > 1)
+         erase(std::prev(_entries.end()));
+      return _entries.front().second;
+   }
+
+private:
+   typedef std::list<std::pair<block_id_type, net::message>> entry_list;
+
+   void erase(entry_list::iterator entry) {
+      _bytes -= entry->second.data.size();
+      _by_id.erase(entry->first);
+      _entries.erase(entry);
+   }
+
+   size_t _max_bytes;
+   size_t _bytes = 0;
+   entry_list _entries;
+   std::map<block_id_type, entry_list::iterator> _by_id;
+};
+
 class application_impl : public net::node_delegate {
 public:
    fc::optional<fc::temp_file> _lock_file;
@@ -264,46 +311,51 @@ public:
          genesis.initial_witness_candidates[i].block_signing_key = init_pubkey;
    }
 
+   /// The genesis state from genesis-json, or the embedded one, with its chain id
+   genesis_state_type load_genesis() {
+      if (_options->count("genesis-json")) {
+         std::string genesis_str;
+         fc::read_file_contents(_options->at("genesis-json").as<boost::filesystem::path>(), genesis_str);
+         genesis_state_type genesis = fc::json::from_string(genesis_str).as<genesis_state_type>(20);
+         bool modified_genesis = false;
+         if (_options->count("genesis-timestamp")) {
+            genesis.initial_timestamp = fc::time_point_sec(fc::time_point::now()) + genesis.initial_parameters.block_interval + _options->at("genesis-timestamp").as<uint32_t>();
+            genesis.initial_timestamp -= genesis.initial_timestamp.sec_since_epoch() % genesis.initial_parameters.block_interval;
+            modified_genesis = true;
+            std::cerr << "Used genesis timestamp:  " << genesis.initial_timestamp.to_iso_string() << " (PLEASE RECORD THIS)\n";
+         }
+         if (_options->count("dbg-init-key")) {
+            std::string init_key = _options->at("dbg-init-key").as<string>();
+            FC_ASSERT(genesis.initial_witness_candidates.size() >= genesis.initial_active_witnesses);
+            set_dbg_init_key(genesis, init_key);
+            modified_genesis = true;
+            std::cerr << "Set init witness key to " << init_key << "\n";
+         }
+         if (modified_genesis) {
+            std::cerr << "WARNING:  GENESIS WAS MODIFIED, YOUR CHAIN ID MAY BE DIFFERENT\n";
+            genesis_str += "BOGUS";
+            genesis.initial_chain_id = fc::sha256::hash(genesis_str);
+         } else
+            genesis.initial_chain_id = fc::sha256::hash(genesis_str);
+         return genesis;
+      } else {
+         std::string egenesis_json;
+         graphene::egenesis::compute_egenesis_json(egenesis_json);
+         FC_ASSERT(egenesis_json != "");
+         FC_ASSERT(graphene::egenesis::get_egenesis_json_hash() == fc::sha256::hash(egenesis_json));
+         auto genesis = fc::json::from_string(egenesis_json).as<genesis_state_type>(20);
+         genesis.initial_chain_id = fc::sha256::hash(egenesis_json);
+         return genesis;
+      }
+   }
+
    void startup() {
       try {
          fc::create_directories(_data_dir / "blockchain");
 
          auto initial_state = [this] {
             ilog("Initializing database...");
-            if (_options->count("genesis-json")) {
-               std::string genesis_str;
-               fc::read_file_contents(_options->at("genesis-json").as<boost::filesystem::path>(), genesis_str);
-               genesis_state_type genesis = fc::json::from_string(genesis_str).as<genesis_state_type>(20);
-               bool modified_genesis = false;
-               if (_options->count("genesis-timestamp")) {
-                  genesis.initial_timestamp = fc::time_point_sec(fc::time_point::now()) + genesis.initial_parameters.block_interval + _options->at("genesis-timestamp").as<uint32_t>();
-                  genesis.initial_timestamp -= genesis.initial_timestamp.sec_since_epoch() % genesis.initial_parameters.block_interval;
-                  modified_genesis = true;
-                  std::cerr << "Used genesis timestamp:  " << genesis.initial_timestamp.to_iso_string() << " (PLEASE RECORD THIS)\n";
-               }
-               if (_options->count("dbg-init-key")) {
-                  std::string init_key = _options->at("dbg-init-key").as<string>();
-                  FC_ASSERT(genesis.initial_witness_candidates.size() >= genesis.initial_active_witnesses);
-                  set_dbg_init_key(genesis, init_key);
-                  modified_genesis = true;
-                  std::cerr << "Set init witness key to " << init_key << "\n";
-               }
-               if (modified_genesis) {
-                  std::cerr << "WARNING:  GENESIS WAS MODIFIED, YOUR CHAIN ID MAY BE DIFFERENT\n";
-                  genesis_str += "BOGUS";
-                  genesis.initial_chain_id = fc::sha256::hash(genesis_str);
-               } else
-                  genesis.initial_chain_id = fc::sha256::hash(genesis_str);
-               return genesis;
-            } else {
-               std::string egenesis_json;
-               graphene::egenesis::compute_egenesis_json(egenesis_json);
-               FC_ASSERT(egenesis_json != "");
-               FC_ASSERT(graphene::egenesis::get_egenesis_json_hash() == fc::sha256::hash(egenesis_json));
-               auto genesis = fc::json::from_string(egenesis_json).as<genesis_state_type>(20);
-               genesis.initial_chain_id = fc::sha256::hash(egenesis_json);
-               return genesis;
-            }
+            return load_genesis();
          };
 
          if (_options->count("resync-blockchain"))
@@ -324,6 +376,22 @@ public:
             _chain_db->enable_standby_votes_tracking(_options->at("enable-standby-votes-tracking").as<bool>());
          }
 
+         if (_options->count("signature-recovery-threads")) {
+            _chain_db->set_precompute_threads(_options->at("signature-recovery-threads").as<uint32_t>());
+         }
+
+         if (_options->count("api-read-threads")) {
+            _chain_db->set_read_threads(_options->at("api-read-threads").as<uint32_t>());
+         }
+
+         if (_options->count("apply-metrics") && _options->at("apply-metrics").as<bool>()) {
+            _chain_db->enable_apply_metrics(true, _options->at("apply-metrics-log-blocks").as<uint32_t>());
+         }
+
+         if (_options->count("replay-prefetch-blocks")) {
+            _chain_db->set_replay_prefetch_blocks(_options->at("replay-prefetch-blocks").as<uint32_t>());
+         }
+
          std::string replay_reason = "reason not provided";
 
          if (_options->count("replay-blockchain"))
@@ -558,13 +626,20 @@ public:
       try {
          // ilog("Request for item ${id}", ("id", id));
          if (id.item_type == graphene::net::block_message_type) {
+            const message *served = _served_blocks.find(id.item_hash);
+            if (served)
+               return *served;
+            // blocks in the block database are forwarded as stored instead of being unpacked and packed again
+            auto packed = _chain_db->fetch_packed_block_by_id(id.item_hash);
+            if (packed)
+               return _served_blocks.insert(id.item_hash, graphene::net::packed_block_message(packed->data, packed->size, packed->id));
             auto opt_block = _chain_db->fetch_block_by_id(id.item_hash);
             if (!opt_block)
                elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
                     ("id", id.item_hash)("id2", _chain_db->get_block_id_for_num(block_header::num_from_id(id.item_hash))));
             FC_ASSERT(opt_block.valid());
             // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-            return block_message(std::move(*opt_block));
+            return _served_blocks.insert(id.item_hash, block_message(std::move(*opt_block)));
          }
          return trx_message(_chain_db->get_recent_transaction(id.item_hash));
       }
@@ -798,6 +873,11 @@ public:
       return _chain_db->get_global_properties().parameters.block_interval;
    }
 
+   std::vector<signed_transaction> get_pending_transactions() override {
+      const std::lock_guard<std::mutex> pending_tx_lock{_chain_db->_pending_tx_mutex};
+      return std::vector<signed_transaction>(_chain_db->_pending_tx.begin(), _chain_db->_pending_tx.end());
+   }
+
    application *_self;
 
    fc::path _data_dir;
@@ -813,6 +893,8 @@ public:
    std::map<string, std::shared_ptr<abstract_plugin>> _available_plugins;
 
    bool _is_finished_syncing = false;
+
+   served_block_cache _served_blocks{16 * 1024 * 1024};
 };
 
 } // namespace detail
@@ -862,6 +944,23 @@ void application::set_program_options(boost::program_options::options_descriptio
    cfg.add_options()("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
                      "Whether to enable tracking of votes of standby witnesses and committee members. "
                      "Set it to true to provide accurate data to API clients, set to false for slightly better performance.");
+   cfg.add_options()("signature-recovery-threads", bpo::value<uint32_t>(),
+                     "Number of threads recovering transaction signature keys of incoming blocks before they are applied "
+                     "and tallying votes at maintenance intervals. "
+                     "Defaults to the number of CPU cores, 0 does this work on the chain thread.");
+   cfg.add_options()("api-read-threads", bpo::value<uint32_t>()->default_value(0),
+                     "Number of threads serving read-only database API calls such as get_full_accounts, get_order_book "
+                     "and list_assets between blocks, so that they run alongside block processing. "
+                     "0 serves them on the chain thread.");
+   cfg.add_options()("apply-metrics", bpo::value<bool>()->implicit_value(true),
+                     "Whether to record per-operation-type and per-block-phase apply latencies, "
+                     "reported by the get_apply_metrics API call.");
+   cfg.add_options()("apply-metrics-log-blocks", bpo::value<uint32_t>()->default_value(1200),
+                     "Number of blocks between apply latency reports written to the log when apply-metrics is enabled, "
+                     "0 disables the reports.");
+   cfg.add_options()("replay-prefetch-blocks", bpo::value<uint32_t>(),
+                     "Number of blocks read, unpacked and checked by a separate thread ahead of the chain during a replay. "
+                     "Defaults to 1000, 0 reads the blocks on the chain thread.");
    cfg.add_options()("plugins", bpo::value<string>()->default_value("account_history accounts_list affiliate_stats bookie market_history witness"),
                      "Space-separated list of plugins to activate");
 
@@ -965,6 +1064,14 @@ std::shared_ptr<chain::database> application::chain_database() const {
    return my->_chain_db;
 }
 
+fc::path application::data_dir() const {
+   return my->_data_dir;
+}
+
+chain::chain_id_type application::genesis_chain_id() const {
+   return my->load_genesis().compute_chain_id();
+}
+
 void application::set_block_production(bool producing_blocks) {
    my->_is_block_producer = producing_blocks;
 }
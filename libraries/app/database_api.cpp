@@ -23,6 +23,7 @@
  */
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/app/subscription_index.hpp>
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/chain/protocol/address.hpp>
@@ -31,7 +32,6 @@
 
 #include <graphene/utilities/git_revision.hpp>
 
-#include <fc/bloom_filter.hpp>
 
 #include <fc/crypto/hex.hpp>
 #include <fc/rpc/api_connection.hpp>
@@ -66,6 +66,16 @@ optional<T> maybe_id(const string &name_or_id) {
    return optional<T>();
 }
 
+/// Runs the read-only API call @ref f through database::run_read() and returns its result
+template <typename Functor>
+auto read_only(const graphene::chain::database &db, Functor &&f) -> decltype(f()) {
+   optional<decltype(f())> result;
+   db.run_read([&]() {
+      result = f();
+   });
+   return std::move(*result);
+}
+
 std::string object_id_to_string(object_id_type id) {
    std::string object_id = fc::to_string(id.space()) + "." + fc::to_string(id.type()) + "." + fc::to_string(id.instance());
    return object_id;
@@ -82,7 +92,8 @@ signed_block_with_info::signed_block_with_info(const signed_block &block) :
       transaction_ids.push_back(tx.id());
 }
 
-class database_api_impl : public std::enable_shared_from_this<database_api_impl> {
+class database_api_impl : public std::enable_shared_from_this<database_api_impl>,
+                          public subscription_index::subscriber {
 public:
    database_api_impl(graphene::chain::database &db);
    ~database_api_impl();
@@ -112,6 +123,7 @@ public:
    chain_id_type get_chain_id() const;
    dynamic_global_property_object get_dynamic_global_properties() const;
    global_betting_statistics_object get_global_betting_statistics() const;
+   apply_metrics_report get_apply_metrics() const;
 
    // Keys
    vector<vector<account_id_type>> get_key_references(vector<public_key_type> key) const;
@@ -238,7 +250,9 @@ public:
    }
    votes_info get_votes(const string &account_name_or_id) const;
    vector<account_object> get_voters_by_id(const vote_id_type &vote_id) const;
+   vector<account_object> list_voters_by_id(const vote_id_type &vote_id, const account_id_type lower_id, uint32_t limit) const;
    voters_info get_voters(const string &account_name_or_id) const;
+   const set<account_id_type> &get_voter_ids(const vote_id_type &vote_id) const;
 
    // Authority / validation
    std::string get_transaction_hex(const signed_transaction &trx) const;
@@ -306,6 +320,7 @@ public:
    uint32_t api_limit_all_offers_count = 100;
    uint32_t api_limit_nft_tokens = 100;
    uint32_t api_limit_lookup_accounts = 1000;
+   uint32_t api_limit_list_voters_by_id = 1000;
    uint32_t api_limit_lookup_witness_accounts = 1000;
    uint32_t api_limit_lookup_committee_member_accounts = 1000;
    uint32_t api_limit_lookup_son_accounts = 1000;
@@ -318,67 +333,38 @@ public:
                                                  bool throw_if_not_found = true) const;
    const asset_object *get_asset_from_string(const std::string &symbol_or_id,
                                              bool throw_if_not_found = true) const;
+   /// Only objects are matched against the changes of a block, other items are not subscribed to
    template <typename T>
-   void subscribe_to_item(const T &i) const {
-      auto vec = fc::raw::pack(i);
-      if (!_subscribe_callback)
-         return;
-
-      if (!is_subscribed_to_item(i)) {
-         _subscribe_filter.insert(vec.data(), vec.size()); //(vecconst char*)&i, sizeof(i) );
-      }
+   void subscribe_to_item(const T &) const {
    }
 
-   template <typename T>
-   bool is_subscribed_to_item(const T &i) const {
-      if (!_subscribe_callback)
-         return false;
-
-      return _subscribe_filter.contains(i);
+   void subscribe_to_item(object_id_type id) const {
+      if (_subscriber_id)
+         _subscriptions->subscribe_to_object(_subscriber_id, id);
    }
 
-   bool is_impacted_account(const flat_set<account_id_type> &accounts) {
-      if (!_subscribed_accounts.size() || !accounts.size())
-         return false;
-
-      return std::any_of(accounts.begin(), accounts.end(), [this](const account_id_type &account) {
-         return _subscribed_accounts.find(account) != _subscribed_accounts.end();
-      });
+   template <uint8_t SpaceID, uint8_t TypeID, typename T>
+   void subscribe_to_item(const object_id<SpaceID, TypeID, T> &id) const {
+      subscribe_to_item(object_id_type(id));
    }
 
-   template <typename T>
-   void enqueue_if_subscribed_to_market(const object *obj, market_queue_type &queue, bool full_object = true) {
-      const T *order = dynamic_cast<const T *>(obj);
-      FC_ASSERT(order != nullptr);
-
-      auto market = order->get_market();
-
-      auto sub = _market_subscriptions.find(market);
-      if (sub != _market_subscriptions.end()) {
-         queue[market].emplace_back(full_object ? obj->to_variant() : fc::variant(obj->id, 1));
-      }
-   }
+   /// Registers with the subscription index on the first subscription
+   uint64_t subscriber_id();
 
    void broadcast_updates(const vector<variant> &updates);
    void broadcast_market_updates(const market_queue_type &queue);
-   void handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts, std::function<const object *(object_id_type id)> find_object);
 
-   /** called every time a block is applied to report the objects that were changed */
-   void on_objects_new(const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts);
-   void on_objects_changed(const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts);
-   void on_objects_removed(const vector<object_id_type> &ids, const vector<const object *> &objs, const flat_set<account_id_type> &impacted_accounts);
+   /** called every time a block is applied with the changed objects this connection is subscribed to */
+   void on_object_updates(const vector<variant> &updates) override;
+   void on_market_updates(const subscription_index::market_updates &updates) override;
    void on_applied_block();
 
-   bool _notify_remove_create = false;
-   mutable fc::bloom_filter _subscribe_filter;
-   std::set<account_id_type> _subscribed_accounts;
    std::function<void(const fc::variant &)> _subscribe_callback;
    std::function<void(const fc::variant &)> _pending_trx_callback;
    std::function<void(const fc::variant &)> _block_applied_callback;
 
-   boost::signals2::scoped_connection _new_connection;
-   boost::signals2::scoped_connection _change_connection;
-   boost::signals2::scoped_connection _removed_connection;
+   std::shared_ptr<subscription_index> _subscriptions;
+   uint64_t _subscriber_id = 0;
    boost::signals2::scoped_connection _applied_block_connection;
    boost::signals2::scoped_connection _pending_trx_connection;
    map<pair<asset_id_type, asset_id_type>, std::function<void(const variant &)>> _market_subscriptions;
@@ -399,17 +385,9 @@ database_api::~database_api() {
 }
 
 database_api_impl::database_api_impl(graphene::chain::database &db) :
-      _db(db) {
+      _db(db),
+      _subscriptions(subscription_index::for_database(db)) {
    wlog("creating database api ${x}", ("x", int64_t(this)));
-   _new_connection = _db.new_objects.connect([this](const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts) {
-      on_objects_new(ids, impacted_accounts);
-   });
-   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts) {
-      on_objects_changed(ids, impacted_accounts);
-   });
-   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type> &ids, const vector<const object *> &objs, const flat_set<account_id_type> &impacted_accounts) {
-      on_objects_removed(ids, objs, impacted_accounts);
-   });
    _applied_block_connection = _db.applied_block.connect([this](const signed_block &) {
       on_applied_block();
    });
@@ -422,6 +400,15 @@ database_api_impl::database_api_impl(graphene::chain::database &db) :
 
 database_api_impl::~database_api_impl() {
    elog("freeing database api ${x}", ("x", int64_t(this)));
+   if (_subscriber_id)
+      _subscriptions->remove_subscriber(_subscriber_id);
+}
+
+uint64_t database_api_impl::subscriber_id() {
+   if (!_subscriber_id)
+      _subscriber_id = _subscriptions->add_subscriber(
+            std::static_pointer_cast<subscription_index::subscriber>(shared_from_this()));
+   return _subscriber_id;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -472,15 +459,7 @@ void database_api::set_subscribe_callback(std::function<void(const variant &)> c
 void database_api_impl::set_subscribe_callback(std::function<void(const variant &)> cb, bool notify_remove_create) {
    //edump((clear_filter));
    _subscribe_callback = cb;
-   _notify_remove_create = notify_remove_create;
-   _subscribed_accounts.clear();
-
-   static fc::bloom_parameters param;
-   param.projected_element_count = 10000;
-   param.false_positive_probability = 1.0 / 100;
-   param.maximum_size = 1024 * 8 * 8 * 2;
-   param.compute_optimal_parameters();
-   _subscribe_filter = fc::bloom_filter(param);
+   _subscriptions->set_object_updates(subscriber_id(), bool(cb), notify_remove_create);
 }
 
 void database_api::set_pending_transaction_callback(std::function<void(const variant &)> cb) {
@@ -505,6 +484,8 @@ void database_api::cancel_all_subscriptions() {
 
 void database_api_impl::cancel_all_subscriptions() {
    set_subscribe_callback(std::function<void(const fc::variant &)>(), true);
+   for (const auto &item : _market_subscriptions)
+      _subscriptions->unsubscribe_from_market(_subscriber_id, item.first);
    _market_subscriptions.clear();
 }
 
@@ -662,6 +643,14 @@ global_betting_statistics_object database_api_impl::get_global_betting_statistic
    return _db.get(global_betting_statistics_id_type());
 }
 
+apply_metrics_report database_api::get_apply_metrics() const {
+   return my->get_apply_metrics();
+}
+
+apply_metrics_report database_api_impl::get_apply_metrics() const {
+   return _db.get_apply_metrics().report();
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Keys                                                             //
@@ -785,7 +774,10 @@ vector<optional<account_object>> database_api_impl::get_accounts(const vector<st
 }
 
 std::map<string, full_account> database_api::get_full_accounts(const vector<string> &names_or_ids, bool subscribe) {
-   return my->get_full_accounts(names_or_ids, subscribe);
+   // subscribing changes the subscriptions, which only the calling thread may touch
+   if (subscribe)
+      return my->get_full_accounts(names_or_ids, subscribe);
+   return read_only(my->_db, [&]() { return my->get_full_accounts(names_or_ids, subscribe); });
 }
 
 std::map<std::string, full_account> database_api_impl::get_full_accounts(const vector<std::string> &names_or_ids, bool subscribe) {
@@ -796,6 +788,8 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts(const v
    std::map<std::string, full_account> results;
 
    for (const std::string &account_name_or_id : names_or_ids) {
+      // on a read thread, gives way to the chain thread between accounts
+      _db.check_read_preemption();
       const account_object *account = nullptr;
       if (std::isdigit(account_name_or_id[0]))
          account = _db.find(fc::variant(account_name_or_id, 1).as<account_id_type>(1));
@@ -809,8 +803,8 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts(const v
          continue;
 
       if (subscribe) {
-         FC_ASSERT(std::distance(_subscribed_accounts.begin(), _subscribed_accounts.end()) <= 100);
-         _subscribed_accounts.insert(account->get_id());
+         FC_ASSERT(_subscriptions->account_subscription_count(subscriber_id()) <= 100);
+         _subscriptions->subscribe_to_account(subscriber_id(), account->get_id());
          subscribe_to_item(account->id);
       }
 
@@ -971,7 +965,7 @@ uint64_t database_api_impl::get_account_count() const {
 //////////////////////////////////////////////////////////////////////
 
 vector<asset> database_api::get_account_balances(const std::string &account_name_or_id, const flat_set<asset_id_type> &assets) const {
-   return my->get_account_balances(account_name_or_id, assets);
+   return read_only(my->_db, [&]() { return my->get_account_balances(account_name_or_id, assets); });
 }
 
 vector<asset> database_api_impl::get_account_balances(const std::string &account_name_or_id,
@@ -983,8 +977,10 @@ vector<asset> database_api_impl::get_account_balances(const std::string &account
       // if the caller passes in an empty list of assets, return balances for all assets the account owns
       const auto &balance_index = _db.get_index_type<primary_index<account_balance_index>>();
       const auto &balances = balance_index.get_secondary_index<balances_by_account_index>().get_account_balances(acnt);
-      for (const auto balance : balances)
+      for (const auto balance : balances) {
+         _db.check_read_preemption();
          result.push_back(balance.second->get_balance());
+      }
    } else {
       result.reserve(assets.size());
 
@@ -998,7 +994,7 @@ vector<asset> database_api_impl::get_account_balances(const std::string &account
 }
 
 vector<asset> database_api::get_named_account_balances(const std::string &name, const flat_set<asset_id_type> &assets) const {
-   return my->get_account_balances(name, assets);
+   return read_only(my->_db, [&]() { return my->get_account_balances(name, assets); });
 }
 
 vector<balance_object> database_api::get_balance_objects(const vector<address> &addrs) const {
@@ -1026,7 +1022,7 @@ vector<balance_object> database_api_impl::get_balance_objects(const vector<addre
 }
 
 vector<asset> database_api::get_vested_balances(const vector<balance_id_type> &objs) const {
-   return my->get_vested_balances(objs);
+   return read_only(my->_db, [&]() { return my->get_vested_balances(objs); });
 }
 
 vector<asset> database_api_impl::get_vested_balances(const vector<balance_id_type> &objs) const {
@@ -1034,15 +1030,17 @@ vector<asset> database_api_impl::get_vested_balances(const vector<balance_id_typ
       vector<asset> result;
       result.reserve(objs.size());
       auto now = _db.head_block_time();
-      for (auto obj : objs)
+      for (auto obj : objs) {
+         _db.check_read_preemption();
          result.push_back(obj(_db).available(now));
+      }
       return result;
    }
    FC_CAPTURE_AND_RETHROW((objs))
 }
 
 vector<vesting_balance_object> database_api::get_vesting_balances(const std::string account_id_or_name) const {
-   return my->get_vesting_balances(account_id_or_name);
+   return read_only(my->_db, [&]() { return my->get_vesting_balances(account_id_or_name); });
 }
 
 vector<vesting_balance_object> database_api_impl::get_vesting_balances(const std::string account_id_or_name) const {
@@ -1121,7 +1119,7 @@ vector<optional<asset_object>> database_api_impl::get_assets(const vector<asset_
 }
 
 vector<asset_object> database_api::list_assets(const string &lower_bound_symbol, uint32_t limit) const {
-   return my->list_assets(lower_bound_symbol, limit);
+   return read_only(my->_db, [&]() { return my->list_assets(lower_bound_symbol, limit); });
 }
 
 vector<asset_object> database_api_impl::list_assets(const string &lower_bound_symbol, uint32_t limit) const {
@@ -1144,7 +1142,7 @@ vector<asset_object> database_api_impl::list_assets(const string &lower_bound_sy
 }
 
 vector<optional<asset_object>> database_api::lookup_asset_symbols(const vector<string> &symbols_or_ids) const {
-   return my->lookup_asset_symbols(symbols_or_ids);
+   return read_only(my->_db, [&]() { return my->lookup_asset_symbols(symbols_or_ids); });
 }
 
 vector<optional<asset_object>> database_api_impl::lookup_asset_symbols(const vector<string> &symbols_or_ids) const {
@@ -1329,7 +1327,7 @@ vector<bet_object> database_api_impl::get_all_unmatched_bets_for_bettor(account_
 //////////////////////////////////////////////////////////////////////
 
 vector<limit_order_object> database_api::get_limit_orders(const std::string &a, const std::string &b, const uint32_t limit) const {
-   return my->get_limit_orders(a, b, limit);
+   return read_only(my->_db, [&]() { return my->get_limit_orders(a, b, limit); });
 }
 
 /**
@@ -1371,7 +1369,7 @@ vector<limit_order_object> database_api_impl::get_limit_orders(const asset_id_ty
 }
 
 vector<call_order_object> database_api::get_call_orders(const std::string &a, uint32_t limit) const {
-   return my->get_call_orders(a, limit);
+   return read_only(my->_db, [&]() { return my->get_call_orders(a, limit); });
 }
 
 vector<call_order_object> database_api_impl::get_call_orders(const std::string &a, uint32_t limit) const {
@@ -1384,7 +1382,7 @@ vector<call_order_object> database_api_impl::get_call_orders(const std::string &
 }
 
 vector<force_settlement_object> database_api::get_settle_orders(const std::string &a, uint32_t limit) const {
-   return my->get_settle_orders(a, limit);
+   return read_only(my->_db, [&]() { return my->get_settle_orders(a, limit); });
 }
 
 vector<force_settlement_object> database_api_impl::get_settle_orders(const std::string &a, uint32_t limit) const {
@@ -1395,7 +1393,7 @@ vector<force_settlement_object> database_api_impl::get_settle_orders(const std::
 }
 
 vector<call_order_object> database_api::get_margin_positions(const std::string account_id_or_name) const {
-   return my->get_margin_positions(account_id_or_name);
+   return read_only(my->_db, [&]() { return my->get_margin_positions(account_id_or_name); });
 }
 
 vector<call_order_object> database_api_impl::get_margin_positions(const std::string account_id_or_name) const {
@@ -1407,6 +1405,7 @@ vector<call_order_object> database_api_impl::get_margin_positions(const std::str
       auto end = aidx.lower_bound(boost::make_tuple(id + 1, asset_id_type(0)));
       vector<call_order_object> result;
       while (start != end) {
+         _db.check_read_preemption();
          result.push_back(*start);
          ++start;
       }
@@ -1427,6 +1426,7 @@ void database_api_impl::subscribe_to_market(std::function<void(const variant &)>
       std::swap(asset_a_id, asset_b_id);
    FC_ASSERT(asset_a_id != asset_b_id);
    _market_subscriptions[std::make_pair(asset_a_id, asset_b_id)] = callback;
+   _subscriptions->subscribe_to_market(subscriber_id(), std::make_pair(asset_a_id, asset_b_id));
 }
 
 void database_api::unsubscribe_from_market(const std::string &a, const std::string &b) {
@@ -1441,10 +1441,12 @@ void database_api_impl::unsubscribe_from_market(const std::string &a, const std:
       std::swap(asset_a_id, asset_b_id);
    FC_ASSERT(asset_a_id != asset_b_id);
    _market_subscriptions.erase(std::make_pair(asset_a_id, asset_b_id));
+   if (_subscriber_id)
+      _subscriptions->unsubscribe_from_market(_subscriber_id, std::make_pair(asset_a_id, asset_b_id));
 }
 
 market_ticker database_api::get_ticker(const string &base, const string &quote) const {
-   return my->get_ticker(base, quote);
+   return read_only(my->_db, [&]() { return my->get_ticker(base, quote); });
 }
 
 market_ticker database_api_impl::get_ticker(const string &base, const string &quote) const {
@@ -1463,32 +1465,29 @@ market_ticker database_api_impl::get_ticker(const string &base, const string &qu
    result.quote_volume = 0;
 
    try {
-      const fc::time_point_sec now = fc::time_point::now();
-      const fc::time_point_sec yesterday = fc::time_point_sec(now.sec_since_epoch() - 86400);
-      const auto batch_size = 100;
-
-      vector<market_trade> trades = get_trade_history(base, quote, now, yesterday, batch_size);
-      if (!trades.empty()) {
-         result.latest = trades[0].price;
-
-         while (!trades.empty()) {
-            for (const market_trade &t : trades) {
-               result.base_volume += t.value;
-               result.quote_volume += t.amount;
-            }
-
-            trades = get_trade_history(base, quote, trades.back().date, yesterday, batch_size);
-         }
-
-         const auto last_trade_yesterday = get_trade_history(base, quote, yesterday, fc::time_point_sec(), 1);
-         if (!last_trade_yesterday.empty()) {
-            const auto price_yesterday = last_trade_yesterday[0].price;
-            result.percent_change = ((result.latest / price_yesterday) - 1) * 100;
-         }
-      } else {
-         const auto last_trade = get_trade_history(base, quote, now, fc::time_point_sec(), 1);
-         if (!last_trade.empty())
-            result.latest = last_trade[0].price;
+      const auto base_id = assets[0]->id;
+      const auto quote_id = assets[1]->id;
+      const auto &ticker_idx = _db.get_index_type<graphene::market_history::market_ticker_index>().indices().get<graphene::market_history::by_market>();
+      const auto ticker_itr = ticker_idx.find(boost::make_tuple(std::min(base_id, quote_id), std::max(base_id, quote_id)));
+      if (ticker_itr != ticker_idx.end()) {
+         const auto &ticker = *ticker_itr;
+         const bool inverted = ticker.base != base_id;
+
+         auto asset_to_real = [](const share_type a, int p) {
+            return double(a.value) / pow(10, p);
+         };
+         //! Converts amounts of the ticker's base and quote asset to a price in units of the requested base per quote
+         auto price_to_real = [&](const share_type ticker_base, const share_type ticker_quote) {
+            const share_type b = inverted ? ticker_quote : ticker_base;
+            const share_type q = inverted ? ticker_base : ticker_quote;
+            return asset_to_real(b, assets[0]->precision) / asset_to_real(q, assets[1]->precision);
+         };
+
+         result.latest = price_to_real(ticker.latest_base, ticker.latest_quote);
+         result.base_volume = asset_to_real(inverted ? ticker.quote_volume : ticker.base_volume, assets[0]->precision);
+         result.quote_volume = asset_to_real(inverted ? ticker.base_volume : ticker.quote_volume, assets[1]->precision);
+         if (ticker.base_volume > 0 && ticker.last_day_base > 0)
+            result.percent_change = ((result.latest / price_to_real(ticker.last_day_base, ticker.last_day_quote)) - 1) * 100;
       }
 
       const auto orders = get_order_book(base, quote, 1);
@@ -1503,7 +1502,7 @@ market_ticker database_api_impl::get_ticker(const string &base, const string &qu
 }
 
 market_volume database_api::get_24_volume(const string &base, const string &quote) const {
-   return my->get_24_volume(base, quote);
+   return read_only(my->_db, [&]() { return my->get_24_volume(base, quote); });
 }
 
 market_volume database_api_impl::get_24_volume(const string &base, const string &quote) const {
@@ -1519,7 +1518,7 @@ market_volume database_api_impl::get_24_volume(const string &base, const string
 }
 
 order_book database_api::get_order_book(const string &base, const string &quote, unsigned limit) const {
-   return my->get_order_book(base, quote, limit);
+   return read_only(my->_db, [&]() { return my->get_order_book(base, quote, limit); });
 }
 
 order_book database_api_impl::get_order_book(const string &base, const string &quote, unsigned limit) const {
@@ -1574,7 +1573,7 @@ vector<market_trade> database_api::get_trade_history(const string &base,
                                                      fc::time_point_sec start,
                                                      fc::time_point_sec stop,
                                                      unsigned limit) const {
-   return my->get_trade_history(base, quote, start, stop, limit);
+   return read_only(my->_db, [&]() { return my->get_trade_history(base, quote, start, stop, limit); });
 }
 
 vector<market_trade> database_api_impl::get_trade_history(const string &base,
@@ -1613,6 +1612,7 @@ vector<market_trade> database_api_impl::get_trade_history(const string &base,
    vector<market_trade> result;
 
    while (itr != history_idx.end() && count < limit && !(itr->key.base != base_id || itr->key.quote != quote_id || itr->time < stop)) {
+      _db.check_read_preemption();
       if (itr->time < start) {
          market_trade trade;
 
@@ -2175,6 +2175,10 @@ vector<account_object> database_api::get_voters_by_id(const vote_id_type &vote_i
    return my->get_voters_by_id(vote_id);
 }
 
+vector<account_object> database_api::list_voters_by_id(const vote_id_type &vote_id, const account_id_type lower_id, uint32_t limit) const {
+   return my->list_voters_by_id(vote_id, lower_id, limit);
+}
+
 voters_info database_api::get_voters(const string &account_name_or_id) const {
    return my->get_voters(account_name_or_id);
 }
@@ -2351,15 +2355,39 @@ votes_info database_api_impl::get_votes(const string &account_name_or_id) const
    return result;
 }
 
+const set<account_id_type> &database_api_impl::get_voter_ids(const vote_id_type &vote_id) const {
+   static const set<account_id_type> no_voters;
+
+   const auto &account_idx = _db.get_index_type<graphene::chain::account_index>();
+   const auto &votes = account_idx.get_secondary_index<graphene::chain::account_vote_index>();
+   auto itr = votes.vote_to_voters.find(vote_id);
+   if (itr == votes.vote_to_voters.end())
+      return no_voters;
+   return itr->second;
+}
+
 vector<account_object> database_api_impl::get_voters_by_id(const vote_id_type &vote_id) const {
+   const auto &voter_ids = get_voter_ids(vote_id);
+
    vector<account_object> result;
+   result.reserve(voter_ids.size());
+   for (const auto &voter_id : voter_ids)
+      result.emplace_back(voter_id(_db));
 
-   //! We search all accounts that have voted for this vote_id
-   const auto &account_index = _db.get_index_type<graphene::chain::account_index>().indices().get<by_id>();
-   for (const auto &account : account_index) {
-      if (account.options.votes.count(vote_id) != 0)
-         result.emplace_back(account);
-   }
+   return result;
+}
+
+vector<account_object> database_api_impl::list_voters_by_id(const vote_id_type &vote_id, const account_id_type lower_id, uint32_t limit) const {
+   FC_ASSERT(limit <= api_limit_list_voters_by_id,
+             "Number of queried voters can not be greater than ${configured_limit}",
+             ("configured_limit", api_limit_list_voters_by_id));
+
+   const auto &voter_ids = get_voter_ids(vote_id);
+
+   vector<account_object> result;
+   result.reserve(std::min<size_t>(limit, voter_ids.size()));
+   for (auto itr = voter_ids.lower_bound(lower_id); limit-- && itr != voter_ids.end(); ++itr)
+      result.emplace_back((*itr)(_db));
 
    return result;
 }
@@ -2466,25 +2494,19 @@ voters_info database_api_impl::get_voters(const string &account_name_or_id) cons
 
    //! Info for committee member voters
    if (committee_member_object) {
-      const auto &committee_member_voters = get_voters_by_id(committee_member_object->vote_id);
+      const auto &committee_member_voters = get_voter_ids(committee_member_object->vote_id);
       voters_info_object voters_for_committee_member;
       voters_for_committee_member.vote_id = committee_member_object->vote_id;
-      voters_for_committee_member.voters.reserve(committee_member_voters.size());
-      for (const auto &voter : committee_member_voters) {
-         voters_for_committee_member.voters.emplace_back(voter.get_id());
-      }
+      voters_for_committee_member.voters.assign(committee_member_voters.begin(), committee_member_voters.end());
       result.voters_for_committee_member = std::move(voters_for_committee_member);
    }
 
    //! Info for witness voters
    if (witness_object) {
-      const auto &witness_voters = get_voters_by_id(witness_object->vote_id);
+      const auto &witness_voters = get_voter_ids(witness_object->vote_id);
       voters_info_object voters_for_witness;
       voters_for_witness.vote_id = witness_object->vote_id;
-      voters_for_witness.voters.reserve(witness_voters.size());
-      for (const auto &voter : witness_voters) {
-         voters_for_witness.voters.emplace_back(voter.get_id());
-      }
+      voters_for_witness.voters.assign(witness_voters.begin(), witness_voters.end());
       result.voters_for_witness = std::move(voters_for_witness);
    }
 
@@ -2494,21 +2516,15 @@ voters_info database_api_impl::get_voters(const string &account_name_or_id) cons
       vector<voters_info_object> voters_against_workers(worker_objects.size());
       for (const auto &worker_object : worker_objects) {
          voters_info_object voters_for_worker;
-         const auto &for_worker_voters = get_voters_by_id(worker_object.vote_for);
+         const auto &for_worker_voters = get_voter_ids(worker_object.vote_for);
          voters_for_worker.vote_id = worker_object.vote_for;
-         voters_for_worker.voters.reserve(for_worker_voters.size());
-         for (const auto &voter : for_worker_voters) {
-            voters_for_worker.voters.emplace_back(voter.get_id());
-         }
+         voters_for_worker.voters.assign(for_worker_voters.begin(), for_worker_voters.end());
          voters_for_workers.emplace_back(std::move(voters_for_worker));
 
          voters_info_object voters_against_worker;
-         const auto &against_worker_voters = get_voters_by_id(worker_object.vote_against);
+         const auto &against_worker_voters = get_voter_ids(worker_object.vote_against);
          voters_against_worker.vote_id = worker_object.vote_against;
-         voters_against_worker.voters.reserve(against_worker_voters.size());
-         for (const auto &voter : against_worker_voters) {
-            voters_against_worker.voters.emplace_back(voter.get_id());
-         }
+         voters_against_worker.voters.assign(against_worker_voters.begin(), against_worker_voters.end());
          voters_against_workers.emplace_back(std::move(voters_against_worker));
       }
       result.voters_for_workers = std::move(voters_for_workers);
@@ -2519,13 +2535,10 @@ voters_info database_api_impl::get_voters(const string &account_name_or_id) cons
    if (son_object) {
       flat_map<sidechain_type, voters_info_object> voters_for_son;
       for (const auto &vote_id : son_object->sidechain_vote_ids) {
-         const auto &son_voters = get_voters_by_id(vote_id.second);
+         const auto &son_voters = get_voter_ids(vote_id.second);
          voters_info_object voters_for_sidechain_son;
          voters_for_sidechain_son.vote_id = vote_id.second;
-         voters_for_sidechain_son.voters.reserve(son_voters.size());
-         for (const auto &voter : son_voters) {
-            voters_for_sidechain_son.voters.emplace_back(voter.get_id());
-         }
+         voters_for_sidechain_son.voters.assign(son_voters.begin(), son_voters.end());
          voters_for_son[vote_id.first] = std::move(voters_for_sidechain_son);
       }
       result.voters_for_son = std::move(voters_for_son);
@@ -3499,71 +3512,12 @@ void database_api_impl::broadcast_market_updates(const market_queue_type &queue)
    }
 }
 
-void database_api_impl::on_objects_removed(const vector<object_id_type> &ids, const vector<const object *> &objs, const flat_set<account_id_type> &impacted_accounts) {
-   handle_object_changed(_notify_remove_create, false, ids, impacted_accounts,
-                         [objs](object_id_type id) -> const object * {
-                            auto it = std::find_if(
-                                  objs.begin(), objs.end(),
-                                  [id](const object *o) {
-                                     return o != nullptr && o->id == id;
-                                  });
-
-                            if (it != objs.end())
-                               return *it;
-
-                            return nullptr;
-                         });
-}
-
-void database_api_impl::on_objects_new(const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts) {
-   handle_object_changed(_notify_remove_create, true, ids, impacted_accounts,
-                         std::bind(&object_database::find_object, &_db, std::placeholders::_1));
+void database_api_impl::on_object_updates(const vector<variant> &updates) {
+   broadcast_updates(updates);
 }
 
-void database_api_impl::on_objects_changed(const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts) {
-   handle_object_changed(false, true, ids, impacted_accounts,
-                         std::bind(&object_database::find_object, &_db, std::placeholders::_1));
-}
-
-void database_api_impl::handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts, std::function<const object *(object_id_type id)> find_object) {
-   if (_subscribe_callback) {
-      vector<variant> updates;
-
-      for (auto id : ids) {
-         if (force_notify || is_subscribed_to_item(id) || is_impacted_account(impacted_accounts)) {
-            if (full_object) {
-               auto obj = find_object(id);
-               if (obj) {
-                  updates.emplace_back(obj->to_variant());
-               }
-            } else {
-               updates.emplace_back(fc::variant(id, 1));
-            }
-         }
-      }
-
-      broadcast_updates(updates);
-   }
-
-   if (_market_subscriptions.size()) {
-      market_queue_type broadcast_queue;
-      /// pushing the future back / popping the prior future if it is complete.
-      /// if a connection hangs then this could get backed up and result in
-      /// a failure to exit cleanly.
-      //fc::async([capture_this,this,updates,market_broadcast_queue](){
-      //if( _subscribe_callback )
-      //         _subscribe_callback( updates );
-
-      for (auto id : ids) {
-         if (id.is<call_order_object>()) {
-            enqueue_if_subscribed_to_market<call_order_object>(find_object(id), broadcast_queue, full_object);
-         } else if (id.is<limit_order_object>()) {
-            enqueue_if_subscribed_to_market<limit_order_object>(find_object(id), broadcast_queue, full_object);
-         }
-      }
-
-      broadcast_market_updates(broadcast_queue);
-   }
+void database_api_impl::on_market_updates(const subscription_index::market_updates &updates) {
+   broadcast_market_updates(updates);
 }
 
 /** note: this method cannot yield because it is called in the middle of
@@ -141,6 +141,24 @@ public:
                                                                  unsigned limit = 100,
                                                                  uint32_t start = 0) const;
 
+   /**
+          * @brief Get only asked operations relevant to the specified account, referenced by the event
+          * numbering specific to the account as in get_relative_account_history
+          * @param account_id_or_name The account ID or name whose history should be queried
+          * @param operation_id The ID of the operation we want to get operations in the account( 0 = transfer , 1 = limit order create, ...)
+          * @param stop Sequence number of earliest operation. 0 is default and will
+          * query 'limit' number of operations.
+          * @param limit Maximum number of operations to retrieve (must not exceed 100)
+          * @param start Sequence number of the most recent operation to retrieve.
+          * 0 is default, which will start querying from the most recent operation.
+          * @return A list of operations performed by account, ordered from most recent to oldest.
+          */
+   vector<operation_history_object> get_relative_account_history_operations(const std::string account_id_or_name,
+                                                                            int operation_id,
+                                                                            uint32_t stop = 0,
+                                                                            unsigned limit = 100,
+                                                                            uint32_t start = 0) const;
+
    vector<order_history_object> get_fill_order_history(std::string asset_a, std::string asset_b, uint32_t limit) const;
    vector<bucket_object> get_market_history(std::string asset_a, std::string asset_b, uint32_t bucket_seconds,
                                             fc::time_point_sec start, fc::time_point_sec end) const;
@@ -419,6 +437,7 @@ FC_API(graphene::app::history_api,
       (get_account_history)
       (get_account_history_operations)
       (get_relative_account_history)
+      (get_relative_account_history_operations)
       (get_fill_order_history)
       (get_market_history)
       (get_market_history_buckets)
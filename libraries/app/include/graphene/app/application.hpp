@@ -83,6 +83,10 @@ public:
 
    net::node_ptr p2p_node();
    std::shared_ptr<chain::database> chain_database() const;
+   /// The data directory passed to initialize(), the chain database lives in its "blockchain" subdirectory
+   fc::path data_dir() const;
+   /// The chain id of the configured genesis state, available before startup() opens the chain database
+   chain::chain_id_type genesis_chain_id() const;
 
    void set_block_production(bool producing_blocks);
    fc::optional<api_access_info> get_api_access_info(const string &username) const;
@@ -272,6 +272,13 @@ public:
     */
    dynamic_global_property_object get_dynamic_global_properties() const;
 
+   /**
+    * @brief Retrieve per-operation-type and per-block-phase apply latencies of this node
+    *
+    * Only collected while the node runs with the apply-metrics option.
+    */
+   apply_metrics_report get_apply_metrics() const;
+
    //////////
    // Keys //
    //////////
@@ -860,6 +867,16 @@ public:
     */
    vector<account_object> get_voters_by_id(const vote_id_type &vote_id) const;
 
+   /**
+    * @brief Get a page of the accounts that vote for vote_id, ordered by account ID
+    * @param vote_id We search accounts that vote for this ID
+    * @param lower_id ID of the first account to return, use the last returned ID plus one to fetch the next page
+    * @param limit Maximum number of results to return -- must not exceed 1000
+    * @return The accounts that vote for provided ID, starting at lower_id
+    *
+    */
+   vector<account_object> list_voters_by_id(const vote_id_type &vote_id, const account_id_type lower_id, uint32_t limit) const;
+
    /**
     * @brief Return the accounts that votes for account_name_or_id
     * @param account_name_or_id ID or name of the account to get voters for
@@ -1127,6 +1144,7 @@ FC_API(graphene::app::database_api,
    (get_config)
    (get_chain_id)
    (get_dynamic_global_properties)
+   (get_apply_metrics)
 
    // Keys
    (get_key_references)
@@ -1234,6 +1252,7 @@ FC_API(graphene::app::database_api,
    (get_votes_ids)
    (get_votes)
    (get_voters_by_id)
+   (list_voters_by_id)
    (get_voters)
 
    // Authority / validation
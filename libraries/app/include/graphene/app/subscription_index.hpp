@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/variant.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace graphene { namespace app {
+
+   using graphene::chain::account_id_type;
+   using graphene::chain::asset_id_type;
+   using graphene::db::object_id_type;
+
+   /**
+    *  @brief The object and market subscriptions of all database API connections to one database
+    *
+    *  Subscriptions are indexed by what they subscribe to, so that the objects changed by a block are looked up once
+    *  instead of being tested against every connection.  Each changed object is serialized at most once and the
+    *  result is shared by all connections receiving it.
+    *
+    *  Subscriptions may be changed from any thread, updates are delivered on the thread applying blocks.
+    */
+   class subscription_index
+   {
+      public:
+         typedef std::pair<asset_id_type, asset_id_type>          market_type;
+         typedef std::map<market_type, std::vector<fc::variant>>  market_updates;
+
+         /// Receives the updates of one connection, once per block
+         class subscriber
+         {
+            public:
+               virtual ~subscriber() {}
+               virtual void on_object_updates( const std::vector<fc::variant>& updates ) = 0;
+               virtual void on_market_updates( const market_updates& updates ) = 0;
+         };
+
+         /// Connections subscribed to more objects than this receive all changed objects instead
+         static const size_t max_objects_per_subscriber = 100000;
+
+         explicit subscription_index( graphene::chain::database& db );
+         ~subscription_index();
+
+         /// Returns the index shared by the connections to @ref db, creating it if there is none
+         static std::shared_ptr<subscription_index> for_database( graphene::chain::database& db );
+
+         /// Registers @ref s, which is dropped once it expires, and returns the id identifying it in the other calls
+         uint64_t add_subscriber( const std::weak_ptr<subscriber>& s );
+         void     remove_subscriber( uint64_t id );
+
+         /**
+          *  Enables or disables object updates for the subscriber, clearing its object and account subscriptions.
+          *  With @ref notify_remove_create it receives every created and removed object.
+          */
+         void set_object_updates( uint64_t id, bool enabled, bool notify_remove_create );
+         void subscribe_to_object( uint64_t id, object_id_type object );
+         bool is_subscribed_to_object( uint64_t id, object_id_type object )const;
+         /// Subscribes to every object changed in a block which impacts @ref account
+         void subscribe_to_account( uint64_t id, account_id_type account );
+         size_t account_subscription_count( uint64_t id )const;
+         void subscribe_to_market( uint64_t id, const market_type& market );
+         void unsubscribe_from_market( uint64_t id, const market_type& market );
+
+      private:
+         struct subscriber_state
+         {
+            std::weak_ptr<subscriber>       target;
+            bool                            object_updates = false;
+            bool                            notify_remove_create = false;
+            /// Set when the subscriber has more than max_objects_per_subscriber objects
+            bool                            all_objects = false;
+            std::unordered_set<uint64_t>    objects;
+            flat_set<account_id_type>       accounts;
+            flat_set<market_type>           markets;
+         };
+
+         /// Updates of one subscriber for one block
+         struct pending_updates
+         {
+            std::shared_ptr<subscriber>     target;
+            std::vector<fc::variant>        objects;
+            market_updates                  markets;
+         };
+
+         void on_object_changes( const graphene::chain::object_changes& changes );
+         void clear_objects( uint64_t id, subscriber_state& state );
+         void update_filter();
+
+         graphene::chain::database&                               _db;
+         uint64_t                                                 _object_changes_subscription = 0;
+
+         mutable std::mutex                                       _mutex;
+         uint64_t                                                 _next_subscriber = 1;
+         std::map<uint64_t, subscriber_state>                     _subscribers;
+         std::unordered_map<uint64_t, flat_set<uint64_t>>         _by_object;
+         std::map<account_id_type, flat_set<uint64_t>>            _by_account;
+         std::map<market_type, flat_set<uint64_t>>                _by_market;
+         /// Subscribers with object updates enabled
+         size_t                                                   _object_subscribers = 0;
+         /// Subscribers receiving every changed object, or every created and removed one
+         flat_set<uint64_t>                                       _all_objects_subscribers;
+         flat_set<uint64_t>                                       _remove_create_subscribers;
+   };
+
+} }
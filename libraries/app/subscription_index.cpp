@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/subscription_index.hpp>
+
+#include <graphene/chain/market_object.hpp>
+
+namespace graphene { namespace app {
+
+using graphene::chain::call_order_object;
+using graphene::chain::limit_order_object;
+using graphene::chain::object_change_filter;
+using graphene::chain::object_changes;
+using graphene::db::object;
+
+subscription_index::subscription_index( graphene::chain::database& db ) : _db( db )
+{
+   object_change_filter filter;
+   filter.enabled = false;
+   _object_changes_subscription = _db.subscribe_object_changes( filter, [this]( const object_changes& changes ) {
+      on_object_changes( changes );
+   });
+}
+
+subscription_index::~subscription_index()
+{
+   _db.unsubscribe_object_changes( _object_changes_subscription );
+}
+
+std::shared_ptr<subscription_index> subscription_index::for_database( graphene::chain::database& db )
+{
+   static std::mutex registry_mutex;
+   static std::map< const graphene::chain::database*, std::weak_ptr<subscription_index> > registry;
+
+   std::lock_guard<std::mutex> guard( registry_mutex );
+   for( auto itr = registry.begin(); itr != registry.end(); )
+   {
+      if( itr->second.expired() )
+         itr = registry.erase( itr );
+      else
+         ++itr;
+   }
+   std::weak_ptr<subscription_index>& entry = registry[&db];
+   std::shared_ptr<subscription_index> result = entry.lock();
+   if( !result )
+   {
+      result = std::make_shared<subscription_index>( db );
+      entry = result;
+   }
+   return result;
+}
+
+uint64_t subscription_index::add_subscriber( const std::weak_ptr<subscriber>& s )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   const uint64_t id = _next_subscriber++;
+   _subscribers[id].target = s;
+   return id;
+}
+
+void subscription_index::remove_subscriber( uint64_t id )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( id );
+   if( itr == _subscribers.end() )
+      return;
+   subscriber_state& state = itr->second;
+   clear_objects( id, state );
+   for( const auto& account : state.accounts )
+   {
+      auto& subscribers = _by_account[account];
+      subscribers.erase( id );
+      if( subscribers.empty() )
+         _by_account.erase( account );
+   }
+   for( const auto& market : state.markets )
+   {
+      auto& subscribers = _by_market[market];
+      subscribers.erase( id );
+      if( subscribers.empty() )
+         _by_market.erase( market );
+   }
+   if( state.object_updates )
+      --_object_subscribers;
+   _remove_create_subscribers.erase( id );
+   _subscribers.erase( itr );
+   update_filter();
+}
+
+void subscription_index::clear_objects( uint64_t id, subscriber_state& state )
+{
+   for( uint64_t object : state.objects )
+   {
+      auto itr = _by_object.find( object );
+      itr->second.erase( id );
+      if( itr->second.empty() )
+         _by_object.erase( itr );
+   }
+   state.objects.clear();
+   state.all_objects = false;
+   _all_objects_subscribers.erase( id );
+}
+
+void subscription_index::set_object_updates( uint64_t id, bool enabled, bool notify_remove_create )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( id );
+   FC_ASSERT( itr != _subscribers.end() );
+   subscriber_state& state = itr->second;
+
+   clear_objects( id, state );
+   for( const auto& account : state.accounts )
+   {
+      auto& subscribers = _by_account[account];
+      subscribers.erase( id );
+      if( subscribers.empty() )
+         _by_account.erase( account );
+   }
+   state.accounts.clear();
+
+   if( state.object_updates != enabled )
+   {
+      if( enabled )
+         ++_object_subscribers;
+      else
+         --_object_subscribers;
+   }
+   state.object_updates = enabled;
+   state.notify_remove_create = notify_remove_create;
+   if( enabled && notify_remove_create )
+      _remove_create_subscribers.insert( id );
+   else
+      _remove_create_subscribers.erase( id );
+   update_filter();
+}
+
+void subscription_index::subscribe_to_object( uint64_t id, object_id_type object )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( id );
+   if( itr == _subscribers.end() )
+      return;
+   subscriber_state& state = itr->second;
+   if( !state.object_updates || state.all_objects )
+      return;
+   if( !state.objects.insert( object.number ).second )
+      return;
+   _by_object[object.number].insert( id );
+
+   if( state.objects.size() > max_objects_per_subscriber )
+   {
+      clear_objects( id, state );
+      state.all_objects = true;
+      _all_objects_subscribers.insert( id );
+   }
+}
+
+bool subscription_index::is_subscribed_to_object( uint64_t id, object_id_type object )const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( id );
+   if( itr == _subscribers.end() || !itr->second.object_updates )
+      return false;
+   return itr->second.all_objects || itr->second.objects.count( object.number );
+}
+
+void subscription_index::subscribe_to_account( uint64_t id, account_id_type account )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( id );
+   if( itr == _subscribers.end() || !itr->second.object_updates )
+      return;
+   if( !itr->second.accounts.insert( account ).second )
+      return;
+   const bool first = _by_account.empty();
+   _by_account[account].insert( id );
+   if( first )
+      update_filter();
+}
+
+size_t subscription_index::account_subscription_count( uint64_t id )const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( id );
+   return itr == _subscribers.end() ? 0 : itr->second.accounts.size();
+}
+
+void subscription_index::subscribe_to_market( uint64_t id, const market_type& market )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( id );
+   FC_ASSERT( itr != _subscribers.end() );
+   if( !itr->second.markets.insert( market ).second )
+      return;
+   _by_market[market].insert( id );
+   update_filter();
+}
+
+void subscription_index::unsubscribe_from_market( uint64_t id, const market_type& market )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _subscribers.find( id );
+   if( itr == _subscribers.end() || !itr->second.markets.erase( market ) )
+      return;
+   auto& subscribers = _by_market[market];
+   subscribers.erase( id );
+   if( subscribers.empty() )
+      _by_market.erase( market );
+   update_filter();
+}
+
+void subscription_index::update_filter()
+{
+   object_change_filter filter;
+   filter.enabled = _object_subscribers > 0 || !_by_market.empty();
+   // without object subscribers only orders of subscribed markets are needed
+   if( _object_subscribers == 0 )
+      filter.add_type<call_order_object>().add_type<limit_order_object>();
+   filter.impacted_accounts = !_by_account.empty();
+   _db.set_object_change_filter( _object_changes_subscription, filter );
+}
+
+void subscription_index::on_object_changes( const object_changes& changes )
+{
+   std::map<uint64_t, pending_updates> pending;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+
+      auto pending_for = [&]( uint64_t id ) -> pending_updates* {
+         auto itr = pending.find( id );
+         if( itr != pending.end() )
+            return itr->second.target ? &itr->second : nullptr;
+         pending_updates& updates = pending[id];
+         auto state = _subscribers.find( id );
+         if( state != _subscribers.end() )
+            updates.target = state->second.target.lock();
+         return updates.target ? &updates : nullptr;
+      };
+
+      // Hands one kind of change to the subscribers, serializing each object at most once.  Subscribers receive
+      // all objects of the kind if it impacts one of their accounts, as the accounts impacted are only known for
+      // the block as a whole.
+      auto dispatch = [&]( const std::vector<object_id_type>& ids, const flat_set<account_id_type>& accounts,
+                           bool remove_or_create, bool full_object,
+                           const std::function<const object*( size_t )>& object_at )
+      {
+         flat_set<uint64_t> receive_all = _all_objects_subscribers;
+         if( remove_or_create )
+            receive_all.insert( _remove_create_subscribers.begin(), _remove_create_subscribers.end() );
+         if( !_by_account.empty() )
+            for( const auto& account : accounts )
+            {
+               auto itr = _by_account.find( account );
+               if( itr != _by_account.end() )
+                  receive_all.insert( itr->second.begin(), itr->second.end() );
+            }
+
+         for( size_t i = 0; i < ids.size(); ++i )
+         {
+            const object_id_type id = ids[i];
+            const bool order = id.is<call_order_object>() || id.is<limit_order_object>();
+            auto by_object = _by_object.find( id.number );
+            if( receive_all.empty() && by_object == _by_object.end() && ( !order || _by_market.empty() ) )
+               continue;
+
+            const object* obj = object_at( i );
+            if( full_object && obj == nullptr )
+               continue;
+            const fc::variant update = full_object ? obj->to_variant() : fc::variant( id, 1 );
+
+            for( uint64_t s : receive_all )
+               if( pending_updates* p = pending_for( s ) )
+                  p->objects.push_back( update );
+            if( by_object != _by_object.end() )
+               for( uint64_t s : by_object->second )
+                  if( !receive_all.count( s ) )
+                     if( pending_updates* p = pending_for( s ) )
+                        p->objects.push_back( update );
+
+            if( order && !_by_market.empty() && obj != nullptr )
+            {
+               const market_type market = id.is<call_order_object>()
+                     ? static_cast<const call_order_object*>( obj )->get_market()
+                     : static_cast<const limit_order_object*>( obj )->get_market();
+               auto by_market = _by_market.find( market );
+               if( by_market != _by_market.end() )
+                  for( uint64_t s : by_market->second )
+                     if( pending_updates* p = pending_for( s ) )
+                        p->markets[market].push_back( update );
+            }
+         }
+      };
+
+      auto find_object = [this]( const std::vector<object_id_type>& ids ) {
+         return [this, &ids]( size_t i ) { return _db.find_object( ids[i] ); };
+      };
+      dispatch( changes.new_ids, changes.new_accounts_impacted, true, true, find_object( changes.new_ids ) );
+      dispatch( changes.changed_ids, changes.changed_accounts_impacted, false, true, find_object( changes.changed_ids ) );
+      dispatch( changes.removed_ids, changes.removed_accounts_impacted, true, false,
+                [&changes]( size_t i ) { return changes.removed[i]; } );
+   }
+
+   for( auto& item : pending )
+   {
+      pending_updates& updates = item.second;
+      if( !updates.target )
+         continue;
+      if( !updates.objects.empty() )
+         updates.target->on_object_updates( updates.objects );
+      if( !updates.markets.empty() )
+         updates.target->on_market_updates( updates.markets );
+   }
+}
+
+} }
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/apply_metrics.hpp>
+#include <graphene/chain/protocol/operations.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+const char* const phase_names[] = {
+   "block",
+   "transactions",
+   "witness_schedule",
+   "update_global_dynamic_data",
+   "perform_chain_maintenance",
+   "check_ending_lotteries",
+   "place_delayed_bets",
+   "clear_expired_transactions",
+   "clear_expired_proposals",
+   "clear_expired_orders",
+   "update_expired_feeds",
+   "update_core_exchange_rates",
+   "update_withdraw_permissions",
+   "update_tournaments",
+   "update_betting_markets",
+   "finalize_expired_offers",
+   "notify_applied_block",
+   "notify_changed_objects"
+};
+static_assert( sizeof(phase_names) / sizeof(phase_names[0]) == size_t(apply_phase::phase_count),
+               "Every apply_phase needs a name" );
+
+const size_t phase_count = size_t(apply_phase::phase_count);
+
+struct operation_name_visitor
+{
+   typedef std::string result_type;
+
+   template<typename Operation>
+   std::string operator()( const Operation& )const
+   {
+      std::string name = fc::get_typename<Operation>::name();
+      auto pos = name.rfind( "::" );
+      return pos == std::string::npos ? name : name.substr( pos + 2 );
+   }
+};
+
+std::string operation_name( int which )
+{
+   operation op;
+   op.set_which( which );
+   operation_name_visitor visitor;
+   return op.visit( visitor );
+}
+
+std::atomic<uint64_t> next_instance_id( 1 );
+
+} // anonymous namespace
+
+size_t latency_histogram::bucket_of( uint64_t ns )
+{
+   if( ns < (uint64_t(1) << sub_bucket_bits) )
+      return size_t(ns);
+   uint32_t exponent = 63 - __builtin_clzll( ns );
+   if( exponent > max_exponent )
+      return bucket_count - 1;
+   uint64_t sub_bucket = ( ns >> (exponent - sub_bucket_bits) ) & ( (uint64_t(1) << sub_bucket_bits) - 1 );
+   return ( size_t(exponent - sub_bucket_bits + 1) << sub_bucket_bits ) + size_t(sub_bucket);
+}
+
+uint64_t latency_histogram::bucket_upper_bound( size_t bucket )
+{
+   const size_t sub_buckets = size_t(1) << sub_bucket_bits;
+   if( bucket < sub_buckets )
+      return bucket;
+   uint32_t exponent = uint32_t(bucket >> sub_bucket_bits) + sub_bucket_bits - 1;
+   uint64_t width = uint64_t(1) << (exponent - sub_bucket_bits);
+   uint64_t lower = ( sub_buckets + (bucket & (sub_buckets - 1)) ) * width;
+   return lower + width - 1;
+}
+
+void latency_histogram::record( uint64_t ns )
+{
+   ++_buckets[ bucket_of( ns ) ];
+   ++_count;
+   _total += ns;
+   _max = std::max( _max, ns );
+}
+
+void latency_histogram::merge( const latency_histogram& other )
+{
+   for( size_t i = 0; i < bucket_count; ++i )
+      _buckets[i] += other._buckets[i];
+   _count += other._count;
+   _total += other._total;
+   _max = std::max( _max, other._max );
+}
+
+uint64_t latency_histogram::percentile( double fraction )const
+{
+   if( _count == 0 )
+      return 0;
+   uint64_t rank = std::max<uint64_t>( 1, uint64_t( std::ceil( fraction * _count ) ) );
+   uint64_t seen = 0;
+   for( size_t i = 0; i < bucket_count; ++i )
+   {
+      seen += _buckets[i];
+      if( seen >= rank )
+         return std::min( bucket_upper_bound( i ), _max );
+   }
+   return _max;
+}
+
+apply_latency_stats latency_histogram::stats( std::string name )const
+{
+   apply_latency_stats result;
+   result.name     = std::move( name );
+   result.count    = _count;
+   result.total_ns = _total;
+   result.p50_ns   = percentile( 0.5 );
+   result.p99_ns   = percentile( 0.99 );
+   result.p999_ns  = percentile( 0.999 );
+   result.max_ns   = _max;
+   return result;
+}
+
+struct apply_metrics::shard
+{
+   std::mutex                                    mutex;
+   std::vector<latency_histogram>                operations;
+   std::array<latency_histogram, phase_count>    phases;
+};
+
+apply_metrics::apply_metrics() :
+   _instance_id( next_instance_id++ ),
+   _enabled( false )
+{
+}
+
+apply_metrics::~apply_metrics()
+{
+}
+
+apply_metrics::shard& apply_metrics::local_shard()
+{
+   // Shards are owned by the metrics object and never freed before it, ids are never reused so entries of
+   // destroyed objects are never looked up again
+   static thread_local std::vector< std::pair<uint64_t, shard*> > thread_shards;
+   for( const auto& entry : thread_shards )
+      if( entry.first == _instance_id )
+         return *entry.second;
+
+   std::unique_ptr<shard> created( new shard );
+   created->operations.resize( operation::count() );
+   shard* result = created.get();
+   {
+      std::lock_guard<std::mutex> guard( _shards_mutex );
+      _shards.push_back( std::move( created ) );
+   }
+   thread_shards.emplace_back( _instance_id, result );
+   return *result;
+}
+
+void apply_metrics::record_operation( int which, uint64_t ns )
+{
+   shard& s = local_shard();
+   std::lock_guard<std::mutex> guard( s.mutex );
+   if( size_t(which) >= s.operations.size() )
+      s.operations.resize( which + 1 );
+   s.operations[which].record( ns );
+}
+
+void apply_metrics::record_phase( apply_phase phase, uint64_t ns )
+{
+   shard& s = local_shard();
+   std::lock_guard<std::mutex> guard( s.mutex );
+   s.phases[ size_t(phase) ].record( ns );
+}
+
+apply_metrics_report apply_metrics::report()const
+{
+   std::vector<latency_histogram> operations;
+   std::array<latency_histogram, phase_count> phases;
+   {
+      std::lock_guard<std::mutex> guard( _shards_mutex );
+      for( const auto& s : _shards )
+      {
+         std::lock_guard<std::mutex> shard_guard( s->mutex );
+         if( operations.size() < s->operations.size() )
+            operations.resize( s->operations.size() );
+         for( size_t i = 0; i < s->operations.size(); ++i )
+            operations[i].merge( s->operations[i] );
+         for( size_t i = 0; i < phase_count; ++i )
+            phases[i].merge( s->phases[i] );
+      }
+   }
+
+   apply_metrics_report result;
+   result.enabled = enabled();
+   for( size_t i = 0; i < operations.size(); ++i )
+      if( operations[i].count() > 0 )
+         result.operations.push_back( operations[i].stats( operation_name( int(i) ) ) );
+   for( size_t i = 0; i < phase_count; ++i )
+      if( phases[i].count() > 0 )
+         result.phases.push_back( phases[i].stats( phase_names[i] ) );
+   return result;
+}
+
+void apply_metrics::log_report()const
+{
+   apply_metrics_report r = report();
+   std::sort( r.operations.begin(), r.operations.end(),
+              []( const apply_latency_stats& a, const apply_latency_stats& b ) { return a.total_ns > b.total_ns; } );
+   ilog( "Block phase latencies (count, total/p50/p99/p999/max ns):" );
+   for( const auto& s : r.phases )
+      ilog( "  ${name}: ${c}, ${t}/${p50}/${p99}/${p999}/${max}",
+            ("name",s.name)("c",s.count)("t",s.total_ns)("p50",s.p50_ns)("p99",s.p99_ns)("p999",s.p999_ns)("max",s.max_ns) );
+   ilog( "Operation latencies (count, total/p50/p99/p999/max ns):" );
+   for( const auto& s : r.operations )
+      ilog( "  ${name}: ${c}, ${t}/${p50}/${p99}/${p999}/${max}",
+            ("name",s.name)("c",s.count)("t",s.total_ns)("p50",s.p50_ns)("p99",s.p99_ns)("p999",s.p999_ns)("max",s.max_ns) );
+}
+
+void apply_metrics::reset()
+{
+   std::lock_guard<std::mutex> guard( _shards_mutex );
+   for( const auto& s : _shards )
+   {
+      std::lock_guard<std::mutex> shard_guard( s->mutex );
+      for( auto& h : s->operations )
+         h = latency_histogram();
+      for( auto& h : s->phases )
+         h = latency_histogram();
+   }
+}
+
+} }
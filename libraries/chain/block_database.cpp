@@ -24,19 +24,62 @@
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <fc/io/raw.hpp>
+#include <fc/interprocess/file_mapping.hpp>
+
+#include <cstring>
 
 namespace graphene { namespace chain {
 
-struct index_entry
-{
-   uint64_t      block_pos = 0;
-   uint32_t      block_size = 0;
-   block_id_type block_id;
-};
- }}
-FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
+namespace detail {
 
-namespace graphene { namespace chain {
+   /// Files are mapped with some room to spare so that appending blocks only rarely needs a new mapping
+   static const uint64_t min_mapping_reserve = 64 * 1024 * 1024;
+
+   struct mapped_file
+   {
+      mapped_file( const fc::path& file, uint64_t cap )
+         : mapping( file.generic_string().c_str(), fc::read_only ),
+           region( mapping, fc::read_only, 0, cap ),
+           data( (const char*)region.get_address() ),
+           capacity( cap ) {}
+
+      fc::file_mapping  mapping;
+      fc::mapped_region region;
+      const char*       data;
+      uint64_t          capacity;
+   };
+
+   /// A mapping together with the number of bytes of it which are known to be written
+   struct mapped_range
+   {
+      std::shared_ptr<const mapped_file> map;
+      uint64_t                           size = 0;
+
+      const char* at( uint64_t pos, uint64_t len )const
+      {
+         if( !map || pos + len > size )
+            return nullptr;
+         return map->data + pos;
+      }
+   };
+
+   /**
+    * The size has to be loaded before the mapping: the writer publishes a new mapping before
+    * the size that needs it, so the mapping loaded here is always large enough for the size.
+    */
+   static mapped_range load_range( const std::shared_ptr<const mapped_file>& map, const std::atomic<uint64_t>& size )
+   {
+      mapped_range result;
+      result.size = size.load( std::memory_order_acquire );
+      result.map  = std::atomic_load( &map );
+      if( !result.map )
+         result.size = 0;
+      else
+         result.size = std::min( result.size, result.map->capacity );
+      return result;
+   }
+
+} // detail
 
 void block_database::open( const fc::path& dbdir )
 { try {
@@ -45,18 +88,71 @@ void block_database::open( const fc::path& dbdir )
    _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 
    _index_filename = dbdir / "index";
+   _blocks_filename = dbdir / "blocks";
    if( !fc::exists( _index_filename ) )
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
    }
    else
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
    }
+
+   publish_size( _blocks_filename, _blocks_map, _blocks_size, fc::file_size( _blocks_filename ) );
+
+   // drop a torn or removed tail of the index while nothing has it mapped yet
+   const uint64_t index_size = fc::file_size( _index_filename );
+   const uint64_t valid_size = valid_index_size( index_size );
+   if( valid_size < index_size )
+   {
+      wlog( "Truncating block index from ${old} to ${new} bytes", ("old", index_size)("new", valid_size) );
+      _block_num_to_pos.close();
+      fc::resize_file( _index_filename, valid_size );
+      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+   }
+   publish_size( _index_filename, _index_map, _index_size, valid_size );
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
+uint64_t block_database::valid_index_size( uint64_t index_size )
+{
+   const detail::mapped_range blocks = detail::load_range( _blocks_map, _blocks_size );
+
+   uint64_t pos = index_size - index_size % sizeof(index_entry);
+   while( pos > 0 )
+   {
+      index_entry e;
+      _block_num_to_pos.seekg( pos - sizeof(index_entry) );
+      _block_num_to_pos.read( (char*)&e, sizeof(e) );
+      if( is_valid_entry( blocks, e ) )
+         break;
+      pos -= sizeof(index_entry);
+   }
+   return pos;
+}
+
+bool block_database::is_valid_entry( const detail::mapped_range& blocks, const index_entry& e )
+{
+   const char* data = e.block_size > 0 ? blocks.at( e.block_pos, e.block_size ) : nullptr;
+   if( data == nullptr )
+      return false;
+   try
+   {
+      fc::datastream<const char*> ds( data, e.block_size );
+      signed_block block;
+      fc::raw::unpack( ds, block );
+      return block.id() == e.block_id;
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   return false;
+}
+
 bool block_database::is_open()const
 {
   return _blocks.is_open();
@@ -66,6 +162,12 @@ void block_database::close()
 {
   _blocks.close();
   _block_num_to_pos.close();
+
+  std::lock_guard<std::mutex> guard( _remap_mutex );
+  _index_size.store( 0, std::memory_order_release );
+  _blocks_size.store( 0, std::memory_order_release );
+  std::atomic_store( &_index_map, std::shared_ptr<const detail::mapped_file>() );
+  std::atomic_store( &_blocks_map, std::shared_ptr<const detail::mapped_file>() );
 }
 
 void block_database::flush()
@@ -74,6 +176,18 @@ void block_database::flush()
   _block_num_to_pos.flush();
 }
 
+void block_database::publish_size( const fc::path& file, std::shared_ptr<const detail::mapped_file>& map,
+                                   std::atomic<uint64_t>& size, uint64_t new_size )
+{
+   std::lock_guard<std::mutex> guard( _remap_mutex );
+   if( new_size > 0 && ( !map || new_size > map->capacity ) )
+   {
+      const uint64_t capacity = new_size + std::max( new_size / 4, detail::min_mapping_reserve );
+      std::atomic_store( &map, std::shared_ptr<const detail::mapped_file>( std::make_shared<detail::mapped_file>( file, capacity ) ) );
+   }
+   size.store( new_size, std::memory_order_release );
+}
+
 void block_database::store( const block_id_type& _id, const signed_block& b )
 {
    if (true == replay_mode){
@@ -87,7 +201,8 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
    auto num = block_header::num_from_id(id);
-   _block_num_to_pos.seekp( sizeof( index_entry ) * num );
+   const uint64_t index_pos = sizeof( index_entry ) * num;
+   _block_num_to_pos.seekp( index_pos );
    index_entry e;
    _blocks.seekp( 0, _blocks.end );
    auto vec = fc::raw::pack( b );
@@ -96,134 +211,98 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
    e.block_id   = id;
    _blocks.write( vec.data(), vec.size() );
    _block_num_to_pos.write( (char*)&e, sizeof(e) );
+
+   // readers only look at the mapped files, so the data has to reach the file before it is published
+   flush();
+   publish_size( _blocks_filename, _blocks_map, _blocks_size, e.block_pos + e.block_size );
+   publish_size( _index_filename, _index_map, _index_size,
+                 std::max( _index_size.load( std::memory_order_relaxed ), index_pos + sizeof(e) ) );
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
-   index_entry e;
-   auto index_pos = sizeof(e)*block_header::num_from_id(id);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-
-   std::streampos s_pos = _block_num_to_pos.tellg();
-   if (-1 == s_pos){ 
-      FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database, _block_num_to_pos.tellg failed", ("id", id));
-   }
-
-   if ( static_cast<uint32_t>(s_pos) <= index_pos ){
+   const auto num = block_header::num_from_id(id);
+   optional<index_entry> e = read_index_entry( num );
+   if( !e.valid() )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
-   }
-
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
 
-   if( e.block_id == id )
+   if( e->block_id == id )
    {
-      e.block_size = 0;
-      _block_num_to_pos.seekp( sizeof(e)*block_header::num_from_id(id) );
-      _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      e->block_size = 0;
+      _block_num_to_pos.seekp( sizeof(index_entry)*num );
+      _block_num_to_pos.write( (char*)&(*e), sizeof(index_entry) );
+      _block_num_to_pos.flush();
    }
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
+optional<index_entry> block_database::read_index_entry( uint32_t block_num )const
+{
+   const detail::mapped_range index = detail::load_range( _index_map, _index_size );
+   const char* p = index.at( sizeof(index_entry) * uint64_t(block_num), sizeof(index_entry) );
+   if( p == nullptr )
+      return optional<index_entry>();
+   index_entry e;
+   std::memcpy( (char*)&e, p, sizeof(e) );
+   return e;
+}
+
 bool block_database::contains( const block_id_type& id )const
 { try {
    if( id == block_id_type() )
       return false;
 
-   index_entry e;
-   auto index_pos = sizeof(e)*block_header::num_from_id(id);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-
-   std::streampos s_pos = _block_num_to_pos.tellg();
-   if (-1 == s_pos){
-      FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database, _block_num_to_pos.tellg failed", ("id", id));
-   }
-
-   if ( static_cast<uint32_t>(s_pos) < index_pos + sizeof(e) )
-      return false;
-
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-   return e.block_id == id && e.block_size > 0;
+   optional<index_entry> e = read_index_entry( block_header::num_from_id(id) );
+   return e.valid() && e->block_id == id && e->block_size > 0;
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
 block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
-   index_entry e;
-   auto index_pos = sizeof(e)*block_num;
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= int64_t(index_pos) )
+   optional<index_entry> e = read_index_entry( block_num );
+   if( !e.valid() )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-   FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
-   return e.block_id;
+   FC_ASSERT( e->block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
+   return e->block_id;
 }
 
-optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
+optional<packed_block_view> block_database::fetch_packed_by_number( uint32_t block_num )const
 {
-   try
-   {
-      index_entry e;
-      auto index_pos = sizeof(e)*block_header::num_from_id(id);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos s_pos = _block_num_to_pos.tellg();
-
-      if (-1 == s_pos){
-         FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database, _block_num_to_pos.tellg failed", ("id", id));
-      }
-
-      if ( static_cast<uint32_t>(s_pos) <= index_pos )
-         return {};
-
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      if( e.block_id != id ) return optional<signed_block>();
+   optional<index_entry> e = read_index_entry( block_num );
+   if( !e.valid() || e->block_size == 0 )
+      return optional<packed_block_view>();
+
+   const detail::mapped_range blocks = detail::load_range( _blocks_map, _blocks_size );
+   const char* p = blocks.at( e->block_pos, e->block_size );
+   if( p == nullptr )
+      return optional<packed_block_view>();
+
+   packed_block_view result;
+   result.data    = p;
+   result.size    = e->block_size;
+   result.id      = e->block_id;
+   result.mapping = blocks.map;
+   return result;
+}
 
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      if (e.block_size)
-         _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
-   }
-   catch (const fc::exception&)
-   {
-   }
-   catch (const std::exception&)
-   {
-   }
-   return optional<signed_block>();
+optional<packed_block_view> block_database::fetch_packed( const block_id_type& id )const
+{
+   optional<packed_block_view> result = fetch_packed_by_number( block_header::num_from_id(id) );
+   if( result.valid() && result->id != id )
+      return optional<packed_block_view>();
+   return result;
 }
 
-optional<signed_block> block_database::fetch_by_number( uint32_t block_num )const
+static optional<signed_block> unpack_block( const optional<packed_block_view>& packed )
 {
+   if( !packed.valid() )
+      return optional<signed_block>();
    try
    {
-      index_entry e;
-      auto index_pos = sizeof(e)*block_num;
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos s_pos = _block_num_to_pos.tellg();
-      if (-1 == s_pos){
-         FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${block_num} not contained in block database, _block_num_to_pos.tellg failed", ("block_num", block_num));
-      }
-
-      if ( static_cast<uint32_t>(s_pos) <= index_pos )
-         return {};
-
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
+      fc::datastream<const char*> ds( packed->data, packed->size );
+      signed_block result;
+      fc::raw::unpack( ds, result );
+      FC_ASSERT( result.id() == packed->id );
       return result;
    }
    catch (const fc::exception&)
@@ -235,57 +314,29 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
-optional<index_entry> block_database::last_index_entry()const {
-   try
-   {
-      index_entry e;
-
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos pos = _block_num_to_pos.tellg();
-      if (-1 == pos){
-         FC_THROW_EXCEPTION(fc::key_not_found_exception, "last_index_entry tellg failed");
-      }
+optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
+{
+   return unpack_block( fetch_packed( id ) );
+}
 
-      if( static_cast<size_t>(pos) < sizeof(index_entry) )
-         return optional<index_entry>();
+optional<signed_block> block_database::fetch_by_number( uint32_t block_num )const
+{
+   return unpack_block( fetch_packed_by_number( block_num ) );
+}
 
-      pos -= pos % sizeof(index_entry);
+optional<index_entry> block_database::last_index_entry()const {
+   const detail::mapped_range index = detail::load_range( _index_map, _index_size );
+   const detail::mapped_range blocks = detail::load_range( _blocks_map, _blocks_size );
 
-      _blocks.seekg( 0, _block_num_to_pos.end );
-      const std::streampos blocks_size = _blocks.tellg();
-      while( pos > 0 )
-      {
-         pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
-         if( _block_num_to_pos.gcount() == sizeof(e) && e.block_size > 0
-                && e.block_pos + static_cast<uint64_t>(e.block_size) <= static_cast<uint64_t>(blocks_size) )
-            try
-            {
-               vector<char> data( e.block_size );
-               _blocks.seekg( e.block_pos );
-               _blocks.read( data.data(), e.block_size );
-               if( _blocks.gcount() == e.block_size )
-               {
-                  const signed_block block = fc::raw::unpack<signed_block>(data);
-                  if( block.id() == e.block_id )
-                     return e;
-               }
-            }
-            catch (const fc::exception&)
-            {
-            }
-            catch (const std::exception&)
-            {
-            }
-         fc::resize_file( _index_filename, pos );
-      }
-   }
-   catch (const fc::exception&)
-   {
-   }
-   catch (const std::exception&)
+   // open() cut off the invalid tail, but entries can have been removed since then
+   uint64_t pos = index.size - index.size % sizeof(index_entry);
+   while( pos > 0 )
    {
+      pos -= sizeof(index_entry);
+      index_entry e;
+      std::memcpy( (char*)&e, index.at( pos, sizeof(e) ), sizeof(e) );
+      if( is_valid_entry( blocks, e ) )
+         return e;
    }
    return optional<index_entry>();
 }
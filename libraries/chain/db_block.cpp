@@ -115,6 +115,11 @@ optional<signed_block> database::fetch_block_by_id( const block_id_type& id )con
    return b->data;
 }
 
+optional<packed_block_view> database::fetch_packed_block_by_id( const block_id_type& id )const
+{
+   return _block_id_to_block.fetch_packed( id );
+}
+
 optional<signed_block> database::fetch_block_by_number( uint32_t num )const
 {
    auto results = _fork_db.fetch_block_by_number(num);
@@ -187,6 +192,10 @@ void database::check_transaction_for_duplicated_operations(const signed_transact
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
 //   idump((new_block.block_num())(new_block.id())(new_block.timestamp)(new_block.previous));
+   // before the block is copied into the fork database, so the copy carries the recovered keys too
+   precompute_parallel( new_block, skip );
+
+   read_write_gate::write_guard state_guard( _state_gate );
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -204,6 +213,45 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
    return result;
 }
 
+void database::precompute_parallel( const signed_block& block, uint32_t skip )const
+{ try {
+   if( (skip & skip_transaction_signatures) || block.transactions.size() < 2 )
+      return;
+   worker_pool* pool = get_precompute_pool();
+   if( !pool )
+      return;
+
+   const chain_id_type& chain_id = get_chain_id();
+   pool->run_chunked( block.transactions.size(), [&block, &chain_id]( size_t begin, size_t end ) {
+      for( size_t i = begin; i < end; ++i )
+      {
+         try
+         {
+            block.transactions[i].get_signature_keys( chain_id );
+         }
+         catch( const fc::exception& )
+         {
+            // nothing is cached, so the transaction fails with the same error when it is applied
+         }
+      }
+   });
+} FC_CAPTURE_AND_RETHROW( (block.block_num()) ) }
+
+void database::set_precompute_threads( size_t threads )
+{
+   _precompute_threads = threads;
+   _precompute_pool.reset();
+}
+
+worker_pool* database::get_precompute_pool()const
+{
+   if( _precompute_threads == 0 )
+      return nullptr;
+   if( !_precompute_pool )
+      _precompute_pool.reset( new worker_pool( _precompute_threads ) );
+   return _precompute_pool.get();
+}
+
 bool database::_push_block(const signed_block& new_block)
 { try {
    boost::filesystem::space_info si = boost::filesystem::space(get_data_dir());
@@ -383,6 +431,7 @@ void database::update_witnesses( fork_item& fork_entry )const
  */
 processed_transaction database::push_transaction( const signed_transaction& trx, uint32_t skip )
 { try {
+   read_write_gate::write_guard state_guard( _state_gate );
    processed_transaction result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -427,6 +476,7 @@ processed_transaction database::_push_transaction( const signed_transaction& trx
 
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
+   read_write_gate::write_guard state_guard( _state_gate );
    const std::lock_guard<std::mutex> undo_db_lock{_undo_db_mutex};
    auto session = _undo_db.start_undo_session();
    return _apply_transaction( trx );
@@ -484,6 +534,7 @@ signed_block database::generate_block(
    uint32_t skip /* = 0 */
    )
 { try {
+   read_write_gate::write_guard state_guard( _state_gate );
    signed_block result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -620,6 +671,7 @@ signed_block database::_generate_block(
  */
 void database::pop_block()
 { try {
+   read_write_gate::write_guard state_guard( _state_gate );
    {
       const std::lock_guard<std::mutex> pending_tx_session_lock{_pending_tx_session_mutex};
       _pending_tx_session.reset();
@@ -638,6 +690,7 @@ void database::pop_block()
 
 void database::clear_pending()
 { try {
+   read_write_gate::write_guard state_guard( _state_gate );
    const std::lock_guard<std::mutex> pending_tx_lock{_pending_tx_mutex};
    const std::lock_guard<std::mutex> pending_tx_session_lock{_pending_tx_session_mutex};
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
@@ -702,6 +755,8 @@ void database::_apply_block( const signed_block& next_block )
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
    _applied_ops.clear();
+   const bool timed = _apply_metrics.enabled();
+   const auto block_start = timed ? apply_metrics::clock::now() : apply_metrics::clock::time_point();
 
    FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
 
@@ -717,59 +772,77 @@ void database::_apply_block( const signed_block& next_block )
 
    _issue_453_affected_assets.clear();
 
-   for( const auto& trx : next_block.transactions )
-   {
-      /* We do not need to push the undo state for each transaction
-       * because they either all apply and are valid or the
-       * entire block fails to apply.  We only need an "undo" state
-       * for transactions when validating broadcast transactions or
-       * when building a block.
-       */
-
-      apply_transaction( trx, skip );
-      // For real operations which are explicitly included in a transaction, virtual_op is 0.
-      // For VOPs derived directly from a real op,
-      //     use the real op's (block_num,trx_in_block,op_in_trx), virtual_op starts from 1.
-      // For VOPs created after processed all transactions,
-      //     trx_in_block = the_block.trsanctions.size(), virtual_op starts from 0.
-      ++_current_trx_in_block;
-      _current_op_in_trx  = 0;
-      _current_virtual_op = 0;
-   }
+   _apply_metrics.time_phase( apply_phase::transactions, [&]() {
+      for( const auto& trx : next_block.transactions )
+      {
+         /* We do not need to push the undo state for each transaction
+          * because they either all apply and are valid or the
+          * entire block fails to apply.  We only need an "undo" state
+          * for transactions when validating broadcast transactions or
+          * when building a block.
+          */
+
+         apply_transaction( trx, skip );
+         // For real operations which are explicitly included in a transaction, virtual_op is 0.
+         // For VOPs derived directly from a real op,
+         //     use the real op's (block_num,trx_in_block,op_in_trx), virtual_op starts from 1.
+         // For VOPs created after processed all transactions,
+         //     trx_in_block = the_block.trsanctions.size(), virtual_op starts from 0.
+         ++_current_trx_in_block;
+         _current_op_in_trx  = 0;
+         _current_virtual_op = 0;
+      }
+   } );
 
    if (global_props.parameters.witness_schedule_algorithm == GRAPHENE_WITNESS_SCHEDULED_ALGORITHM) {
-      update_witness_schedule(next_block);
+      _apply_metrics.time_phase( apply_phase::witness_schedule, [&]() {
+         update_witness_schedule(next_block);
 
-      for(const auto& active_sons : global_props.active_sons) {
-         if(!active_sons.second.empty()) {
-            update_son_schedule(active_sons.first, next_block);
+         for(const auto& active_sons : global_props.active_sons) {
+            if(!active_sons.second.empty()) {
+               update_son_schedule(active_sons.first, next_block);
+            }
          }
-      }
+      } );
    }
 
-   const uint32_t missed = update_witness_missed_blocks( next_block );
-   update_global_dynamic_data( next_block, missed );
-   update_signing_witness(signing_witness, next_block);
-   update_last_irreversible_block();
+   _apply_metrics.time_phase( apply_phase::update_global_dynamic_data, [&]() {
+      const uint32_t missed = update_witness_missed_blocks( next_block );
+      update_global_dynamic_data( next_block, missed );
+      update_signing_witness(signing_witness, next_block);
+      update_last_irreversible_block();
+   } );
 
    // Are we at the maintenance interval?
    if( maint_needed )
-      perform_chain_maintenance(next_block, global_props);
+      _apply_metrics.time_phase( apply_phase::perform_chain_maintenance, [&]() {
+         perform_chain_maintenance(next_block, global_props);
+      } );
 
-   check_ending_lotteries();
-   check_ending_nft_lotteries();
+   _apply_metrics.time_phase( apply_phase::check_ending_lotteries, [&]() {
+      check_ending_lotteries();
+      check_ending_nft_lotteries();
+   } );
 
    create_block_summary(next_block);
-   place_delayed_bets(); // must happen after update_global_dynamic_data() updates the time
-   clear_expired_transactions();
-   clear_expired_proposals();
-   clear_expired_orders();
-   update_expired_feeds();       // this will update expired feeds and some core exchange rates
-   update_core_exchange_rates(); // this will update remaining core exchange rates
-   update_withdraw_permissions();
-   update_tournaments();
-   update_betting_markets(next_block.timestamp);
-   finalize_expired_offers();
+   _apply_metrics.time_phase( apply_phase::place_delayed_bets, [&]() {
+      place_delayed_bets(); // must happen after update_global_dynamic_data() updates the time
+   } );
+   _apply_metrics.time_phase( apply_phase::clear_expired_transactions, [&]() { clear_expired_transactions(); } );
+   _apply_metrics.time_phase( apply_phase::clear_expired_proposals, [&]() { clear_expired_proposals(); } );
+   _apply_metrics.time_phase( apply_phase::clear_expired_orders, [&]() { clear_expired_orders(); } );
+   _apply_metrics.time_phase( apply_phase::update_expired_feeds, [&]() {
+      update_expired_feeds();       // this will update expired feeds and some core exchange rates
+   } );
+   _apply_metrics.time_phase( apply_phase::update_core_exchange_rates, [&]() {
+      update_core_exchange_rates(); // this will update remaining core exchange rates
+   } );
+   _apply_metrics.time_phase( apply_phase::update_withdraw_permissions, [&]() { update_withdraw_permissions(); } );
+   _apply_metrics.time_phase( apply_phase::update_tournaments, [&]() { update_tournaments(); } );
+   _apply_metrics.time_phase( apply_phase::update_betting_markets, [&]() {
+      update_betting_markets(next_block.timestamp);
+   } );
+   _apply_metrics.time_phase( apply_phase::finalize_expired_offers, [&]() { finalize_expired_offers(); } );
 
    // n.b., update_maintenance_flag() happens this late
    // because get_slot_time() / get_slot_at_time() is needed above
@@ -792,10 +865,19 @@ void database::_apply_block( const signed_block& next_block )
       apply_debug_updates();
 
    // notify observers that the block has been applied
-   notify_applied_block( next_block ); //emit
+   _apply_metrics.time_phase( apply_phase::notify_applied_block, [&]() {
+      notify_applied_block( next_block ); //emit
+   } );
    _applied_ops.clear();
 
-   notify_changed_objects();
+   _apply_metrics.time_phase( apply_phase::notify_changed_objects, [&]() { notify_changed_objects(); } );
+
+   if( timed )
+   {
+      _apply_metrics.record_phase( apply_phase::block, apply_metrics::elapsed_ns( block_start ) );
+      if( _apply_metrics_log_blocks > 0 && next_block_num % _apply_metrics_log_blocks == 0 )
+         _apply_metrics.log_report();
+   }
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
 
@@ -916,7 +998,15 @@ operation_result database::apply_operation(transaction_evaluation_state& eval_st
    unique_ptr<op_evaluator>& eval = _operation_evaluators[ u_which ];
    FC_ASSERT( eval, "No registered evaluator for operation ${op}", ("op",op) );
    auto op_id = push_applied_operation( op );
-   auto result = eval->evaluate( eval_state, op, true );
+   operation_result result;
+   if( _apply_metrics.enabled() )
+   {
+      auto start = apply_metrics::clock::now();
+      result = eval->evaluate( eval_state, op, true );
+      _apply_metrics.record_operation( i_which, apply_metrics::elapsed_ns( start ) );
+   }
+   else
+      result = eval->evaluate( eval_state, op, true );
    set_applied_operation_result( op_id, result );
    return result;
 } FC_CAPTURE_AND_RETHROW( (op) ) }
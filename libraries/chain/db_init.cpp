@@ -385,6 +385,7 @@ void database::initialize_indexes()
    auto acnt_index = add_index< primary_index<account_index, 20> >(); // ~1 million accounts per chunk
    acnt_index->add_secondary_index<account_member_index>();
    acnt_index->add_secondary_index<account_referrer_index>();
+   acnt_index->add_secondary_index<account_vote_index>();
 
    add_index< primary_index<committee_member_index, 8> >(); // 256 members per chunk
    add_index< primary_index<son_index> >();
@@ -396,7 +397,8 @@ void database::initialize_indexes()
    prop_index->add_secondary_index<required_approval_index>();
 
    add_index< primary_index<withdraw_permission_index > >();
-   add_index< primary_index<vesting_balance_index> >();
+   auto vesting_balance_idx = add_index< primary_index<vesting_balance_index> >();
+   vesting_balance_idx->add_secondary_index<vesting_balance_holder_index>();
    add_index< primary_index<worker_index> >();
    add_index< primary_index<balance_index> >();
    add_index< primary_index<blinded_balance_index> >();
@@ -411,15 +413,18 @@ void database::initialize_indexes()
    add_index< primary_index<tournament_index> >();
    auto tournament_details_idx = add_index< primary_index<tournament_details_index> >();
    tournament_details_idx->add_secondary_index<tournament_players_index>();
-   add_index< primary_index<match_index> >();
+   auto match_idx = add_index< primary_index<match_index> >();
+   match_idx->add_secondary_index<tournament_progress_index>();
    add_index< primary_index<game_index> >();
    add_index< primary_index<custom_permission_index> >();
    add_index< primary_index<custom_account_authority_index> >();
    auto offer_idx = add_index< primary_index<offer_index> >();
    offer_idx->add_secondary_index<offer_item_index>();
 
-   add_index< primary_index<nft_metadata_index > >();
-   add_index< primary_index<nft_index > >();
+   auto nft_metadata_idx = add_index< primary_index<nft_metadata_index > >();
+   nft_metadata_idx->add_secondary_index<nft_lottery_change_index>();
+   auto nft_idx = add_index< primary_index<nft_index > >();
+   nft_idx->add_secondary_index<nft_lottery_change_index>();
    add_index< primary_index<account_role_index> >();
    add_index< primary_index<son_proposal_index> >();
 
@@ -113,7 +113,7 @@ vector<std::reference_wrapper<const son_object>> database::sort_votable_objects<
 }
 
 template<class Type>
-void database::perform_account_maintenance(Type tally_helper)
+void database::perform_account_maintenance(Type& tally_helper)
 {
    const auto& bal_idx = get_index_type< account_balance_index >().indices().get< by_maintenance_flag >();
    if( bal_idx.begin() != bal_idx.end() )
@@ -1587,8 +1587,8 @@ void schedule_pending_dividend_balances(database& db,
 { try {
    dlog("Processing dividend payments for dividend holder asset type ${holder_asset} at time ${t}",
         ("holder_asset", dividend_holder_asset_obj.symbol)("t", db.head_block_time()));
-   auto balance_by_acc_index = db.get_index_type< primary_index< account_balance_index > >().get_secondary_index< balances_by_account_index >();
-   auto current_distribution_account_balance_range =
+   const auto& balance_by_acc_index = db.get_index_type< primary_index< account_balance_index > >().get_secondary_index< balances_by_account_index >();
+   const auto& current_distribution_account_balance_range =
       //balance_index.indices().get<by_account_asset>().equal_range(boost::make_tuple(dividend_data.dividend_distribution_account));
       balance_by_acc_index.get_account_balances(dividend_data.dividend_distribution_account);
    auto previous_distribution_account_balance_range =
@@ -1606,29 +1606,22 @@ void schedule_pending_dividend_balances(database& db,
    uint64_t distribution_base_fee = gpo.parameters.current_fees->get<asset_dividend_distribution_operation>().distribution_base_fee;
    uint32_t distribution_fee_per_holder = gpo.parameters.current_fees->get<asset_dividend_distribution_operation>().distribution_fee_per_holder;
 
-   std::map<account_id_type, share_type> vesting_amounts;
-
    auto balance_type = vesting_balance_type::normal;
    if(db.head_block_time() >= HARDFORK_GPOS_TIME)
       balance_type = vesting_balance_type::gpos;
 
-   uint32_t holder_account_count = 0;
+   // the vested amounts of the dividend asset are kept up to date as vesting balances change
+   const auto& vesting_totals = db.get_index_type< primary_index< vesting_balance_index > >()
+         .get_secondary_index< vesting_balance_holder_index >().get_holder_totals(dividend_holder_asset_obj.id, balance_type);
+   const std::map<account_id_type, share_type>& vesting_amounts = vesting_totals.amounts;
+
+   uint32_t holder_account_count = vesting_totals.balance_count;
 
-   // get only once a collection of accounts that hold nonzero vesting balances of the dividend asset
    auto vesting_balances_begin =
       vesting_index.indices().get<by_asset_balance>().lower_bound(boost::make_tuple(dividend_holder_asset_obj.id, balance_type));
    auto vesting_balances_end =
       vesting_index.indices().get<by_asset_balance>().upper_bound(boost::make_tuple(dividend_holder_asset_obj.id, balance_type, share_type()));
 
-   for (const vesting_balance_object& vesting_balance_obj : boost::make_iterator_range(vesting_balances_begin, vesting_balances_end))
-   {
-        vesting_amounts[vesting_balance_obj.owner] += vesting_balance_obj.balance.amount;
-        ++holder_account_count;
-        dlog("Vesting balance for account: ${owner}, amount: ${amount}",
-             ("owner", vesting_balance_obj.owner(db).name)
-             ("amount", vesting_balance_obj.balance.amount));
-   }
-
    auto current_distribution_account_balance_iter = current_distribution_account_balance_range.begin();
    if(db.head_block_time() < HARDFORK_GPOS_TIME)
       holder_account_count = std::distance(holder_balances_begin, holder_balances_end);
@@ -1646,11 +1639,10 @@ void schedule_pending_dividend_balances(database& db,
    // the distribution account)
    share_type total_balance_of_dividend_asset;
    if(db.head_block_time() >= HARDFORK_GPOS_TIME && dividend_holder_asset_obj.symbol == GRAPHENE_SYMBOL) { // only core
-      for (const vesting_balance_object &holder_balance_object : boost::make_iterator_range(vesting_balances_begin,
-                                                                                            vesting_balances_end))
-         if (holder_balance_object.owner != dividend_data.dividend_distribution_account) {
-            total_balance_of_dividend_asset += holder_balance_object.balance.amount;
-         }
+      total_balance_of_dividend_asset = vesting_totals.total;
+      auto itr = vesting_amounts.find(dividend_data.dividend_distribution_account);
+      if (itr != vesting_amounts.end())
+         total_balance_of_dividend_asset -= itr->second;
    }
    else {
       for (const account_balance_object &holder_balance_object : boost::make_iterator_range(holder_balances_begin,
@@ -2344,22 +2336,54 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
    update_son_params(*this);
 
+   /// Votes and stake tallied from a subset of the voting accounts
+   struct vote_tally_buffer {
+      vector<uint64_t>                             votes;
+      vector<uint64_t>                             witness_counts;
+      vector<uint64_t>                             committee_counts;
+      flat_map<sidechain_type, vector<uint64_t> >  son_counts;
+      uint64_t                                     total_voting_stake = 0;
+
+      explicit vote_tally_buffer( const global_property_object& props )
+      {
+         votes.resize(props.next_available_vote_id);
+         witness_counts.resize(props.parameters.maximum_witness_count / 2 + 1);
+         committee_counts.resize(props.parameters.maximum_committee_count / 2 + 1);
+         for( const auto& active_sidechain_type : all_sidechain_types )
+            son_counts[active_sidechain_type].resize(props.parameters.maximum_son_count() / 2 + 1);
+      }
+
+      void merge( const vote_tally_buffer& other )
+      {
+         for( size_t i = 0; i < votes.size(); ++i )
+            votes[i] += other.votes[i];
+         for( size_t i = 0; i < witness_counts.size(); ++i )
+            witness_counts[i] += other.witness_counts[i];
+         for( size_t i = 0; i < committee_counts.size(); ++i )
+            committee_counts[i] += other.committee_counts[i];
+         for( auto& son_count : son_counts )
+         {
+            const auto& other_son_count = other.son_counts.at(son_count.first);
+            for( size_t i = 0; i < son_count.second.size(); ++i )
+               son_count.second[i] += other_son_count[i];
+         }
+         total_voting_stake += other.total_voting_stake;
+      }
+   };
+
    struct vote_tally_helper {
       database& d;
       const global_property_object& props;
       std::map<account_id_type, share_type> vesting_amounts;
+      vote_tally_buffer totals;
+      /// Whether the stake of a voter only depends on state which processing fees does not modify
+      bool defer_tally;
+      /// Accounts to tally once the fees are processed, in the order they were visited
+      vector<const account_object*> deferred_voters;
 
       vote_tally_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo)
+         : d(d), props(gpo), totals(gpo)
       {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         for( auto& son_count_histogram_buffer : d._son_count_histogram_buffer ){
-            son_count_histogram_buffer.second.resize(props.parameters.maximum_son_count() / 2 + 1);
-         }
-         d._total_voting_stake = 0;
-
          auto balance_type = vesting_balance_type::normal;
          if(d.head_block_time() >= HARDFORK_GPOS_TIME)
             balance_type = vesting_balance_type::gpos;
@@ -2378,9 +2402,51 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                  ("amount", vesting_balance_obj.balance.amount));
          }
 
+         // Once liquid balances stop counting, the stake is the GPOS vesting collected above scaled by the
+         // vesting factor, which process_fees() does not touch, so the tally can wait and run in parallel.
+         defer_tally = d.head_block_time() >= (HARDFORK_GPOS_TIME + props.parameters.gpos_subperiod()/2);
       }
 
       void operator()( const account_object& stake_account, const account_statistics_object& stats )
+      {
+         if( defer_tally )
+            deferred_voters.push_back( &stake_account );
+         else
+            tally( stake_account, totals );
+      }
+
+      /// Tallies the deferred voters, in shards on the worker threads if there are any, and publishes the totals
+      void finish()
+      {
+         worker_pool* pool = d.get_precompute_pool();
+         if( pool == nullptr || deferred_voters.size() < 2 )
+         {
+            for( const account_object* voter : deferred_voters )
+               tally( *voter, totals );
+         }
+         else
+         {
+            std::mutex totals_mutex;
+            pool->run_chunked( deferred_voters.size(), [this, &totals_mutex]( size_t begin, size_t end ) {
+               vote_tally_buffer shard( props );
+               for( size_t i = begin; i < end; ++i )
+                  tally( *deferred_voters[i], shard );
+               // integer sums do not depend on the order the shards are merged in
+               const std::lock_guard<std::mutex> lock( totals_mutex );
+               totals.merge( shard );
+            });
+         }
+         deferred_voters.clear();
+
+         d._vote_tally_buffer = std::move( totals.votes );
+         d._witness_count_histogram_buffer = std::move( totals.witness_counts );
+         d._committee_count_histogram_buffer = std::move( totals.committee_counts );
+         d._son_count_histogram_buffer = std::move( totals.son_counts );
+         d._total_voting_stake = totals.total_voting_stake;
+      }
+
+      /// Adds the stake of @ref stake_account to @ref buffer, must not modify the database
+      void tally( const account_object& stake_account, vote_tally_buffer& buffer )const
       {
          if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
          {
@@ -2431,31 +2497,31 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
             {
                uint32_t offset = id.instance();
                // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
+               if( offset < buffer.votes.size() )
+                  buffer.votes[offset] += voting_stake;
             }
 
             if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
+                                          buffer.witness_counts.size() - 1);
                // votes for a number greater than maximum_witness_count
                // are turned into votes for maximum_witness_count.
                //
                // in particular, this takes care of the case where a
                // member was voting for a high number, then the
                // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
+               buffer.witness_counts[offset] += voting_stake;
             }
             if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
+                                          buffer.committee_counts.size() - 1);
                // votes for a number greater than maximum_committee_count
                // are turned into votes for maximum_committee_count.
                //
                // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
+               buffer.committee_counts[offset] += voting_stake;
             }
 
             if ( opinion_account.options.extensions.value.num_son.valid() )
@@ -2465,24 +2531,25 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                   const auto& num_son = num_sidechain_son.second;
                   if (num_son <= props.parameters.maximum_son_count()) {
                      uint16_t offset = std::min(size_t(num_son / 2),
-                                                d._son_count_histogram_buffer.at(sidechain).size() - 1);
+                                                buffer.son_counts.at(sidechain).size() - 1);
                      // votes for a number greater than maximum_son_count
                      // are turned into votes for maximum_son_count.
                      //
                      // in particular, this takes care of the case where a
                      // member was voting for a high number, then the
                      // parameter was lowered.
-                     d._son_count_histogram_buffer.at(sidechain)[offset] += voting_stake;
+                     buffer.son_counts.at(sidechain)[offset] += voting_stake;
                   }
                }
             }
 
-            d._total_voting_stake += voting_stake;
+            buffer.total_voting_stake += voting_stake;
          }
       }
    } tally_helper(*this, gpo);
 
    perform_account_maintenance( tally_helper );
+   tally_helper.finish();
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
       ~clear_canary() { target.clear(); }
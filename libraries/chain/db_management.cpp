@@ -32,13 +32,21 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/thread/thread.hpp>
 
+#include <condition_variable>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 namespace graphene { namespace chain {
 
+/// Number of times run_read() starts a read that writes keep preempting before it gives up
+static const uint32_t max_read_attempts = 10;
+
 database::database() :
    _random_number_generator(fc::ripemd160().data())
 {
@@ -61,11 +69,13 @@ class auto_undo_enabler
 {
     const bool _slow_replays;
     undo_database& _undo_db;
+    fc::signal<void()>& _enabling;
     bool _disabled;
 public:
-    auto_undo_enabler(bool slow_replays, undo_database& undo_db) :
+    auto_undo_enabler(bool slow_replays, undo_database& undo_db, fc::signal<void()>& enabling) :
         _slow_replays(slow_replays),
         _undo_db(undo_db),
+        _enabling(enabling),
         _disabled(false)
     {
     }
@@ -81,6 +91,7 @@ public:
     {
         if(!_disabled)
             return;
+        _enabling();
         _undo_db.enable();
         _disabled = false;
     }
@@ -96,6 +107,155 @@ public:
     }
 };
 
+// Reads the blocks of a replay on a separate thread, unpacks them and checks their merkle roots,
+// and hands them to the chain thread through a bounded ring buffer.
+// The first missing block is delivered as an invalid optional and ends the reading.
+class replay_prefetcher
+{
+   const block_database&                   _blocks;
+   const uint32_t                          _first;
+   const uint32_t                          _last;
+   std::vector< optional<signed_block> >   _ring;
+   size_t                                  _head = 0;
+   size_t                                  _count = 0;
+   bool                                    _stopping = false;
+   std::exception_ptr                      _error;
+   std::mutex                              _mutex;
+   std::condition_variable                 _changed;
+   std::thread                             _thread;
+
+   void read_blocks()
+   {
+      try
+      {
+         for( uint32_t i = _first; i <= _last; ++i )
+         {
+            auto start = fc::time_point::now();
+            optional<signed_block> block = _blocks.fetch_by_number( i );
+            auto fetched = fc::time_point::now();
+            const bool found = block.valid();
+            if( found )
+               FC_ASSERT( block->transaction_merkle_root == block->calculate_merkle_root(), "",
+                          ("transaction_merkle_root",block->transaction_merkle_root)
+                          ("calc",block->calculate_merkle_root())("block_num",i) );
+            auto checked = fc::time_point::now();
+            fetch_time += fetched - start;
+            check_time += checked - fetched;
+
+            std::unique_lock<std::mutex> lock( _mutex );
+            _changed.wait( lock, [this]() { return _count < _ring.size() || _stopping; } );
+            if( _stopping )
+               return;
+            _ring[ (_head + _count) % _ring.size() ] = std::move( block );
+            ++_count;
+            _changed.notify_all();
+            if( !found )
+               return;
+         }
+      }
+      catch( ... )
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         _error = std::current_exception();
+         _changed.notify_all();
+      }
+   }
+
+public:
+   /// Time spent by the reader thread reading and unpacking blocks, and checking their merkle roots
+   fc::microseconds fetch_time;
+   fc::microseconds check_time;
+   /// Time the chain thread spent waiting for the reader thread
+   fc::microseconds wait_time;
+
+   replay_prefetcher( const block_database& blocks, uint32_t first, uint32_t last, uint32_t capacity ) :
+      _blocks( blocks ),
+      _first( first ),
+      _last( last ),
+      _ring( capacity )
+   {
+      _thread = std::thread( [this]() { read_blocks(); } );
+   }
+
+   ~replay_prefetcher()
+   {
+      stop();
+   }
+
+   /// Returns the next block, or an invalid optional if it does not exist.
+   /// Rethrows what the reader thread threw once the blocks read before are consumed.
+   optional<signed_block> next()
+   {
+      std::unique_lock<std::mutex> lock( _mutex );
+      if( _count == 0 )
+      {
+         auto start = fc::time_point::now();
+         _changed.wait( lock, [this]() { return _count > 0 || _error; } );
+         wait_time += fc::time_point::now() - start;
+         if( _count == 0 )
+            std::rethrow_exception( _error );
+      }
+      optional<signed_block> block = std::move( _ring[_head] );
+      _ring[_head].reset();
+      _head = (_head + 1) % _ring.size();
+      --_count;
+      _changed.notify_all();
+      return block;
+   }
+
+   /// Stops the reader thread, after which its timings may be read
+   void stop()
+   {
+      if( !_thread.joinable() )
+         return;
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         _stopping = true;
+      }
+      _changed.notify_all();
+      _thread.join();
+   }
+};
+
+void database::set_replay_prefetch_blocks( uint32_t blocks )
+{
+   _replay_prefetch_blocks = blocks;
+}
+
+void database::set_read_threads( size_t threads )
+{
+   _read_threads.clear();
+   for( size_t i = 0; i < threads; ++i )
+      _read_threads.push_back( std::make_shared<fc::thread>( "read " + std::to_string( i ) ) );
+}
+
+void database::run_read( const std::function<void()>& f )const
+{
+   if( _read_threads.empty() )
+   {
+      f();
+      return;
+   }
+   fc::thread& thread = *_read_threads[ _next_read_thread++ % _read_threads.size() ];
+   thread.async( [this, &f]() {
+      for( uint32_t attempt = 1; ; ++attempt )
+      {
+         try
+         {
+            read_write_gate::read_guard state_guard( _state_gate );
+            f();
+            return;
+         }
+         catch( const read_preempted_exception& )
+         {
+            // the gate is released, the next attempt waits until the write is done
+            if( attempt >= max_read_attempts )
+               throw;
+         }
+      }
+   }, "read-only call" ).wait();
+}
+
 void database::reindex( fc::path data_dir )
 { try {
    auto last_block = _block_id_to_block.last();
@@ -112,7 +272,7 @@ void database::reindex( fc::path data_dir )
    uint32_t undo_point = last_block_num < 50 ? 0 : last_block_num - 50;
 
    ilog( "Replaying blocks, starting at ${next}...", ("next",head_block_num() + 1) );
-   auto_undo_enabler undo(_slow_replays, _undo_db);
+   auto_undo_enabler undo(_slow_replays, _undo_db, replayed_irreversible_blocks);
    if( head_block_num() >= undo_point )
    {
       if( head_block_num() > 0 )
@@ -122,7 +282,24 @@ void database::reindex( fc::path data_dir )
    {
        undo.disable();
    }
-   for( uint32_t i = head_block_num() + 1; i <= last_block_num; ++i )
+   const uint32_t first_block_num = head_block_num() + 1;
+   std::unique_ptr<replay_prefetcher> prefetcher;
+   uint32_t skip = skip_witness_signature |
+                   skip_transaction_signatures |
+                   skip_transaction_dupe_check |
+                   skip_tapos_check |
+                   skip_witness_schedule_check |
+                   skip_authority_check;
+   if( _replay_prefetch_blocks > 0 )
+   {
+      prefetcher.reset( new replay_prefetcher( _block_id_to_block, first_block_num, last_block_num,
+                                               _replay_prefetch_blocks ) );
+      // the reader thread has checked the merkle roots already
+      skip |= skip_merkle_check;
+   }
+   fc::microseconds apply_time;
+   uint32_t replayed = 0;
+   for( uint32_t i = first_block_num; i <= last_block_num; ++i )
    {
       if( i % 1000000 == 0 )
       {
@@ -130,10 +307,12 @@ void database::reindex( fc::path data_dir )
          flush();
          ilog( "Done" );
       }
-      fc::optional< signed_block > block = _block_id_to_block.fetch_by_number(i);
+      fc::optional< signed_block > block = prefetcher ? prefetcher->next() : _block_id_to_block.fetch_by_number(i);
       if( !block.valid() )
       {
          wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
+         if( prefetcher )
+            prefetcher->stop();
          uint32_t dropped_count = 0;
          while( true )
          {
@@ -150,29 +329,36 @@ void database::reindex( fc::path data_dir )
          wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
          break;
       }
+      auto apply_start = fc::time_point::now();
       if( i < undo_point && !_slow_replays)
       {
-         apply_block(*block, skip_witness_signature |
-                             skip_transaction_signatures |
-                             skip_transaction_dupe_check |
-                             skip_tapos_check |
-                             skip_witness_schedule_check |
-                             skip_authority_check);
+         apply_block(*block, skip);
       }
       else
       {
          undo.enable();
-         push_block(*block, skip_witness_signature |
-                            skip_transaction_signatures |
-                            skip_transaction_dupe_check |
-                            skip_tapos_check |
-                            skip_witness_schedule_check |
-                            skip_authority_check);
+         push_block(*block, skip);
       }
+      apply_time += fc::time_point::now() - apply_start;
+      ++replayed;
    }
    undo.enable();
    auto end = fc::time_point::now();
    ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
+
+   const double elapsed = double((end-start).count()) / 1000000.0;
+   ilog( "Replayed ${n} blocks, ${r} blocks/sec, applying took ${a} sec",
+         ("n",replayed)("r",elapsed > 0 ? uint64_t(replayed / elapsed) : uint64_t(replayed))
+         ("a",double(apply_time.count())/1000000.0) );
+   if( prefetcher )
+   {
+      prefetcher->stop();
+      ilog( "Reader thread spent ${f} sec reading blocks and ${c} sec checking merkle roots, "
+            "chain thread waited ${w} sec for blocks",
+            ("f",double(prefetcher->fetch_time.count())/1000000.0)
+            ("c",double(prefetcher->check_time.count())/1000000.0)
+            ("w",double(prefetcher->wait_time.count())/1000000.0) );
+   }
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
 void database::wipe(const fc::path& data_dir, bool include_blocks)
@@ -240,6 +426,15 @@ void database::open(
 
          _block_id_to_block.set_replay_mode(false);
       }
+
+      // Nothing was replayed when the block log ends at the head block, e.g. after loading a snapshot,
+      // so the fork database still has to learn the block the next ones link to.
+      if( !_fork_db.head() && head_block_num() > 0 )
+      {
+         optional<signed_block> head_block = fetch_block_by_number( head_block_num() );
+         if( head_block.valid() && head_block->id() == head_block_id() )
+            _fork_db.start_block( *head_block );
+      }
       _opened = true;
    }
    FC_CAPTURE_LOG_AND_RETHROW( (data_dir) )
@@ -250,6 +445,8 @@ void database::close(bool rewind)
    if (!_opened)
       return;
 
+   read_write_gate::write_guard state_guard( _state_gate );
+
    // TODO:  Save pending tx's on close()
    clear_pending();
 
@@ -279,7 +476,7 @@ void database::close(bool rewind)
    // DB state (issue #336).
    clear_pending();
 
-   object_database::flush();
+   flush();
    object_database::close();
 
    if( _block_id_to_block.is_open() )
@@ -290,41 +487,89 @@ void database::close(bool rewind)
    _opened = false;
 }
 
+void database::flush()
+{
+   saving_object_database();
+   object_database::flush();
+}
+
 void database::force_slow_replays()
 {
    ilog("enabling slow replays");
    _slow_replays = true;
 }
 
+void database::enable_apply_metrics( bool enabled, uint32_t log_interval_blocks )
+{
+   _apply_metrics.enable( enabled );
+   _apply_metrics_log_blocks = log_interval_blocks;
+}
+
 void database::check_ending_lotteries()
 {
    try {
       const auto& lotteries_idx = get_index_type<asset_index>().indices().get<active_lotteries>();
-      for( auto checking_asset: lotteries_idx )
+      // active lotteries come first, by descending end date, so skip those still running
+      asset_object running;
+      running.lottery_options = lottery_asset_options();
+      running.lottery_options->is_active = true;
+      running.lottery_options->end_date = head_block_time();
+      for( auto itr = lotteries_idx.lower_bound( running ); itr != lotteries_idx.end(); ++itr )
       {
+         const asset_object& checking_asset = *itr;
          FC_ASSERT( checking_asset.is_lottery() );
          FC_ASSERT( checking_asset.lottery_options->is_active );
          FC_ASSERT( checking_asset.lottery_options->end_date != time_point_sec() );
-         if( checking_asset.lottery_options->end_date > head_block_time() ) continue;
-         checking_asset.end_lottery(*this);
+         // ending may change the object it is called on, so end a copy
+         asset_object ending_asset = checking_asset;
+         ending_asset.end_lottery(*this);
       }
    } catch( ... ) {}
 }
 
 void database::check_ending_nft_lotteries()
 {
+   auto& metadata_idx = get_mutable_index_type< primary_index<nft_metadata_index> >();
+   auto& tokens_idx = get_mutable_index_type< primary_index<nft_index> >();
+   flat_set<nft_metadata_id_type> changed = metadata_idx.get_secondary_index<nft_lottery_change_index>().take_changed_metadata();
+   for( const auto& id : tokens_idx.get_secondary_index<nft_lottery_change_index>().take_changed_metadata() )
+      changed.insert( id );
+   for( const auto& id : changed )
+   {
+      const nft_metadata_object* lottery = find( id );
+      if( lottery && lottery->is_lottery() && lottery->lottery_data->lottery_options.is_active
+            && lottery->lottery_data->lottery_options.ending_on_soldout
+            && lottery->get_token_current_supply(*this) == lottery->max_supply )
+         _sold_out_nft_lotteries.insert( id );
+      else
+         _sold_out_nft_lotteries.erase( id );
+   }
+
    try {
       const auto &nft_lotteries_idx = get_index_type<nft_metadata_index>().indices().get<active_nft_lotteries>();
-      for (auto checking_token : nft_lotteries_idx)
+      auto itr = nft_lotteries_idx.begin();
+      if( _sold_out_nft_lotteries.empty() )
       {
+         // active lotteries come first, by descending end date, so skip those still running
+         nft_metadata_object running;
+         running.lottery_data = nft_lottery_data();
+         running.lottery_data->lottery_options.is_active = true;
+         running.lottery_data->lottery_options.end_date = head_block_time();
+         itr = nft_lotteries_idx.lower_bound( running );
+      }
+      for (; itr != nft_lotteries_idx.end(); ++itr)
+      {
+         const nft_metadata_object& checking_token = *itr;
          FC_ASSERT(checking_token.is_lottery());
          const auto &lottery_options = checking_token.lottery_data->lottery_options;
          FC_ASSERT(lottery_options.is_active);
-         // Check the current supply of lottery tokens
-         auto current_supply = checking_token.get_token_current_supply(*this);
-         if ((lottery_options.ending_on_soldout && (current_supply == checking_token.max_supply)) ||
+         if ((lottery_options.ending_on_soldout && _sold_out_nft_lotteries.count(checking_token.id)) ||
              (lottery_options.end_date != time_point_sec() && (lottery_options.end_date <= head_block_time())))
-            checking_token.end_lottery(*this);
+         {
+            // ending changes the winning tickets of the object it is called on, so end a copy
+            nft_metadata_object ending_token = checking_token;
+            ending_token.end_lottery(*this);
+         }
       }
    } catch( ... ) {}
 }
@@ -603,58 +603,139 @@ void database::notify_on_pending_transaction( const signed_transaction& tx )
    GRAPHENE_TRY_NOTIFY( on_pending_transaction, tx )
 }
 
+uint64_t database::subscribe_object_changes( const object_change_filter& filter, object_changes_callback callback )
+{
+   const uint64_t subscription = _next_object_change_subscription++;
+   object_change_subscriber& subscriber = _object_change_subscribers[subscription];
+   subscriber.filter = filter;
+   subscriber.callback = std::move( callback );
+   return subscription;
+}
+
+void database::set_object_change_filter( uint64_t subscription, const object_change_filter& filter )
+{
+   auto itr = _object_change_subscribers.find( subscription );
+   FC_ASSERT( itr != _object_change_subscribers.end(), "Unknown object change subscription ${s}", ("s", subscription) );
+   itr->second.filter = filter;
+}
+
+void database::unsubscribe_object_changes( uint64_t subscription )
+{
+   _object_change_subscribers.erase( subscription );
+}
+
 void database::notify_changed_objects()
 { try {
-   if( _undo_db.enabled() ) 
-   {
-      const auto& head_undo = _undo_db.head();
-
-      // New
-      if( !new_objects.empty() )
+   if( !_undo_db.enabled() )
+      return;
+
+   // slots of the plain signals get every object with the accounts impacted by all of them
+   const bool notify_new = !new_objects.empty();
+   const bool notify_changed = !changed_objects.empty();
+   const bool notify_removed = !removed_objects.empty();
+
+   vector<object_change_subscriber*> subscribers;
+   for( auto& item : _object_change_subscribers )
+      if( item.second.filter.enabled )
+         subscribers.push_back( &item.second );
+   if( subscribers.empty() && !notify_new && !notify_changed && !notify_removed )
+      return;
+
+   const auto& head_undo = _undo_db.head();
+   vector<object_changes> changes( subscribers.size() );
+   flat_set<account_id_type> impacted;
+
+   // Hands the object to the subscribers matching it, computing its impacted accounts once if anybody needs them.
+   // A null obj is looked up in the database if needed.
+   auto dispatch = [&]( object_id_type id, const object* obj, bool signal_accounts_needed,
+                        flat_set<account_id_type>& signal_accounts,
+                        vector<object_id_type> object_changes::* ids,
+                        flat_set<account_id_type> object_changes::* accounts,
+                        bool removal )
+   {
+      bool accounts_needed = signal_accounts_needed;
+      for( size_t i = 0; i < subscribers.size() && !accounts_needed; ++i )
+         accounts_needed = subscribers[i]->filter.impacted_accounts && subscribers[i]->filter.matches( id );
+
+      impacted.clear();
+      if( accounts_needed )
       {
-        vector<object_id_type> new_ids;  new_ids.reserve(head_undo.new_ids.size());
-        flat_set<account_id_type> new_accounts_impacted;
-        for( const auto& item : head_undo.new_ids )
-        {
-          new_ids.push_back(item);
-          auto obj = find_object(item);
-          if(obj != nullptr)
-            get_relevant_accounts(obj, new_accounts_impacted, true);
-        }
-
-        GRAPHENE_TRY_NOTIFY( new_objects, new_ids, new_accounts_impacted)
+         if( obj == nullptr )
+            obj = find_object( id );
+         if( obj != nullptr )
+            get_relevant_accounts( obj, impacted, true );
       }
+      if( signal_accounts_needed )
+         signal_accounts.insert( impacted.begin(), impacted.end() );
 
-      // Changed
-      if( !changed_objects.empty() )
+      for( size_t i = 0; i < subscribers.size(); ++i )
       {
-        vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size());
-        flat_set<account_id_type> changed_accounts_impacted;
-        for( const auto& item : head_undo.old_values )
-        {
-          changed_ids.push_back(item.first);
-          get_relevant_accounts(item.second.get(), changed_accounts_impacted, true);
-        }
-
-        GRAPHENE_TRY_NOTIFY( changed_objects, changed_ids, changed_accounts_impacted)
+         const object_change_filter& filter = subscribers[i]->filter;
+         if( !filter.matches( id ) )
+            continue;
+         (changes[i].*ids).push_back( id );
+         if( filter.impacted_accounts )
+            (changes[i].*accounts).insert( impacted.begin(), impacted.end() );
+         if( removal )
+            changes[i].removed.push_back( obj );
       }
+   };
 
-      // Removed
-      if( !removed_objects.empty() )
+   // New
+   if( notify_new || !subscribers.empty() )
+   {
+      vector<object_id_type> new_ids;  new_ids.reserve(head_undo.new_ids.size());
+      flat_set<account_id_type> new_accounts_impacted;
+      for( const auto& item : head_undo.new_ids )
+         new_ids.push_back(item.id);
+      std::sort( new_ids.begin(), new_ids.end(), std::greater<object_id_type>() );
+      for( const auto& id : new_ids )
+         dispatch( id, nullptr, notify_new, new_accounts_impacted,
+                   &object_changes::new_ids, &object_changes::new_accounts_impacted, false );
+
+      if( notify_new )
+         GRAPHENE_TRY_NOTIFY( new_objects, new_ids, new_accounts_impacted)
+   }
+
+   // Changed
+   if( notify_changed || !subscribers.empty() )
+   {
+      vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size());
+      flat_set<account_id_type> changed_accounts_impacted;
+      for( const auto& item : head_undo.old_values )
       {
-        vector<object_id_type> removed_ids; removed_ids.reserve( head_undo.removed.size() );
-        vector<const object*> removed; removed.reserve( head_undo.removed.size() );
-        flat_set<account_id_type> removed_accounts_impacted;
-        for( const auto& item : head_undo.removed )
-        {
-          removed_ids.emplace_back( item.first );
-          auto obj = item.second.get();
-          removed.emplace_back( obj );
-          get_relevant_accounts(obj, removed_accounts_impacted, true);
-        }
+         changed_ids.push_back(item.id);
+         dispatch( item.id, item.value, notify_changed, changed_accounts_impacted,
+                   &object_changes::changed_ids, &object_changes::changed_accounts_impacted, false );
+      }
 
-        GRAPHENE_TRY_NOTIFY( removed_objects, removed_ids, removed, removed_accounts_impacted)
+      if( notify_changed )
+         GRAPHENE_TRY_NOTIFY( changed_objects, changed_ids, changed_accounts_impacted)
+   }
+
+   // Removed
+   if( notify_removed || !subscribers.empty() )
+   {
+      vector<object_id_type> removed_ids; removed_ids.reserve( head_undo.removed.size() );
+      vector<const object*> removed; removed.reserve( head_undo.removed.size() );
+      flat_set<account_id_type> removed_accounts_impacted;
+      for( const auto& item : head_undo.removed )
+      {
+         removed_ids.emplace_back( item.id );
+         removed.emplace_back( item.value );
+         dispatch( item.id, item.value, notify_removed, removed_accounts_impacted,
+                   &object_changes::removed_ids, &object_changes::removed_accounts_impacted, true );
       }
+
+      if( notify_removed )
+         GRAPHENE_TRY_NOTIFY( removed_objects, removed_ids, removed, removed_accounts_impacted)
+   }
+
+   for( size_t i = 0; i < subscribers.size(); ++i )
+   {
+      if( changes[i].empty() )
+         continue;
+      GRAPHENE_TRY_NOTIFY( subscribers[i]->callback, changes[i] )
    }
 } FC_CAPTURE_AND_LOG( (0) ) }
 
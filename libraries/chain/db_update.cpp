@@ -31,6 +31,7 @@
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/match_object.hpp>
 #include <graphene/chain/offer_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 #include <graphene/chain/son_proposal_object.hpp>
@@ -584,16 +585,16 @@ void process_finished_matches(database& db)
 {
 }
 
-void process_in_progress_tournaments(database& db)
+void process_in_progress_tournaments(database& db, tournament_progress_index& progress_index)
 {
-   auto& start_time_index = db.get_index_type<tournament_index>().indices().get<by_start_time>();
-   auto start_iter = start_time_index.lower_bound(boost::make_tuple(tournament_state::in_progress));
-   while (start_iter != start_time_index.end() &&
-          start_iter->get_state() == tournament_state::in_progress)
+   // Whether new matches can start only depends on the state of the tournament's matches, so only the
+   // tournaments whose matches changed since the last block need to be checked.  Changes made while checking
+   // are picked up by the next block, which is when a full scan would have seen them too.
+   for (const tournament_id_type& tournament_id : progress_index.take_changed_tournaments())
    {
-      auto next_iter = std::next(start_iter);
-      start_iter->check_for_new_matches_to_start(db);
-      start_iter = next_iter;
+      const tournament_object* tournament = db.find(tournament_id);
+      if (tournament && tournament->get_state() == tournament_state::in_progress)
+         tournament->check_for_new_matches_to_start(db);
    }
 }
 
@@ -677,7 +678,8 @@ void database::update_tournaments()
    process_finished_matches(*this);
    cancel_expired_tournaments(*this);
    start_fully_registered_tournaments(*this);
-   process_in_progress_tournaments(*this);
+   process_in_progress_tournaments(*this, get_mutable_index_type< primary_index<match_index> >()
+                                             .get_secondary_index<tournament_progress_index>());
    initiate_next_round_of_matches(*this);
    initiate_next_games(*this);
 }
@@ -26,6 +26,7 @@
 #include <graphene/db/generic_index.hpp>
 #include <graphene/chain/protocol/account.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 
 namespace graphene { namespace chain {
    class database;
@@ -360,6 +361,28 @@ namespace graphene { namespace chain {
          /** maps the referrer to the set of accounts that they have referred */
          map< account_id_type, set<account_id_type> > referred_by;
    };
+
+   /**
+    *  @brief This secondary index will allow a reverse lookup of all accounts that vote for a particular
+    *  vote_id, so that the voters of a witness, committee member, worker or SON can be found without
+    *  scanning every account.
+    */
+   class account_vote_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /** maps a vote_id to the set of accounts that currently vote for it */
+         map< vote_id_type, set<account_id_type> > vote_to_voters;
+
+      protected:
+         void remove_voter( vote_id_type vote, account_id_type voter );
+
+         flat_set<vote_id_type> before_votes;
+   };
    
    /**
     * @brief Tracks a pending payout of a single dividend payout asset 
@@ -430,7 +453,8 @@ namespace graphene { namespace chain {
                member<account_balance_object, asset_id_type, &account_balance_object::asset_type>
             >
          >,
-         ordered_unique< tag<by_asset_balance>,
+         // ranked so that holder lists can be paged and counted without walking them
+         ranked_unique< tag<by_asset_balance>,
             composite_key<
                account_balance_object,
                member<account_balance_object, asset_id_type, &account_balance_object::asset_type>,
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /// Stages of applying a block whose durations are recorded by @ref apply_metrics
+   enum class apply_phase : uint8_t
+   {
+      block,
+      transactions,
+      witness_schedule,
+      update_global_dynamic_data,
+      perform_chain_maintenance,
+      check_ending_lotteries,
+      place_delayed_bets,
+      clear_expired_transactions,
+      clear_expired_proposals,
+      clear_expired_orders,
+      update_expired_feeds,
+      update_core_exchange_rates,
+      update_withdraw_permissions,
+      update_tournaments,
+      update_betting_markets,
+      finalize_expired_offers,
+      notify_applied_block,
+      notify_changed_objects,
+      phase_count
+   };
+
+   /// Latency summary of one operation type or block phase, durations are in nanoseconds
+   struct apply_latency_stats
+   {
+      std::string name;
+      uint64_t    count    = 0;
+      uint64_t    total_ns = 0;
+      uint64_t    p50_ns   = 0;
+      uint64_t    p99_ns   = 0;
+      uint64_t    p999_ns  = 0;
+      uint64_t    max_ns   = 0;
+   };
+
+   struct apply_metrics_report
+   {
+      bool                             enabled = false;
+      std::vector<apply_latency_stats> operations;
+      std::vector<apply_latency_stats> phases;
+   };
+
+   /**
+    *  @brief Log-linear histogram of durations in nanoseconds.
+    *
+    *  Durations below 8ns are counted exactly, longer ones in 8 buckets per power of two, so percentiles are
+    *  reported with at most 12.5% error.
+    */
+   class latency_histogram
+   {
+      public:
+         void record( uint64_t ns );
+         void merge( const latency_histogram& other );
+         /// Returns the upper bound of the bucket holding the given fraction of the recorded durations
+         uint64_t percentile( double fraction )const;
+         apply_latency_stats stats( std::string name )const;
+
+         uint64_t count()const { return _count; }
+
+      private:
+         static const uint32_t sub_bucket_bits = 3;
+         static const uint32_t max_exponent    = 40;
+         static const size_t   bucket_count    = ( max_exponent - sub_bucket_bits + 2 ) << sub_bucket_bits;
+
+         static size_t   bucket_of( uint64_t ns );
+         static uint64_t bucket_upper_bound( size_t bucket );
+
+         std::array<uint32_t, bucket_count> _buckets{};
+         uint64_t                           _count = 0;
+         uint64_t                           _total = 0;
+         uint64_t                           _max   = 0;
+   };
+
+   /**
+    *  @brief Opt-in latencies of operation evaluation and block phases.
+    *
+    *  Each thread records into its own histograms, which are merged when a report is requested.  When disabled
+    *  nothing is timed and recording costs a single relaxed load.
+    *
+    *  Recording is not lock-free: every shard has a mutex, which only the recording thread takes except while
+    *  @ref report or @ref reset read the shard, so it is uncontended on the block applying path.
+    */
+   class apply_metrics
+   {
+      public:
+         typedef std::chrono::steady_clock clock;
+
+         apply_metrics();
+         ~apply_metrics();
+
+         void enable( bool enabled ) { _enabled.store( enabled, std::memory_order_relaxed ); }
+         bool enabled()const { return _enabled.load( std::memory_order_relaxed ); }
+
+         /// Both take the calling thread's shard mutex, see the class description
+         void record_operation( int which, uint64_t ns );
+         void record_phase( apply_phase phase, uint64_t ns );
+
+         /// Calls @ref f, recording its duration under @ref phase if enabled
+         template<typename Functor>
+         void time_phase( apply_phase phase, Functor&& f )
+         {
+            if( !enabled() )
+            {
+               f();
+               return;
+            }
+            auto start = clock::now();
+            f();
+            record_phase( phase, elapsed_ns( start ) );
+         }
+
+         static uint64_t elapsed_ns( clock::time_point start )
+         {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now() - start ).count();
+         }
+
+         /// Merges the histograms of all threads, omitting operation types and phases never recorded
+         apply_metrics_report report()const;
+         /// Writes the report to the log, operation types ordered by total time
+         void log_report()const;
+         void reset();
+
+      private:
+         struct shard;
+         shard& local_shard();
+
+         const uint64_t                       _instance_id;
+         std::atomic<bool>                    _enabled;
+         mutable std::mutex                   _shards_mutex;
+         std::vector< std::unique_ptr<shard> > _shards;
+   };
+
+} }
+
+FC_REFLECT( graphene::chain::apply_latency_stats, (name)(count)(total_ns)(p50_ns)(p99_ns)(p999_ns)(max_ns) )
+FC_REFLECT( graphene::chain::apply_metrics_report, (enabled)(operations)(phases) )
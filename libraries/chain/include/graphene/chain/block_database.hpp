@@ -22,14 +22,48 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <atomic>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <graphene/chain/protocol/block.hpp>
 
 #include <fc/filesystem.hpp>
 
 namespace graphene { namespace chain {
-   class index_entry;
+   namespace detail { struct mapped_file; struct mapped_range; }
 
+   /** One fixed size record of the index file, stored at offset sizeof(index_entry) * block_num */
+   struct index_entry
+   {
+      uint64_t      block_pos = 0;
+      uint32_t      block_size = 0;
+      block_id_type block_id;
+   };
+
+   /**
+    *  @brief A read only view of a block exactly as it is stored in the blocks file.
+    *
+    *  The view holds a reference to the memory mapping it points into, so it stays
+    *  valid after the database has been grown, remapped or closed.
+    */
+   struct packed_block_view
+   {
+      const char*                 data = nullptr;
+      uint32_t                    size = 0;
+      block_id_type               id;
+      std::shared_ptr<const void> mapping;
+   };
+
+   /**
+    *  @brief Append only storage of irreversible blocks.
+    *
+    *  Both the index and the blocks file are memory mapped for reading, so any number
+    *  of threads may fetch blocks at the same time without seeking a shared stream or
+    *  taking a lock.  Writes are still done by a single thread through the streams;
+    *  after each write the mapped size is published and the files are remapped when
+    *  they grow past the reserved capacity.
+    */
    class block_database 
    {
       public:
@@ -47,14 +81,37 @@ namespace graphene { namespace chain {
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
+
+         /** @return the packed bytes of block @ref block_num without copying or unpacking them */
+         optional<packed_block_view> fetch_packed_by_number( uint32_t block_num )const;
+         /** @return the packed bytes of block @ref id without copying or unpacking them */
+         optional<packed_block_view> fetch_packed( const block_id_type& id )const;
 	 
          void set_replay_mode(bool mode);
       private:
          bool replay_mode = false;
 
          optional<index_entry> last_index_entry()const;
+         optional<index_entry> read_index_entry( uint32_t block_num )const;
+         /** @return the size of the index file up to and including its last entry pointing at a readable block */
+         uint64_t valid_index_size( uint64_t index_size );
+         static bool is_valid_entry( const detail::mapped_range& blocks, const index_entry& e );
+
+         void publish_size( const fc::path& file, std::shared_ptr<const detail::mapped_file>& map,
+                            std::atomic<uint64_t>& size, uint64_t new_size );
+
          fc::path _index_filename;
-         mutable std::fstream _blocks;
-         mutable std::fstream _block_num_to_pos;
+         fc::path _blocks_filename;
+         std::fstream _blocks;
+         std::fstream _block_num_to_pos;
+
+         /// Remapping is rare and only done by the writer; readers only load the shared pointers
+         std::mutex                                 _remap_mutex;
+         std::shared_ptr<const detail::mapped_file> _index_map;
+         std::shared_ptr<const detail::mapped_file> _blocks_map;
+         std::atomic<uint64_t>                      _index_size{0};
+         std::atomic<uint64_t>                      _blocks_size{0};
    };
 } }
+
+FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) )
@@ -30,6 +30,9 @@
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
+#include <graphene/chain/apply_metrics.hpp>
+#include <graphene/chain/read_write_gate.hpp>
+#include <graphene/chain/worker_pool.hpp>
 
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/object.hpp>
@@ -44,8 +47,12 @@
 
 #include <fc/log/logger.hpp>
 
+#include <atomic>
+#include <functional>
 #include <map>
 
+namespace fc { class thread; }
+
 namespace graphene { namespace chain {
    using graphene::db::abstract_object;
    using graphene::db::object;
@@ -54,6 +61,49 @@ namespace graphene { namespace chain {
 
    struct budget_record;
 
+   /**
+    *  Selects the objects reported to a subscriber of @ref database::subscribe_object_changes
+    */
+   struct object_change_filter
+   {
+      /// Whether the subscriber currently wants any notification at all
+      bool                 enabled = true;
+      /// Object types of interest as object_id_type::space_type(), every type if empty
+      flat_set<uint16_t>   space_types;
+      /// Whether the subscriber uses the impacted accounts, which are only computed if some subscriber does
+      bool                 impacted_accounts = true;
+
+      template<typename ObjectType>
+      object_change_filter& add_type()
+      {
+         space_types.insert( uint16_t( (ObjectType::space_id << 8) | ObjectType::type_id ) );
+         return *this;
+      }
+      bool matches( object_id_type id )const
+      {
+         return enabled && ( space_types.empty() || space_types.find( id.space_type() ) != space_types.end() );
+      }
+   };
+
+   /**
+    *  The objects of a block matching one subscriber's filter, with the accounts impacted by them if requested
+    */
+   struct object_changes
+   {
+      vector<object_id_type>     new_ids;
+      flat_set<account_id_type>  new_accounts_impacted;
+      vector<object_id_type>     changed_ids;
+      flat_set<account_id_type>  changed_accounts_impacted;
+      vector<object_id_type>     removed_ids;
+      /// last values of the removed objects, in the order of removed_ids
+      vector<const object*>      removed;
+      flat_set<account_id_type>  removed_accounts_impacted;
+
+      bool empty()const { return new_ids.empty() && changed_ids.empty() && removed_ids.empty(); }
+   };
+
+   typedef std::function<void(const object_changes&)> object_changes_callback;
+
    /**
     *   @class database
     *   @brief tracks the blockchain state in an extensible manner
@@ -109,6 +159,24 @@ namespace graphene { namespace chain {
           * replaying blockchain history. When this method exits successfully, the database will be open.
           */
          void reindex(fc::path data_dir);
+         /// Sets how many blocks a reader thread may fetch and check ahead of the blocks being replayed,
+         /// 0 reads every block on the calling thread
+         void set_replay_prefetch_blocks( uint32_t blocks );
+
+         /**
+          *  Runs @ref f on one of the read threads, between the blocks and transactions applied by the chain
+          *  thread, so that the state it sees is never half changed.  The calling fc thread keeps running its other
+          *  tasks meanwhile, block application included.  Without read threads @ref f runs on the calling thread.
+          *
+          *  @ref f must only read the object database, and should call check_read_preemption() between its steps.
+          *  When the chain thread needs to change the state, @ref f is stopped at its next check and run again
+          *  from the start after the change, at most max_read_attempts times.
+          */
+         void run_read( const std::function<void()>& f )const;
+         /// Throws read_preempted_exception if the calling read from run_read() has to give way to a write
+         void check_read_preemption()const { _state_gate.check_preempted(); }
+         /// Sets the number of threads used by run_read(), 0 runs reads on the calling thread
+         void set_read_threads( size_t threads );
 
          /**
           * @brief wipe Delete database from disk, and potentially the raw chain as well.
@@ -118,6 +186,8 @@ namespace graphene { namespace chain {
           */
          void wipe(const fc::path& data_dir, bool include_blocks);
          void close(bool rewind = true);
+         /// Emits saving_object_database, then writes the object database to disk
+         void flush();
 
          //////////////////// db_block.cpp ////////////////////
 
@@ -129,6 +199,8 @@ namespace graphene { namespace chain {
          bool                       is_known_transaction( const transaction_id_type& id )const;
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
+         /// The bytes of block @ref id as stored in the block database, without unpacking them
+         optional<packed_block_view> fetch_packed_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
          const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
@@ -150,6 +222,16 @@ namespace graphene { namespace chain {
          bool _push_block( const signed_block& b );
          processed_transaction _push_transaction( const signed_transaction& trx );
 
+         /**
+          *  Recovers the public keys of the transaction signatures of @ref block on a pool of
+          *  worker threads and caches them in the transactions, so that applying the block only
+          *  has to check the authorities.  Does nothing if @ref skip skips signature checks.
+          */
+         void precompute_parallel( const signed_block& block, uint32_t skip = skip_nothing )const;
+         /// Sets the number of threads used by precompute_parallel() and the maintenance vote tally,
+         /// 0 does all of that work on the calling thread
+         void set_precompute_threads( size_t threads );
+
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
 
@@ -191,6 +273,12 @@ namespace graphene { namespace chain {
          // the bookie plugin depends on change notifications that are skipped during normal replays
          void force_slow_replays();
 
+         /// Enables timing of operation evaluation and block phases, logging a report every @ref log_interval_blocks
+         /// blocks unless it is 0
+         void enable_apply_metrics( bool enabled, uint32_t log_interval_blocks = 0 );
+         const apply_metrics& get_apply_metrics()const { return _apply_metrics; }
+         apply_metrics& get_apply_metrics() { return _apply_metrics; }
+
          string to_pretty_string( const asset& a )const;
 
          /**
@@ -203,6 +291,20 @@ namespace graphene { namespace chain {
           */
          fc::signal<void(const signed_block&)>           applied_block;
 
+         /**
+          *  This signal is emitted while reindexing, after the last block applied with the undo database
+          *  disabled and before it is enabled again.  Plugins which batch their writes over several of
+          *  those blocks must write them out here, afterwards every change is undone with its block.
+          */
+         fc::signal<void()>                              replayed_irreversible_blocks;
+
+         /**
+          *  This signal is emitted before the object database is written to disk by flush(), which happens
+          *  periodically while reindexing and on close.  Plugins which keep changes in memory to write them
+          *  later must write them out here, or the saved state would miss them.
+          */
+         fc::signal<void()>                              saving_object_database;
+
          /**
           * This signal is emitted any time a new transaction is added to the pending
           * block state.
@@ -226,6 +328,18 @@ namespace graphene { namespace chain {
           */
          fc::signal<void(const vector<object_id_type>&, const vector<const object*>&, const flat_set<account_id_type>&)>  removed_objects;
 
+         /**
+          *  Calls @ref callback after each block with the new, changed and removed objects matching @ref filter.
+          *  Impacted accounts are computed once per object, and only for objects some subscriber needs them for,
+          *  while every slot of the signals above makes them computed for all objects.
+          *  The callback should not yield, and must not subscribe or unsubscribe.
+          *
+          *  @return the subscription id to pass to @ref set_object_change_filter and @ref unsubscribe_object_changes
+          */
+         uint64_t subscribe_object_changes( const object_change_filter& filter, object_changes_callback callback );
+         void     set_object_change_filter( uint64_t subscription, const object_change_filter& filter );
+         void     unsubscribe_object_changes( uint64_t subscription );
+
          //////////////////// db_witness_schedule.cpp ////////////////////
 
          /**
@@ -520,6 +634,14 @@ namespace graphene { namespace chain {
          void notify_changed_objects();
 
       private:
+         struct object_change_subscriber
+         {
+            object_change_filter     filter;
+            object_changes_callback  callback;
+         };
+         std::map<uint64_t, object_change_subscriber> _object_change_subscribers;
+         uint64_t                                     _next_object_change_subscription = 1;
+
          std::mutex                             _pending_tx_session_mutex;
          optional<undo_database::session>       _pending_tx_session;
          vector< unique_ptr<op_evaluator> >     _operation_evaluators;
@@ -600,7 +722,7 @@ namespace graphene { namespace chain {
             uint32_t get_gpos_current_subperiod();
 
          template<class Type>
-         void perform_account_maintenance(Type tally_helper);
+         void perform_account_maintenance(Type& tally_helper);
          ///@}
          ///@}
 
@@ -654,6 +776,21 @@ namespace graphene { namespace chain {
 
          fc::hash_ctr_rng<secret_hash_type, 20> _random_number_generator;
          bool                              _slow_replays = false;
+         uint32_t                          _replay_prefetch_blocks = 1000;
+
+         apply_metrics                     _apply_metrics;
+         uint32_t                          _apply_metrics_log_blocks = 0;
+
+         /// Threads recovering signature keys ahead of block application and tallying votes, created on first use
+         size_t                               _precompute_threads = std::thread::hardware_concurrency();
+         mutable std::unique_ptr<worker_pool> _precompute_pool;
+         /// Returns the worker threads, or nullptr if all work is done on the calling thread
+         worker_pool* get_precompute_pool()const;
+
+         /// Held for writing while the state changes, and for reading by run_read()
+         mutable read_write_gate                     _state_gate;
+         std::vector< std::shared_ptr<fc::thread> >  _read_threads;
+         mutable std::atomic<uint32_t>               _next_read_thread{0};
 
          /**
           * Whether database is successfully opened or not.
@@ -665,6 +802,8 @@ namespace graphene { namespace chain {
          bool                              _opened = false;
          /// Tracks assets affected by bitshares-core issue #453 before hard fork #615 in one block
          flat_set<asset_id_type>           _issue_453_affected_assets;
+         /// Active NFT lotteries ending on sold out whose tokens are all sold, kept by check_ending_nft_lotteries()
+         flat_set<nft_metadata_id_type>    _sold_out_nft_lotteries;
 
          /// Pointers to core asset object and global objects who will have immutable addresses after created
          ///@{
@@ -103,6 +103,30 @@ namespace graphene { namespace chain {
    > match_object_multi_index_type;
    typedef generic_index<match_object, match_object_multi_index_type> match_index;
 
+   /**
+    *  @brief Tracks the tournaments whose matches changed, so that progression only looks at those.
+    *
+    *  A match counts as changed when it is created or removed, or when its state or players change, which also
+    *  covers the changes reverted when blocks are popped.  All matches are seen as created when the database is
+    *  loaded, so every tournament is looked at once after a restart.
+    */
+   class tournament_progress_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /// Returns the tournaments whose matches changed since the last call, in id order
+         flat_set<tournament_id_type> take_changed_tournaments();
+
+      protected:
+         flat_set<tournament_id_type> changed_tournaments;
+         match_state                  before_state;
+         vector<account_id_type>      before_players;
+   };
+
    template<typename Stream>
    inline Stream& operator<<( Stream& s, const match_object& match_obj )
    {
@@ -170,6 +170,28 @@ namespace graphene { namespace chain {
    >;
    using nft_index = generic_index<nft_object, nft_multi_index_type>;
 
+   /**
+    * @brief Records the metadata whose lottery options or tokens changed
+    *
+    * Added to both the metadata index and the token index, so that lotteries ending on sold out are found
+    * without counting the tokens of every active lottery in every block.
+    */
+   class nft_lottery_change_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override { mark( obj ); }
+         virtual void object_removed( const object& obj ) override  { mark( obj ); }
+         virtual void object_modified( const object& after ) override { mark( after ); }
+
+         /// Returns the metadata marked since the last call
+         flat_set<nft_metadata_id_type> take_changed_metadata();
+
+      private:
+         void mark( const object& obj );
+
+         flat_set<nft_metadata_id_type> changed_metadata;
+   };
+
    using nft_lottery_balance_index_type = multi_index_container<
       nft_lottery_balance_object,
       indexed_by<
@@ -95,6 +95,7 @@ namespace graphene { namespace chain {
          account_id_type                      account; /// the account this operation applies to
          operation_history_id_type            operation_id;
          uint32_t                             sequence = 0; /// the operation position within the given account
+         int32_t                              operation_type = 0; /// the operation tag, as returned by operation::which()
          account_transaction_history_id_type  next;
    };
    
@@ -102,6 +103,7 @@ namespace graphene { namespace chain {
 struct by_seq;
 struct by_op;
 struct by_opid;
+struct by_type_seq;
 
 typedef multi_index_container<
    operation_history_object,
@@ -130,6 +132,13 @@ typedef multi_index_container<
       >,
       ordered_non_unique< tag<by_opid>,
          member< account_transaction_history_object, operation_history_id_type, &account_transaction_history_object::operation_id>
+      >,
+      ordered_unique< tag<by_type_seq>,
+         composite_key< account_transaction_history_object,
+            member< account_transaction_history_object, account_id_type, &account_transaction_history_object::account>,
+            member< account_transaction_history_object, int32_t, &account_transaction_history_object::operation_type>,
+            member< account_transaction_history_object, uint32_t, &account_transaction_history_object::sequence>
+         >
       >
    >
 > account_transaction_history_multi_index_type;
@@ -142,7 +151,7 @@ typedef generic_index<account_transaction_history_object, account_transaction_hi
 FC_REFLECT_DERIVED( graphene::chain::operation_history_object, (graphene::chain::object),
                     (op)(result)(block_num)(trx_in_block)(op_in_trx)(virtual_op) )
 FC_REFLECT_DERIVED( graphene::chain::account_transaction_history_object, (graphene::chain::object),
-                    (account)(operation_id)(sequence)(next) )
+                    (account)(operation_id)(sequence)(operation_type)(next) )
 
 GRAPHENE_EXTERNAL_SERIALIZATION( extern, graphene::chain::operation_history_object )
 GRAPHENE_EXTERNAL_SERIALIZATION( extern, graphene::chain::account_transaction_history_object )
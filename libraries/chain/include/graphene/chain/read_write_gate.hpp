@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @brief Keeps readers on other threads out of the object database while it is being changed.
+    *
+    *  Any number of readers may hold the gate at once, a writer holds it alone.  Once a writer is waiting, no
+    *  new readers are let in, and the readers already running are preempted: the next check_preempted() they
+    *  call throws read_preempted_exception, they leave the gate and start again after the write.  A writer
+    *  thus only waits until each running read reaches its next check, not for the whole read.  The writing
+    *  thread may enter the gate again, both as writer and as reader, which lets it call into code that takes
+    *  the gate too.
+    */
+   class read_write_gate
+   {
+      public:
+         class read_guard
+         {
+            public:
+               explicit read_guard( read_write_gate& gate ) : _gate( gate ) { _counted = _gate.lock_shared(); }
+               ~read_guard() { if( _counted ) _gate.unlock_shared(); }
+               read_guard( const read_guard& ) = delete;
+               read_guard& operator=( const read_guard& ) = delete;
+
+            private:
+               read_write_gate& _gate;
+               bool             _counted;
+         };
+
+         class write_guard
+         {
+            public:
+               explicit write_guard( read_write_gate& gate ) : _gate( gate ) { _gate.lock(); }
+               ~write_guard() { _gate.unlock(); }
+               write_guard( const write_guard& ) = delete;
+               write_guard& operator=( const write_guard& ) = delete;
+
+            private:
+               read_write_gate& _gate;
+         };
+
+         /// Returns false if the calling thread is the writer, which needs no lock to read
+         bool lock_shared();
+         void unlock_shared();
+         void lock();
+         void unlock();
+
+         /// Throws read_preempted_exception if the calling thread holds the gate for reading and a writer waits
+         void check_preempted()const;
+
+      private:
+         std::mutex              _mutex;
+         std::condition_variable _readers_cv;
+         std::condition_variable _writers_cv;
+         uint32_t                _readers = 0;
+         std::atomic<uint32_t>   _waiting_writers{0};
+         uint32_t                _write_depth = 0;
+         std::thread::id         _writer;
+   };
+
+} }
@@ -242,6 +242,38 @@ namespace graphene { namespace chain {
     */
    typedef generic_index<vesting_balance_object, vesting_balance_multi_index_type> vesting_balance_index;
 
+   /**
+    * @brief Keeps, for each asset and vesting balance type, the vested total of every owner
+    *
+    * Updated as vesting balances change, so that dividend distribution does not have to walk all vesting balances
+    * of the dividend asset to find holders' vested amounts.
+    */
+   class vesting_balance_holder_index : public secondary_index
+   {
+      public:
+         struct holder_totals
+         {
+            /// Sum of the vesting balances of each owner, owners whose balances sum to zero are omitted
+            std::map<account_id_type, share_type> amounts;
+            /// Number of vesting balance objects, including those with a zero balance
+            uint32_t   balance_count = 0;
+            share_type total;
+         };
+
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after ) override;
+
+         const holder_totals& get_holder_totals( asset_id_type asset_id, vesting_balance_type balance_type )const;
+
+      private:
+         void add( const vesting_balance_object& vbo );
+         void subtract( const vesting_balance_object& vbo );
+
+         std::map< std::pair<asset_id_type, vesting_balance_type>, holder_totals > _totals;
+   };
+
 } } // graphene::chain
 
 FC_REFLECT(graphene::chain::linear_vesting_policy,
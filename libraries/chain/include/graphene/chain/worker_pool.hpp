@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @brief A fixed set of threads executing queued tasks in FIFO order.
+    *
+    *  Tasks must not touch the object database unless the thread which owns the
+    *  database is known to be blocked on their results.
+    */
+   class worker_pool
+   {
+      public:
+         explicit worker_pool( size_t thread_count );
+         ~worker_pool();
+
+         size_t size()const { return _threads.size(); }
+
+         /// Queues @ref f and returns a future for its result
+         template<typename Functor>
+         auto post( Functor&& f ) -> std::future<decltype(f())>
+         {
+            typedef decltype(f()) result_type;
+            auto task = std::make_shared< std::packaged_task<result_type()> >( std::forward<Functor>(f) );
+            std::future<result_type> result = task->get_future();
+            enqueue( [task]() { (*task)(); } );
+            return result;
+         }
+
+         /**
+          *  Splits [0, count) into at most size() + 1 contiguous ranges and calls f( begin, end ) for each
+          *  of them, the first range on the calling thread and the others on the pool.  Returns when all
+          *  ranges are done and rethrows the first exception thrown by any of them.
+          */
+         void run_chunked( size_t count, const std::function<void(size_t, size_t)>& f );
+
+      private:
+         void enqueue( std::function<void()> task );
+         void worker_loop();
+
+         std::mutex                          _mutex;
+         std::condition_variable             _cv;
+         std::deque< std::function<void()> > _queue;
+         bool                                _stopping = false;
+         std::vector<std::thread>            _threads;
+   };
+
+} }
@@ -360,6 +360,41 @@ namespace graphene { namespace chain {
    }
 #endif
 
+   void tournament_progress_index::object_inserted(const object& obj)
+   {
+      assert( dynamic_cast<const match_object*>(&obj) ); // for debug only
+      changed_tournaments.insert(static_cast<const match_object&>(obj).tournament_id);
+   }
+
+   void tournament_progress_index::object_removed(const object& obj)
+   {
+      assert( dynamic_cast<const match_object*>(&obj) ); // for debug only
+      changed_tournaments.insert(static_cast<const match_object&>(obj).tournament_id);
+   }
+
+   void tournament_progress_index::about_to_modify(const object& before)
+   {
+      assert( dynamic_cast<const match_object*>(&before) ); // for debug only
+      const match_object& match = static_cast<const match_object&>(before);
+      before_state = match.get_state();
+      before_players = match.players;
+   }
+
+   void tournament_progress_index::object_modified(const object& after)
+   {
+      assert( dynamic_cast<const match_object*>(&after) ); // for debug only
+      const match_object& match = static_cast<const match_object&>(after);
+      if (match.get_state() != before_state || match.players != before_players)
+         changed_tournaments.insert(match.tournament_id);
+   }
+
+   flat_set<tournament_id_type> tournament_progress_index::take_changed_tournaments()
+   {
+      flat_set<tournament_id_type> result;
+      result.swap(changed_tournaments);
+      return result;
+   }
+
 } } // graphene::chain
 
 namespace fc {
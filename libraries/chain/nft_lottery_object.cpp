@@ -167,5 +167,20 @@ namespace graphene
             end_op.lottery_id = get_id();
             db.apply_operation(eval, end_op);
         }
+
+        void nft_lottery_change_index::mark(const object &obj)
+        {
+            if (obj.id.type() == nft_metadata_object::type_id)
+                changed_metadata.insert(obj.id);
+            else
+                changed_metadata.insert(static_cast<const nft_object &>(obj).nft_metadata_id);
+        }
+
+        flat_set<nft_metadata_id_type> nft_lottery_change_index::take_changed_metadata()
+        {
+            flat_set<nft_metadata_id_type> result;
+            result.swap(changed_metadata);
+            return result;
+        }
     } // namespace chain
 } // namespace graphene
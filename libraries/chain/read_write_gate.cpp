@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/read_write_gate.hpp>
+#include <graphene/chain/exceptions.hpp>
+
+namespace graphene { namespace chain {
+
+/// The gate the calling thread holds for reading, if any
+static thread_local const read_write_gate* current_read_gate = nullptr;
+
+bool read_write_gate::lock_shared()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   if( _write_depth > 0 && _writer == std::this_thread::get_id() )
+      return false;
+   _readers_cv.wait( lock, [this]() { return _write_depth == 0 && _waiting_writers == 0; } );
+   ++_readers;
+   current_read_gate = this;
+   return true;
+}
+
+void read_write_gate::unlock_shared()
+{
+   current_read_gate = nullptr;
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( --_readers == 0 && _waiting_writers > 0 )
+      _writers_cv.notify_one();
+}
+
+void read_write_gate::lock()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   if( _write_depth > 0 && _writer == std::this_thread::get_id() )
+   {
+      ++_write_depth;
+      return;
+   }
+   ++_waiting_writers;
+   _writers_cv.wait( lock, [this]() { return _readers == 0 && _write_depth == 0; } );
+   --_waiting_writers;
+   _writer = std::this_thread::get_id();
+   _write_depth = 1;
+}
+
+void read_write_gate::unlock()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( --_write_depth > 0 )
+      return;
+   _writer = std::thread::id();
+   if( _waiting_writers > 0 )
+      _writers_cv.notify_one();
+   else
+      _readers_cv.notify_all();
+}
+
+void read_write_gate::check_preempted()const
+{
+   if( current_read_gate == this && _waiting_writers > 0 )
+      FC_THROW_EXCEPTION( read_preempted_exception, "A write is waiting for this read to end" );
+}
+
+} }
@@ -276,6 +276,62 @@ asset vesting_balance_object::get_allowed_withdraw(const time_point_sec& now)con
    return policy.visit(get_allowed_withdraw_visitor(balance, now, amount));
 }
 
+void vesting_balance_holder_index::object_inserted( const object& obj )
+{
+   add( static_cast<const vesting_balance_object&>( obj ) );
+}
+
+void vesting_balance_holder_index::object_removed( const object& obj )
+{
+   subtract( static_cast<const vesting_balance_object&>( obj ) );
+}
+
+void vesting_balance_holder_index::about_to_modify( const object& before )
+{
+   subtract( static_cast<const vesting_balance_object&>( before ) );
+}
+
+void vesting_balance_holder_index::object_modified( const object& after )
+{
+   add( static_cast<const vesting_balance_object&>( after ) );
+}
+
+void vesting_balance_holder_index::add( const vesting_balance_object& vbo )
+{
+   holder_totals& totals = _totals[ std::make_pair( vbo.balance.asset_id, vbo.balance_type ) ];
+   ++totals.balance_count;
+   totals.total += vbo.balance.amount;
+   if( vbo.balance.amount != 0 )
+      totals.amounts[vbo.owner] += vbo.balance.amount;
+}
+
+void vesting_balance_holder_index::subtract( const vesting_balance_object& vbo )
+{
+   auto itr = _totals.find( std::make_pair( vbo.balance.asset_id, vbo.balance_type ) );
+   FC_ASSERT( itr != _totals.end() );
+   holder_totals& totals = itr->second;
+   --totals.balance_count;
+   totals.total -= vbo.balance.amount;
+   if( vbo.balance.amount != 0 )
+   {
+      auto amount = totals.amounts.find( vbo.owner );
+      FC_ASSERT( amount != totals.amounts.end() );
+      amount->second -= vbo.balance.amount;
+      if( amount->second == 0 )
+         totals.amounts.erase( amount );
+   }
+   if( totals.balance_count == 0 )
+      _totals.erase( itr );
+}
+
+const vesting_balance_holder_index::holder_totals& vesting_balance_holder_index::get_holder_totals(
+      asset_id_type asset_id, vesting_balance_type balance_type )const
+{
+   static const holder_totals empty;
+   auto itr = _totals.find( std::make_pair( asset_id, balance_type ) );
+   return itr == _totals.end() ? empty : itr->second;
+}
+
 } } // graphene::chain
 
 GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::linear_vesting_policy )
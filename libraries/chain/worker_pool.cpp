@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/worker_pool.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace chain {
+
+worker_pool::worker_pool( size_t thread_count )
+{
+   _threads.reserve( thread_count );
+   for( size_t i = 0; i < thread_count; ++i )
+      _threads.emplace_back( [this]() { worker_loop(); } );
+}
+
+worker_pool::~worker_pool()
+{
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      _stopping = true;
+   }
+   _cv.notify_all();
+   for( auto& t : _threads )
+      t.join();
+}
+
+void worker_pool::enqueue( std::function<void()> task )
+{
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      _queue.push_back( std::move( task ) );
+   }
+   _cv.notify_one();
+}
+
+void worker_pool::worker_loop()
+{
+   while( true )
+   {
+      std::function<void()> task;
+      {
+         std::unique_lock<std::mutex> lock( _mutex );
+         _cv.wait( lock, [this]() { return _stopping || !_queue.empty(); } );
+         if( _queue.empty() )
+            return;
+         task = std::move( _queue.front() );
+         _queue.pop_front();
+      }
+      task();
+   }
+}
+
+void worker_pool::run_chunked( size_t count, const std::function<void(size_t, size_t)>& f )
+{
+   if( count == 0 )
+      return;
+   const size_t chunks = std::min( count, size() + 1 );
+   const size_t chunk_size = ( count + chunks - 1 ) / chunks;
+
+   std::vector< std::future<void> > pending;
+   pending.reserve( chunks );
+   for( size_t begin = chunk_size; begin < count; begin += chunk_size )
+   {
+      const size_t end = std::min( count, begin + chunk_size );
+      pending.push_back( post( [&f, begin, end]() { f( begin, end ); } ) );
+   }
+
+   std::exception_ptr first_error;
+   try
+   {
+      f( 0, std::min( count, chunk_size ) );
+   }
+   catch( ... )
+   {
+      first_error = std::current_exception();
+   }
+   for( auto& p : pending )
+   {
+      try
+      {
+         p.get();
+      }
+      catch( ... )
+      {
+         if( !first_error )
+            first_error = std::current_exception();
+      }
+   }
+   if( first_error )
+      std::rethrow_exception( first_error );
+}
+
+} }
@@ -98,6 +98,16 @@ namespace graphene { namespace db {
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /** @return the hash identifying the serialization of the objects of this index */
+         virtual fc::sha256 get_object_version()const = 0;
+         /** Packs a single object of this index the same way save() does */
+         virtual std::vector<char> pack_object( const object& obj )const = 0;
+         /**
+          *  Replaces the object with @ref id by the packed object, or removes it if @ref data is empty.
+          *  Used when replaying checkpoint segments, so no undo state is saved and no observers are notified.
+          */
+         virtual void replay_object( object_id_type id, const std::vector<char>& data ) = 0;
+
 
 
          /** @return the object with id or nullptr if not found */
@@ -184,6 +194,17 @@ namespace graphene { namespace db {
             FC_THROW_EXCEPTION( fc::assert_exception, "invalid index type" );
          }
 
+         template<typename T>
+         T& get_secondary_index()
+         {
+            for( const auto& item : _sindex )
+            {
+               T* result = dynamic_cast<T*>(item.get());
+               if( result != nullptr ) return *result;
+            }
+            FC_THROW_EXCEPTION( fc::assert_exception, "invalid index type" );
+         }
+
       protected:
          vector< shared_ptr<index_observer> >   _observers;
          vector< unique_ptr<secondary_index> >  _sindex;
@@ -336,7 +357,7 @@ namespace graphene { namespace db {
             return DerivedIndex::find( id );
          }
          
-         fc::sha256 get_object_version()const
+         virtual fc::sha256 get_object_version()const override
          {
             std::string desc = "1.0";//get_type_description<object_type>();
             return fc::sha256::hash(desc);
@@ -376,6 +397,24 @@ namespace graphene { namespace db {
             });
          }
 
+         virtual std::vector<char> pack_object( const object& obj )const override
+         {
+            return fc::raw::pack( static_cast<const object_type&>(obj) );
+         }
+
+         virtual void replay_object( object_id_type id, const std::vector<char>& data )override
+         {
+            const object* existing = DerivedIndex::find( id );
+            if( existing != nullptr )
+            {
+               for( const auto& item : _sindex )
+                  item->object_removed( *existing );
+               DerivedIndex::remove( *existing );
+            }
+            if( !data.empty() )
+               load( data );
+         }
+
          virtual const object&  load( const std::vector<char>& data )override
          {
             const auto& result = DerivedIndex::insert( fc::raw::unpack<object_type>( data ) );
@@ -28,8 +28,10 @@
 
 #include <fc/log/logger.hpp>
 
+#include <future>
 #include <map>
 #include <mutex>
+#include <unordered_set>
 
 namespace graphene { namespace db {
 
@@ -48,7 +50,10 @@ namespace graphene { namespace db {
          void open(const fc::path& data_dir );
 
          /**
-          * Saves the complete state of the object_database to disk, this could take a while
+          * Saves the state of the object_database to disk.  The first flush writes the complete state, which
+          * could take a while; later flushes only write the objects changed since the previous flush as a
+          * checkpoint segment.  Segments are merged back into the complete state in the background once
+          * there are more than max_checkpoint_segments of them.
           */
          void flush();
          void wipe(const fc::path& data_dir); // remove from disk
@@ -76,6 +81,8 @@ namespace graphene { namespace db {
          const index&  get_index()const { return get_index(T::space_id,T::type_id); }
          const index&  get_index(uint8_t space_id, uint8_t type_id)const;
          const index&  get_index(object_id_type id)const { return get_index(id.space(),id.type()); }
+         /// Calls @ref inspector for every index, ordered by space and type
+         void          inspect_all_indexes( const std::function<void(const index&)>& inspector )const;
          /// @}
 
          const object& get_object( object_id_type id )const;
@@ -85,7 +92,7 @@ namespace graphene { namespace db {
          /// in order to maintain proper undo history.
          ///@{
 
-         const object& insert( object&& obj ) { return get_mutable_index(obj.id).insert( std::move(obj) ); }
+         const object& insert( object&& obj ) { mark_changed( obj.id ); return get_mutable_index(obj.id).insert( std::move(obj) ); }
          void          remove( const object& obj ) { get_mutable_index(obj.id).remove( obj ); }
          template<typename T, typename Lambda>
          void modify( const T& obj, const Lambda& m ) {
@@ -144,6 +151,12 @@ namespace graphene { namespace db {
 
          fc::path get_data_dir()const { return _data_dir; }
 
+         /// Whether changes are recorded so that they can be undone, false while replaying irreversible blocks
+         bool undo_enabled()const { return _undo_db.enabled(); }
+
+         /// Sets the number of checkpoint segments written by flush() before they are merged, 0 never merges them
+         void set_max_checkpoint_segments( uint32_t count ) { _max_checkpoint_segments = count; }
+
          /** public for testing purposes only... should be private in practice. */
          mutable std::mutex                     _undo_db_mutex;
          undo_database                          _undo_db;
@@ -166,8 +179,25 @@ namespace graphene { namespace db {
          void save_undo_add( const object& obj );
          void save_undo_remove( const object& obj );
 
+         void mark_changed( object_id_type id ) { if( _track_changes ) _changed_objects.insert( id ); }
+         void flush_full();
+         void write_checkpoint_segment();
+         void replay_checkpoint_segments();
+         void start_compaction();
+         void finish_compaction();
+
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+
+         /// Objects created, modified or removed since the last flush, only tracked once a complete state is on disk
+         bool                                                      _track_changes = false;
+         std::unordered_set<object_id_type>                        _changed_objects;
+         /// Number of the last checkpoint segment written and of the last one merged into the complete state
+         uint64_t                                                  _last_segment = 0;
+         uint64_t                                                  _base_segment = 0;
+         uint32_t                                                  _max_checkpoint_segments = 16;
+         /// Merges segments in the background, yields the last merged segment
+         std::future<uint64_t>                                     _compaction;
    };
 
 } } // graphene::db
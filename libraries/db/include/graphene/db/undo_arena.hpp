@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/db/object.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * @class undo_chunk_pool
+    * @brief Memory chunks shared by the arenas of one undo_database, so that sessions reuse memory instead of
+    * allocating it
+    */
+   class undo_chunk_pool
+   {
+      public:
+         struct chunk
+         {
+            chunk*  next;
+            size_t  size;
+            char*   data() { return reinterpret_cast<char*>( this + 1 ); }
+         };
+
+         static const size_t chunk_size = 64 * 1024;
+
+         explicit undo_chunk_pool( size_t max_retained_chunks = 256 ) : _max_retained( max_retained_chunks ) {}
+         ~undo_chunk_pool();
+         undo_chunk_pool( const undo_chunk_pool& ) = delete;
+         undo_chunk_pool& operator=( const undo_chunk_pool& ) = delete;
+
+         /// Returns a chunk of chunk_size bytes
+         chunk* acquire();
+         /// Takes back the linked chunks first to last, freeing those beyond the retained maximum
+         void   recycle( chunk* first, chunk* last, size_t count );
+
+         static chunk* allocate( size_t size );
+         static void   free( chunk* c );
+
+      private:
+         chunk*  _free = nullptr;
+         size_t  _free_count = 0;
+         size_t  _max_retained;
+   };
+
+   /**
+    * @class undo_arena
+    * @brief Bump allocator for the objects saved by one undo_state
+    *
+    * Memory is never freed individually. Objects placed in the arena must be destroyed by their owner before
+    * release(), which hands all chunks back to the pool at once.
+    */
+   class undo_arena
+   {
+      public:
+         explicit undo_arena( undo_chunk_pool& pool ) : _pool( &pool ) {}
+         ~undo_arena() { release(); }
+         undo_arena( const undo_arena& ) = delete;
+         undo_arena& operator=( const undo_arena& ) = delete;
+
+         void*   allocate( size_t size, size_t alignment );
+         /// Copies obj into the arena
+         object* clone( const object& obj )
+         {
+            return obj.clone_into( allocate( obj.clone_size(), obj.clone_alignment() ) );
+         }
+         static void destroy( object* obj ) { obj->~object(); }
+
+         /// Takes over the memory of other, which is left empty, so that objects in it outlive other
+         void adopt( undo_arena& other );
+         /// Returns all memory to the pool
+         void release();
+
+      private:
+         struct chunk_list
+         {
+            undo_chunk_pool::chunk* first = nullptr;
+            undo_chunk_pool::chunk* last  = nullptr;
+            size_t                  count = 0;
+
+            void push_front( undo_chunk_pool::chunk* c );
+            void append( chunk_list& other );
+         };
+
+         undo_chunk_pool*   _pool;
+         /// Standard size chunks, the one being filled first
+         chunk_list         _chunks;
+         /// Chunks holding a single object too large for a standard chunk
+         chunk_list         _large;
+         char*              _pos = nullptr;
+         char*              _end = nullptr;
+   };
+
+   struct undo_id_table_no_value {};
+
+   /**
+    * @class undo_id_table
+    * @brief Open addressing hash table keyed by object_id_type, with linear probing
+    *
+    * clear() keeps the capacity, so a table reused by successive sessions stops allocating once it is large
+    * enough.
+    */
+   template<typename Value>
+   class undo_id_table
+   {
+      public:
+         struct entry
+         {
+            object_id_type id;
+            Value          value;
+         };
+
+         class const_iterator : public std::iterator<std::forward_iterator_tag, const entry>
+         {
+            public:
+               const_iterator( const entry* pos, const entry* end ) : _pos( pos ), _end( end ) { skip_empty(); }
+
+               const entry& operator*()const  { return *_pos; }
+               const entry* operator->()const { return _pos; }
+               const_iterator& operator++() { ++_pos; skip_empty(); return *this; }
+               bool operator==( const const_iterator& other )const { return _pos == other._pos; }
+               bool operator!=( const const_iterator& other )const { return _pos != other._pos; }
+
+            private:
+               void skip_empty() { while( _pos != _end && _pos->id.number == empty_key ) ++_pos; }
+
+               const entry* _pos;
+               const entry* _end;
+         };
+
+         const_iterator begin()const { return const_iterator( _slots.data(), _slots.data() + _slots.size() ); }
+         const_iterator end()const   { return const_iterator( _slots.data() + _slots.size(), _slots.data() + _slots.size() ); }
+
+         size_t size()const  { return _size; }
+         bool   empty()const { return _size == 0; }
+
+         Value* find( object_id_type id )
+         {
+            if( _size == 0 )
+               return nullptr;
+            for( size_t i = home( id.number ); ; i = ( i + 1 ) & mask() )
+            {
+               if( _slots[i].id.number == id.number )
+                  return &_slots[i].value;
+               if( _slots[i].id.number == empty_key )
+                  return nullptr;
+            }
+         }
+         const Value* find( object_id_type id )const { return const_cast<undo_id_table*>( this )->find( id ); }
+         bool contains( object_id_type id )const { return find( id ) != nullptr; }
+
+         /// Returns the value of id and true if it was inserted, default-constructing it if it was absent
+         std::pair<Value*, bool> insert( object_id_type id )
+         {
+            if( ( _size + 1 ) * 2 > _slots.size() )
+               grow();
+            size_t i = home( id.number );
+            for( ; _slots[i].id.number != empty_key; i = ( i + 1 ) & mask() )
+               if( _slots[i].id.number == id.number )
+                  return std::make_pair( &_slots[i].value, false );
+            _slots[i].id = id;
+            _slots[i].value = Value();
+            ++_size;
+            return std::make_pair( &_slots[i].value, true );
+         }
+
+         bool erase( object_id_type id )
+         {
+            if( _size == 0 )
+               return false;
+            size_t i = home( id.number );
+            for( ; _slots[i].id.number != id.number; i = ( i + 1 ) & mask() )
+               if( _slots[i].id.number == empty_key )
+                  return false;
+            // shift the following entries of the probe sequence back instead of leaving a tombstone
+            for( size_t j = ( i + 1 ) & mask(); _slots[j].id.number != empty_key; j = ( j + 1 ) & mask() )
+            {
+               size_t k = home( _slots[j].id.number );
+               bool stays = ( i <= j ) ? ( i < k && k <= j ) : ( i < k || k <= j );
+               if( stays )
+                  continue;
+               _slots[i] = std::move( _slots[j] );
+               i = j;
+            }
+            _slots[i].id.number = empty_key;
+            --_size;
+            return true;
+         }
+
+         void clear()
+         {
+            if( _size == 0 )
+               return;
+            // do not keep sweeping a table that was grown by one exceptionally large session
+            if( _slots.size() > shrink_threshold && _size * 8 < _slots.size() )
+            {
+               std::vector<entry>( size_t(min_capacity), empty_entry() ).swap( _slots );
+               _shift = 64 - min_capacity_bits;
+            }
+            else
+            {
+               for( auto& e : _slots )
+                  e.id.number = empty_key;
+            }
+            _size = 0;
+         }
+
+      private:
+         static const uint64_t empty_key         = uint64_t(-1);
+         static const size_t   min_capacity_bits = 4;
+         static const size_t   min_capacity      = size_t(1) << min_capacity_bits;
+         static const size_t   shrink_threshold  = 4096;
+
+         static entry empty_entry()
+         {
+            entry e;
+            e.id.number = empty_key;
+            return e;
+         }
+
+         size_t mask()const { return _slots.size() - 1; }
+         /// Fibonacci hashing, instance numbers of one type are consecutive and would cluster otherwise
+         size_t home( uint64_t key )const { return size_t( ( key * 0x9E3779B97F4A7C15ull ) >> _shift ); }
+
+         void grow()
+         {
+            std::vector<entry> old( _slots.empty() ? size_t(min_capacity) : _slots.size() * 2, empty_entry() );
+            old.swap( _slots );
+            size_t bits = min_capacity_bits;
+            while( ( size_t(1) << bits ) < _slots.size() )
+               ++bits;
+            _shift = 64 - bits;
+            for( auto& e : old )
+            {
+               if( e.id.number == empty_key )
+                  continue;
+               size_t i = home( e.id.number );
+               while( _slots[i].id.number != empty_key )
+                  i = ( i + 1 ) & mask();
+               _slots[i] = std::move( e );
+            }
+         }
+
+         std::vector<entry> _slots;
+         size_t             _size  = 0;
+         uint32_t           _shift = 64;
+   };
+
+   typedef undo_id_table<undo_id_table_no_value> undo_id_set;
+
+} } // graphene::db
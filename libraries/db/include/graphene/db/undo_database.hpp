@@ -23,6 +23,7 @@
  */
 #pragma once
 #include <graphene/db/object.hpp>
+#include <graphene/db/undo_arena.hpp>
 #include <deque>
 #include <fc/exception/exception.hpp>
 
@@ -32,12 +33,24 @@ namespace graphene { namespace db {
    using fc::flat_set;
    class object_database;
 
+   /**
+    *  The changes of one undo session. The saved object values live in the state's arena, so that a state is
+    *  released with a few pointer updates and can be reused by later sessions without allocating.
+    */
    struct undo_state
    {
-      unordered_map<object_id_type, unique_ptr<object> >       old_values;
-      unordered_map<object_id_type, object_id_type>            old_index_next_ids;
-      std::set<object_id_type, std::greater<object_id_type> >  new_ids;
-      unordered_map<object_id_type, unique_ptr<object> >       removed;
+      explicit undo_state( undo_chunk_pool& pool ) : arena( pool ) {}
+      ~undo_state() { clear(); }
+
+      undo_id_table<object*>         old_values;
+      undo_id_table<object_id_type>  old_index_next_ids;
+      undo_id_set                    new_ids;
+      undo_id_table<object*>         removed;
+      /// Holds the values referenced by old_values and removed
+      undo_arena                     arena;
+
+      /// Destroys the saved values and empties the state, keeping the capacity of its tables
+      void clear();
    };
 
 
@@ -127,11 +140,25 @@ namespace graphene { namespace db {
          void merge();
          void commit();
 
-         uint32_t                _active_sessions = 0;
-         bool                    _disabled = true;
-         std::deque<undo_state>  _stack;
-         object_database&        _db;
-         size_t                  _max_size = 256;
+         /// Returns the state collecting changes, starting one if there is none
+         undo_state& current_state();
+         void        push_state();
+         void        pop_state_back();
+         void        pop_state_front();
+         /// Reverts the changes recorded in state
+         void        revert( const undo_state& state );
+
+         /// Declared first so that it outlives the states whose arenas return memory to it
+         undo_chunk_pool                             _chunk_pool;
+         uint32_t                                    _active_sessions = 0;
+         bool                                        _disabled = true;
+         std::deque< std::unique_ptr<undo_state> >   _stack;
+         /// Emptied states kept for reuse by later sessions
+         std::vector< std::unique_ptr<undo_state> >  _spare_states;
+         /// Scratch space ordering new ids when reverting
+         std::vector<object_id_type>                 _sorted_ids;
+         object_database&                            _db;
+         size_t                                      _max_size = 256;
    };
 
 } } // graphene::db
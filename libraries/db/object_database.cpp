@@ -24,11 +24,219 @@
 #include <graphene/db/object_database.hpp>
 
 #include <fc/io/raw.hpp>
+#include <fc/io/fstream.hpp>
 #include <fc/container/flat.hpp>
 #include <fc/uint128.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace db { namespace detail {
+
+   /**
+    *  Every checkpoint segment starts with its number and the state of all indexes, followed by
+    *  ( object_id_type, packed object ) records until the end of the file.  An empty packed object
+    *  means the object was removed.  Segments are stored in object_database.delta/<number>, and the
+    *  complete state in object_database/ records the last segment merged into it in "checkpoint".
+    */
+   struct checkpoint_index_state
+   {
+      object_id_type index_id;
+      object_id_type next_id;
+      fc::sha256     version;
+   };
+
+} } }
+
+FC_REFLECT( graphene::db::detail::checkpoint_index_state, (index_id)(next_id)(version) )
+
 namespace graphene { namespace db {
 
+namespace detail {
+
+   static fc::path segment_dir( const fc::path& data_dir ) { return data_dir / "object_database.delta"; }
+
+   /// @return the numbers of all complete segments in ascending order
+   static std::vector<uint64_t> list_segments( const fc::path& data_dir )
+   {
+      std::vector<uint64_t> result;
+      const fc::path dir = segment_dir( data_dir );
+      if( !fc::exists( dir ) )
+         return result;
+      for( boost::filesystem::directory_iterator itr( dir.generic_string() ), end; itr != end; ++itr )
+      {
+         const std::string name = itr->path().filename().string();
+         if( !name.empty() && name.find_first_not_of( "0123456789" ) == std::string::npos )
+            result.push_back( std::stoull( name ) );
+      }
+      std::sort( result.begin(), result.end() );
+      return result;
+   }
+
+   static uint64_t read_base_segment( const fc::path& base_dir )
+   {
+      const fc::path marker = base_dir / "checkpoint";
+      if( !fc::exists( marker ) )
+         return 0;
+      std::string content;
+      fc::read_file_contents( marker, content );
+      return fc::raw::unpack<uint64_t>( std::vector<char>( content.begin(), content.end() ) );
+   }
+
+   static void write_base_segment( const fc::path& base_dir, uint64_t segment )
+   {
+      std::ofstream out( (base_dir / "checkpoint").generic_string(), std::ofstream::binary | std::ofstream::trunc );
+      FC_ASSERT( out );
+      fc::raw::pack( out, segment );
+   }
+
+   template<typename OnIndex, typename OnObject>
+   static void read_segment( const fc::path& file, const OnIndex& on_index, const OnObject& on_object )
+   {
+      fc::file_mapping fm( file.generic_string().c_str(), fc::read_only );
+      fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(file) );
+      fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
+
+      uint64_t segment;
+      vector<checkpoint_index_state> indexes;
+      fc::raw::unpack( ds, segment );
+      fc::raw::unpack( ds, indexes );
+      for( const auto& state : indexes )
+         on_index( state );
+
+      object_id_type id;
+      vector<char> data;
+      while( ds.remaining() > 0 )
+      {
+         fc::raw::unpack( ds, id );
+         fc::raw::unpack( ds, data );
+         on_object( id, data );
+      }
+   }
+
+   /// Changes of one index collected from a range of segments
+   struct index_changes
+   {
+      optional<checkpoint_index_state>   state;
+      std::map<object_id_type, vector<char>> objects;
+   };
+
+   /**
+    *  Writes @ref in with @ref changes applied to @ref out in the format of primary_index::save().
+    *  Every packed object starts with its id, because graphene::db::object reflects only its id and
+    *  all objects are reflected as derived from it.
+    */
+   static void merge_index_file( const fc::path& in, const fc::path& out_path, const index_changes* changes )
+   {
+      std::ofstream out( out_path.generic_string(), std::ofstream::binary | std::ofstream::trunc );
+      FC_ASSERT( out );
+
+      object_id_type next_id;
+      fc::sha256 version;
+      std::unique_ptr<fc::file_mapping> fm;
+      std::unique_ptr<fc::mapped_region> mr;
+      fc::datastream<const char*> ds( nullptr, 0 );
+      if( fc::exists( in ) && fc::file_size( in ) > 0 )
+      {
+         fm.reset( new fc::file_mapping( in.generic_string().c_str(), fc::read_only ) );
+         mr.reset( new fc::mapped_region( *fm, fc::read_only, 0, fc::file_size( in ) ) );
+         ds = fc::datastream<const char*>( (const char*)mr->get_address(), mr->get_size() );
+         fc::raw::unpack( ds, next_id );
+         fc::raw::unpack( ds, version );
+      }
+      if( changes != nullptr && changes->state.valid() )
+      {
+         next_id = changes->state->next_id;
+         version = changes->state->version;
+      }
+      fc::raw::pack( out, next_id );
+      fc::raw::pack( out, version );
+
+      vector<char> tmp;
+      while( ds.remaining() > 0 )
+      {
+         fc::raw::unpack( ds, tmp );
+         if( changes != nullptr )
+         {
+            fc::datastream<const char*> record( tmp.data(), tmp.size() );
+            object_id_type id;
+            fc::raw::unpack( record, id );
+            if( changes->objects.find( id ) != changes->objects.end() )
+               continue;
+         }
+         fc::raw::pack( out, tmp );
+      }
+      if( changes != nullptr )
+         for( const auto& item : changes->objects )
+            if( !item.second.empty() )
+               fc::raw::pack( out, item.second );
+   }
+
+   /**
+    *  Merges all segments up to @ref up_to_segment into a copy of the complete state and replaces
+    *  the complete state by it.  Only works on files, so it can run while the database is in use.
+    *  @return the last merged segment
+    */
+   static uint64_t compact_checkpoints( const fc::path data_dir, const uint64_t up_to_segment )
+   {
+      const fc::path base_dir = data_dir / "object_database";
+      const fc::path new_dir = data_dir / "object_database.compact";
+      const uint64_t base_segment = read_base_segment( base_dir );
+      const std::vector<uint64_t> segments = list_segments( data_dir );
+
+      std::map< std::pair<uint8_t,uint8_t>, index_changes > changes;
+      for( uint64_t segment : segments )
+      {
+         if( segment <= base_segment || segment > up_to_segment )
+            continue;
+         read_segment( segment_dir( data_dir ) / fc::to_string( segment ),
+            [&changes]( const checkpoint_index_state& state ) {
+               changes[ std::make_pair( state.index_id.space(), state.index_id.type() ) ].state = state;
+            },
+            [&changes]( const object_id_type& id, const vector<char>& data ) {
+               changes[ std::make_pair( id.space(), id.type() ) ].objects[id] = data;
+            });
+      }
+
+      fc::remove_all( new_dir );
+      fc::create_directories( new_dir / "lock" );
+      for( const auto& item : changes )
+      {
+         const fc::path space = fc::to_string( item.first.first );
+         const fc::path type = fc::to_string( item.first.second );
+         fc::create_directories( new_dir / space );
+         merge_index_file( base_dir / space / type, new_dir / space / type, &item.second );
+      }
+      // copy the indexes without changes
+      for( boost::filesystem::directory_iterator sitr( base_dir.generic_string() ), end; sitr != end; ++sitr )
+      {
+         if( !boost::filesystem::is_directory( sitr->path() ) || sitr->path().filename() == "lock" )
+            continue;
+         const fc::path space = sitr->path().filename().string();
+         fc::create_directories( new_dir / space );
+         for( boost::filesystem::directory_iterator titr( sitr->path() ); titr != end; ++titr )
+         {
+            const fc::path type = titr->path().filename().string();
+            if( !fc::exists( new_dir / space / type ) )
+               fc::copy( base_dir / space / type, new_dir / space / type );
+         }
+      }
+      write_base_segment( new_dir, up_to_segment );
+      fc::remove_all( new_dir / "lock" );
+
+      fc::rename( base_dir, data_dir / "object_database.old" );
+      fc::rename( new_dir, base_dir );
+      fc::remove_all( data_dir / "object_database.old" );
+
+      for( uint64_t segment : segments )
+         if( segment <= up_to_segment )
+            fc::remove( segment_dir( data_dir ) / fc::to_string( segment ) );
+      return up_to_segment;
+   }
+
+} // detail
+
 object_database::object_database()
 :_undo_db(*this)
 {
@@ -40,6 +248,7 @@ object_database::~object_database(){}
 
 void object_database::close()
 {
+   finish_compaction();
 }
 
 const object* object_database::find_object( object_id_type id )const
@@ -59,6 +268,14 @@ const index& object_database::get_index(uint8_t space_id, uint8_t type_id)const
    FC_ASSERT( tmp );
    return *tmp;
 }
+void object_database::inspect_all_indexes( const std::function<void(const index&)>& inspector )const
+{
+   for( const auto& space : _index )
+      for( const auto& idx : space )
+         if( idx )
+            inspector( *idx );
+}
+
 index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
 {
    FC_ASSERT( _index.size() > space_id, "", ("space_id",space_id)("type_id",type_id)("index.size",_index.size()) );
@@ -69,8 +286,17 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
 }
 
 void object_database::flush()
+{
+   if( _track_changes )
+      write_checkpoint_segment();
+   else
+      flush_full();
+}
+
+void object_database::flush_full()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
+   finish_compaction();
    fc::create_directories( _data_dir / "object_database.tmp" / "lock" );
    for( uint32_t space = 0; space < _index.size(); ++space )
    {
@@ -80,11 +306,117 @@ void object_database::flush()
          if( _index[space][type] )
             _index[space][type]->save( _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type) );
    }
+   detail::write_base_segment( _data_dir / "object_database.tmp", _last_segment );
    fc::remove_all( _data_dir / "object_database.tmp" / "lock" );
    if( fc::exists( _data_dir / "object_database" ) )
       fc::rename( _data_dir / "object_database", _data_dir / "object_database.old" );
    fc::rename( _data_dir / "object_database.tmp", _data_dir / "object_database" );
    fc::remove_all( _data_dir / "object_database.old" );
+   fc::remove_all( detail::segment_dir( _data_dir ) );
+
+   _base_segment = _last_segment;
+   _changed_objects.clear();
+   _track_changes = true;
+}
+
+void object_database::write_checkpoint_segment()
+{
+   if( _changed_objects.empty() )
+      return;
+
+   const uint64_t segment = _last_segment + 1;
+   const fc::path dir = detail::segment_dir( _data_dir );
+   const fc::path tmp_file = dir / ( fc::to_string( segment ) + ".tmp" );
+   fc::create_directories( dir );
+   {
+      std::ofstream out( tmp_file.generic_string(), std::ofstream::binary | std::ofstream::trunc );
+      FC_ASSERT( out );
+
+      vector<detail::checkpoint_index_state> indexes;
+      for( const auto& space : _index )
+         for( const auto& idx : space )
+            if( idx )
+               indexes.push_back( { object_id_type( idx->object_space_id(), idx->object_type_id(), 0 ),
+                                    idx->get_next_id(), idx->get_object_version() } );
+      fc::raw::pack( out, segment );
+      fc::raw::pack( out, indexes );
+
+      const vector<char> removed;
+      for( const object_id_type& id : _changed_objects )
+      {
+         const index& idx = get_index( id.space(), id.type() );
+         const object* obj = idx.find( id );
+         fc::raw::pack( out, id );
+         fc::raw::pack( out, obj != nullptr ? idx.pack_object( *obj ) : removed );
+      }
+      FC_ASSERT( out.good(), "Failed to write checkpoint segment ${f}", ("f", tmp_file) );
+   }
+   fc::rename( tmp_file, dir / fc::to_string( segment ) );
+
+   _last_segment = segment;
+   _changed_objects.clear();
+   if( _max_checkpoint_segments > 0 && _last_segment - _base_segment >= _max_checkpoint_segments )
+      start_compaction();
+}
+
+void object_database::replay_checkpoint_segments()
+{
+   _base_segment = detail::read_base_segment( _data_dir / "object_database" );
+   _last_segment = _base_segment;
+   uint32_t replayed = 0;
+   for( uint64_t segment : detail::list_segments( _data_dir ) )
+   {
+      if( segment <= _base_segment )
+         continue;
+      detail::read_segment( detail::segment_dir( _data_dir ) / fc::to_string( segment ),
+         [this]( const detail::checkpoint_index_state& state ) {
+            const auto space = state.index_id.space();
+            const auto type = state.index_id.type();
+            if( _index.size() > space && _index[space].size() > type && _index[space][type] )
+               _index[space][type]->set_next_id( state.next_id );
+         },
+         [this]( const object_id_type& id, const vector<char>& data ) {
+            if( _index.size() > id.space() && _index[id.space()].size() > id.type() && _index[id.space()][id.type()] )
+               _index[id.space()][id.type()]->replay_object( id, data );
+         });
+      _last_segment = segment;
+      ++replayed;
+   }
+   if( replayed > 0 )
+      ilog( "Replayed ${n} object database checkpoint segments", ("n", replayed) );
+}
+
+void object_database::start_compaction()
+{
+   if( _compaction.valid() )
+   {
+      if( _compaction.wait_for( std::chrono::seconds(0) ) != std::future_status::ready )
+         return; // still merging older segments, the next flush will try again
+      finish_compaction();
+   }
+   const fc::path data_dir = _data_dir;
+   const uint64_t up_to_segment = _last_segment;
+   _compaction = std::async( std::launch::async, [data_dir, up_to_segment]() {
+      return detail::compact_checkpoints( data_dir, up_to_segment );
+   });
+}
+
+void object_database::finish_compaction()
+{
+   if( !_compaction.valid() )
+      return;
+   try
+   {
+      _base_segment = _compaction.get();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Merging object database checkpoint segments failed: ${e}", ("e", e.to_detail_string()) );
+   }
+   catch( const std::exception& e )
+   {
+      elog( "Merging object database checkpoint segments failed: ${e}", ("e", e.what()) );
+   }
 }
 
 void object_database::wipe(const fc::path& data_dir)
@@ -92,6 +424,11 @@ void object_database::wipe(const fc::path& data_dir)
    close();
    ilog("Wiping object database...");
    fc::remove_all(data_dir / "object_database");
+   fc::remove_all(detail::segment_dir(data_dir));
+   _changed_objects.clear();
+   _track_changes = false;
+   _last_segment = 0;
+   _base_segment = 0;
    ilog("Done wiping object databse.");
 }
 
@@ -101,6 +438,7 @@ void object_database::open(const fc::path& data_dir)
    if( fc::exists( _data_dir / "object_database" / "lock" ) )
    {
        wlog("Ignoring locked object_database");
+       fc::remove_all( detail::segment_dir( _data_dir ) );
        return;
    }
    ilog("Opening object database from ${d} ...", ("d", data_dir));
@@ -108,6 +446,9 @@ void object_database::open(const fc::path& data_dir)
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
             _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
+   replay_checkpoint_segments();
+   _changed_objects.clear();
+   _track_changes = fc::exists( _data_dir / "object_database" );
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/db/undo_arena.hpp>
+
+#include <new>
+
+namespace graphene { namespace db {
+
+undo_chunk_pool::~undo_chunk_pool()
+{
+   while( _free )
+   {
+      chunk* next = _free->next;
+      free( _free );
+      _free = next;
+   }
+}
+
+undo_chunk_pool::chunk* undo_chunk_pool::allocate( size_t size )
+{
+   chunk* c = static_cast<chunk*>( ::operator new( sizeof(chunk) + size ) );
+   c->next = nullptr;
+   c->size = size;
+   return c;
+}
+
+void undo_chunk_pool::free( chunk* c )
+{
+   ::operator delete( c );
+}
+
+undo_chunk_pool::chunk* undo_chunk_pool::acquire()
+{
+   if( !_free )
+      return allocate( chunk_size );
+   chunk* c = _free;
+   _free = c->next;
+   --_free_count;
+   c->next = nullptr;
+   return c;
+}
+
+void undo_chunk_pool::recycle( chunk* first, chunk* last, size_t count )
+{
+   if( !first )
+      return;
+   last->next = _free;
+   _free = first;
+   _free_count += count;
+   while( _free_count > _max_retained )
+   {
+      chunk* next = _free->next;
+      free( _free );
+      _free = next;
+      --_free_count;
+   }
+}
+
+void undo_arena::chunk_list::push_front( undo_chunk_pool::chunk* c )
+{
+   c->next = first;
+   first = c;
+   if( !last )
+      last = c;
+   ++count;
+}
+
+void undo_arena::chunk_list::append( chunk_list& other )
+{
+   if( !other.first )
+      return;
+   if( last )
+      last->next = other.first;
+   else
+      first = other.first;
+   last = other.last;
+   count += other.count;
+   other = chunk_list();
+}
+
+void* undo_arena::allocate( size_t size, size_t alignment )
+{
+   const size_t standard_size = undo_chunk_pool::chunk_size;
+   if( size + alignment > standard_size / 4 )
+   {
+      undo_chunk_pool::chunk* c = undo_chunk_pool::allocate( size + alignment );
+      _large.push_front( c );
+      size_t misalignment = reinterpret_cast<uintptr_t>( c->data() ) % alignment;
+      return c->data() + ( misalignment ? alignment - misalignment : 0 );
+   }
+
+   size_t misalignment = reinterpret_cast<uintptr_t>( _pos ) % alignment;
+   char* result = _pos + ( misalignment ? alignment - misalignment : 0 );
+   if( !_pos || result + size > _end )
+   {
+      undo_chunk_pool::chunk* c = _pool->acquire();
+      _chunks.push_front( c );
+      _pos = c->data();
+      _end = _pos + c->size;
+      misalignment = reinterpret_cast<uintptr_t>( _pos ) % alignment;
+      result = _pos + ( misalignment ? alignment - misalignment : 0 );
+   }
+   _pos = result + size;
+   return result;
+}
+
+void undo_arena::adopt( undo_arena& other )
+{
+   // keep filling our current chunk, the adopted ones are only kept alive
+   if( !_chunks.first )
+   {
+      _pos = other._pos;
+      _end = other._end;
+   }
+   _chunks.append( other._chunks );
+   _large.append( other._large );
+   other._pos = other._end = nullptr;
+}
+
+void undo_arena::release()
+{
+   _pool->recycle( _chunks.first, _chunks.last, _chunks.count );
+   _chunks = chunk_list();
+   while( _large.first )
+   {
+      undo_chunk_pool::chunk* next = _large.first->next;
+      undo_chunk_pool::free( _large.first );
+      _large.first = next;
+   }
+   _large = chunk_list();
+   _pos = _end = nullptr;
+}
+
+} } // graphene::db
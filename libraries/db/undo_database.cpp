@@ -25,8 +25,23 @@
 #include <graphene/db/undo_database.hpp>
 #include <fc/reflect/variant.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace db {
 
+void undo_state::clear()
+{
+   for( const auto& item : old_values )
+      undo_arena::destroy( item.value );
+   for( const auto& item : removed )
+      undo_arena::destroy( item.value );
+   old_values.clear();
+   old_index_next_ids.clear();
+   new_ids.clear();
+   removed.clear();
+   arena.release();
+}
+
 void undo_database::enable()  { _disabled = false; }
 void undo_database::disable() { _disabled = true; }
 
@@ -42,6 +57,43 @@ undo_database::session::~session() {
    if( _disable_on_exit ) _db.disable();
 }
 
+void undo_database::push_state()
+{
+   if( _spare_states.empty() )
+   {
+      _stack.emplace_back( new undo_state( _chunk_pool ) );
+      return;
+   }
+   _stack.push_back( std::move( _spare_states.back() ) );
+   _spare_states.pop_back();
+}
+
+void undo_database::pop_state_back()
+{
+   std::unique_ptr<undo_state> state = std::move( _stack.back() );
+   _stack.pop_back();
+   state->clear();
+   // a handful of spare states covers the nesting of block, pending and transaction sessions
+   if( _spare_states.size() < 8 )
+      _spare_states.push_back( std::move( state ) );
+}
+
+void undo_database::pop_state_front()
+{
+   std::unique_ptr<undo_state> state = std::move( _stack.front() );
+   _stack.pop_front();
+   state->clear();
+   if( _spare_states.size() < 8 )
+      _spare_states.push_back( std::move( state ) );
+}
+
+undo_state& undo_database::current_state()
+{
+   if( _stack.empty() )
+      push_state();
+   return *_stack.back();
+}
+
 undo_database::session undo_database::start_undo_session( bool force_enable )
 {
    if( _disabled && !force_enable ) return session(*this);
@@ -50,9 +102,9 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
       _disabled = false;
 
    while( size() > max_size() )
-      _stack.pop_front();
+      pop_state_front();
 
-   _stack.emplace_back();
+   push_state();
    ++_active_sessions;
    return session(*this, disable_on_exit );
 }
@@ -60,76 +112,90 @@ void undo_database::on_create( const object& obj )
 {
    if( _disabled ) return;
 
-   if( _stack.empty() )
-      _stack.emplace_back();
-   auto& state = _stack.back();
+   auto& state = current_state();
    auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
-   auto itr = state.old_index_next_ids.find( index_id );
-   if( itr == state.old_index_next_ids.end() )
-      state.old_index_next_ids[index_id] = obj.id;
+   auto next_id = state.old_index_next_ids.insert( index_id );
+   if( next_id.second )
+      *next_id.first = obj.id;
    state.new_ids.insert(obj.id);
 }
 void undo_database::on_modify( const object& obj )
 {
    if( _disabled ) return;
 
-   if( _stack.empty() )
-      _stack.emplace_back();
-   auto& state = _stack.back();
-   if( state.new_ids.find(obj.id) != state.new_ids.end() )
+   auto& state = current_state();
+   if( state.new_ids.contains(obj.id) )
+      return;
+   if( state.old_values.contains(obj.id) )
       return;
-   auto itr =  state.old_values.find(obj.id);
-   if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   object* old_value = state.arena.clone( obj );
+   try {
+      *state.old_values.insert(obj.id).first = old_value;
+   } catch( ... ) {
+      undo_arena::destroy( old_value );
+      throw;
+   }
 }
 void undo_database::on_remove( const object& obj )
 {
    if( _disabled ) return;
 
-   if( _stack.empty() )
-      _stack.emplace_back();
-   undo_state& state = _stack.back();
-   if( state.new_ids.count(obj.id) )
-   {
-      state.new_ids.erase(obj.id);
+   undo_state& state = current_state();
+   if( state.new_ids.erase(obj.id) )
       return;
-   }
-   if( state.old_values.count(obj.id) )
+   object** old_value = state.old_values.find(obj.id);
+   if( old_value != nullptr )
    {
-      state.removed[obj.id] = std::move(state.old_values[obj.id]);
+      object* value = *old_value;
       state.old_values.erase(obj.id);
+      *state.removed.insert(obj.id).first = value;
       return;
    }
-   if( state.removed.count(obj.id) ) return;
-   state.removed[obj.id] = obj.clone();
+   if( state.removed.contains(obj.id) ) return;
+   object* removed_value = state.arena.clone( obj );
+   try {
+      *state.removed.insert(obj.id).first = removed_value;
+   } catch( ... ) {
+      undo_arena::destroy( removed_value );
+      throw;
+   }
 }
 
-void undo_database::undo()
-{ try {
-   FC_ASSERT( !_disabled );
-   FC_ASSERT( _active_sessions > 0 );
-   disable();
-
-   auto& state = _stack.back();
-   for( auto& item : state.old_values )
+void undo_database::revert( const undo_state& state )
+{
+   for( const auto& item : state.old_values )
    {
-      _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
+      _db.modify( _db.get_object( item.id ), [&]( object& obj ){ obj.move_from( *item.value ); } );
    }
 
-   for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
+   // remove new objects from the highest id down
+   _sorted_ids.clear();
+   for( const auto& item : state.new_ids )
+      _sorted_ids.push_back( item.id );
+   std::sort( _sorted_ids.begin(), _sorted_ids.end(), std::greater<object_id_type>() );
+   for( const auto& id : _sorted_ids )
    {
-      _db.remove( _db.get_object(*ritr) );
+      _db.remove( _db.get_object(id) );
    }
 
-   for( auto& item : state.old_index_next_ids )
+   for( const auto& item : state.old_index_next_ids )
    {
-      _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
+      _db.get_mutable_index( item.id.space(), item.id.type() ).set_next_id( item.value );
    }
 
-   for( auto& item : state.removed )
-      _db.insert( std::move(*item.second) );
+   for( const auto& item : state.removed )
+      _db.insert( std::move(*item.value) );
+}
 
-   _stack.pop_back();
+void undo_database::undo()
+{ try {
+   FC_ASSERT( !_disabled );
+   FC_ASSERT( _active_sessions > 0 );
+   disable();
+
+   revert( *_stack.back() );
+
+   pop_state_back();
    enable();
    --_active_sessions;
 } FC_CAPTURE_AND_RETHROW() }
@@ -139,13 +205,13 @@ void undo_database::merge()
    FC_ASSERT( _active_sessions > 0 );
    if( _active_sessions == 1 && _stack.size() == 1 )
    {
-      _stack.pop_back();
+      pop_state_back();
       --_active_sessions;
       return;
    }
    FC_ASSERT( _stack.size() >=2 );
-   auto& state = _stack.back();
-   auto& prev_state = _stack[_stack.size()-2];
+   auto& state = *_stack.back();
+   auto& prev_state = *_stack[_stack.size()-2];
 
    // An object's relationship to a state can be:
    // in new_ids            : new
@@ -188,37 +254,43 @@ void undo_database::merge()
    //
 
    // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three containers.
+   //
+   // The values of B which end up in prev_state stay where they are, prev_state takes over B's arena.  The values
+   // which are dropped are destroyed here.
 
    // *+upd
-   for( auto& obj : state.old_values )
+   for( const auto& obj : state.old_values )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      if( prev_state.new_ids.contains(obj.id) )
       {
          // new+upd -> new, type A
+         undo_arena::destroy( obj.value );
          continue;
       }
-      if( prev_state.old_values.find(obj.second->id) != prev_state.old_values.end() )
+      if( prev_state.old_values.contains(obj.id) )
       {
          // upd(was=X) + upd(was=Y) -> upd(was=X), type A
+         undo_arena::destroy( obj.value );
          continue;
       }
       // del+upd -> N/A
-      assert( prev_state.removed.find(obj.second->id) == prev_state.removed.end() );
+      assert( !prev_state.removed.contains(obj.id) );
       // nop+upd(was=Y) -> upd(was=Y), type B
-      prev_state.old_values[obj.second->id] = std::move(obj.second);
+      *prev_state.old_values.insert(obj.id).first = obj.value;
    }
 
    // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-   for( auto id : state.new_ids )
-      prev_state.new_ids.insert(id);
+   for( const auto& item : state.new_ids )
+      prev_state.new_ids.insert(item.id);
 
    // old_index_next_ids can only be updated, iterate over *+upd cases
-   for( auto& item : state.old_index_next_ids )
+   for( const auto& item : state.old_index_next_ids )
    {
-      if( prev_state.old_index_next_ids.find( item.first ) == prev_state.old_index_next_ids.end() )
+      auto inserted = prev_state.old_index_next_ids.insert( item.id );
+      if( inserted.second )
       {
          // nop+upd(was=Y) -> upd(was=Y), type B
-         prev_state.old_index_next_ids[item.first] = item.second;
+         *inserted.first = item.value;
          continue;
       }
       else
@@ -230,28 +302,35 @@ void undo_database::merge()
    }
 
    // *+del
-   for( auto& obj : state.removed )
+   for( const auto& obj : state.removed )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      if( prev_state.new_ids.erase(obj.id) )
       {
          // new + del -> nop (type C)
-         prev_state.new_ids.erase(obj.second->id);
+         undo_arena::destroy( obj.value );
          continue;
       }
-      auto it = prev_state.old_values.find(obj.second->id);
-      if( it != prev_state.old_values.end() )
+      object** was = prev_state.old_values.find(obj.id);
+      if( was != nullptr )
       {
          // upd(was=X) + del(was=Y) -> del(was=X)
-         prev_state.removed[obj.second->id] = std::move(it->second);
-         prev_state.old_values.erase(obj.second->id);
+         object* old_value = *was;
+         prev_state.old_values.erase(obj.id);
+         *prev_state.removed.insert(obj.id).first = old_value;
+         undo_arena::destroy( obj.value );
          continue;
       }
       // del + del -> N/A
-      assert( prev_state.removed.find( obj.second->id ) == prev_state.removed.end() );
+      assert( !prev_state.removed.contains(obj.id) );
       // nop + del(was=Y) -> del(was=Y)
-      prev_state.removed[obj.second->id] = std::move(obj.second);
+      *prev_state.removed.insert(obj.id).first = obj.value;
    }
-   _stack.pop_back();
+
+   // every value of state is now either destroyed or referenced by prev_state
+   state.old_values.clear();
+   state.removed.clear();
+   prev_state.arena.adopt( state.arena );
+   pop_state_back();
    --_active_sessions;
 }
 void undo_database::commit()
@@ -267,27 +346,9 @@ void undo_database::pop_commit()
 
    disable();
    try {
-      auto& state = _stack.back();
-
-      for( auto& item : state.old_values )
-      {
-         _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-      }
-
-      for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-      {
-         _db.remove( _db.get_object(*ritr) );
-      }
-
-      for( auto& item : state.old_index_next_ids )
-      {
-         _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-      }
-
-      for( auto& item : state.removed )
-         _db.insert( std::move(*item.second) );
+      revert( *_stack.back() );
 
-      _stack.pop_back();
+      pop_state_back();
    }
    catch ( const fc::exception& e )
    {
@@ -300,7 +361,7 @@ void undo_database::pop_commit()
 const undo_state& undo_database::head()const
 {
    FC_ASSERT( !_stack.empty() );
-   return _stack.back();
+   return *_stack.back();
 }
 
 } } // graphene::db
@@ -23,6 +23,9 @@
  */
 #include <graphene/net/core_messages.hpp>
 
+#include <fc/io/raw.hpp>
+
+#include <cstring>
 
 namespace graphene { namespace net {
 
@@ -45,5 +48,75 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum get_compact_block_transactions_message::type  = core_message_type_enum::get_compact_block_transactions_message_type;
+  const core_message_type_enum compact_block_transactions_message::type      = core_message_type_enum::compact_block_transactions_message_type;
+
+  // A packed block_message is the packed block followed by the packed block_id, which has a fixed size
+
+  message packed_block_message( const char* packed_block, uint32_t size, const block_id_type& block_id )
+  {
+    message result;
+    result.msg_type = block_message::type;
+    result.data.resize( size + fc::raw::pack_size( block_id ) );
+    std::memcpy( result.data.data(), packed_block, size );
+    fc::datastream<char*> ds( result.data.data() + size, result.data.size() - size );
+    fc::raw::pack( ds, block_id );
+    result.size = (uint32_t)result.data.size();
+    return result;
+  }
+
+  block_id_type block_id_of_message( const message& block_msg )
+  {
+    FC_ASSERT( block_msg.msg_type == block_message::type );
+    block_id_type block_id;
+    const size_t id_size = fc::raw::pack_size( block_id );
+    FC_ASSERT( block_msg.data.size() >= id_size );
+    fc::datastream<const char*> ds( block_msg.data.data() + block_msg.data.size() - id_size, id_size );
+    fc::raw::unpack( ds, block_id );
+    return block_id;
+  }
+
+  uint64_t short_transaction_id( const message_hash_type& trx_message_hash )
+  {
+    // read byte by byte, so that peers agree on the id whatever their endianness
+    const uint8_t* bytes = (const uint8_t*)trx_message_hash.data();
+    uint64_t short_id = 0;
+    for( size_t i = 0; i < sizeof(short_id); ++i )
+      short_id = (short_id << 8) | bytes[i];
+    return short_id;
+  }
+
+  compact_block_message::compact_block_message( const block_message& full_block, const message_hash_type& block_message_hash )
+    : block_message_hash( block_message_hash ),
+      block_id( full_block.block_id ),
+      header( full_block.block )
+  {
+    transactions.reserve( full_block.block.transactions.size() );
+    for( const auto& trx : full_block.block.transactions )
+    {
+      compact_block_transaction compact_trx;
+      compact_trx.short_id = short_transaction_id( message( trx_message( trx ) ).id() );
+      compact_trx.operation_results = trx.operation_results;
+      transactions.push_back( std::move( compact_trx ) );
+    }
+  }
+
+  message block_message_from_compact( const compact_block_message& compact_block,
+                                      const std::vector<signed_transaction>& transactions )
+  {
+    FC_ASSERT( transactions.size() == compact_block.transactions.size() );
+    block_message result;
+    static_cast<graphene::chain::signed_block_header&>( result.block ) = compact_block.header;
+    result.block_id = compact_block.block_id;
+    result.block.transactions.reserve( transactions.size() );
+    for( size_t i = 0; i < transactions.size(); ++i )
+    {
+      graphene::chain::processed_transaction trx( transactions[i] );
+      trx.operation_results = compact_block.transactions[i].operation_results;
+      result.block.transactions.push_back( std::move( trx ) );
+    }
+    return message( result );
+  }
 
 } } // graphene::net
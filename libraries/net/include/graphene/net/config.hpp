@@ -25,7 +25,13 @@
 
 #include <stddef.h>
 
-#define GRAPHENE_NET_PROTOCOL_VERSION                        106
+#define GRAPHENE_NET_PROTOCOL_VERSION                        107
+
+/**
+ * Peers at this protocol version or later are sent recently relayed blocks as
+ * compact_block_messages instead of full block_messages
+ */
+#define GRAPHENE_NET_COMPACT_BLOCK_PROTOCOL_VERSION          107
 
 /**
  * Define this to enable debugging code in the p2p network interface.
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/net/config.hpp>
+#include <graphene/net/message.hpp>
 #include <graphene/chain/protocol/block.hpp>
 
 #include <fc/crypto/ripemd160.hpp>
@@ -86,6 +87,9 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    get_compact_block_transactions_message_type  = 5019,
+    compact_block_transactions_message_type      = 5020,
     core_message_type_last                       = 5099
   };
 
@@ -115,6 +119,77 @@ namespace graphene { namespace net {
 
    };
 
+   /**
+    *  Builds the block_message of a block from the block's packed bytes, e.g. as stored by the block database,
+    *  without unpacking and repacking the block
+    */
+   message packed_block_message( const char* packed_block, uint32_t size, const block_id_type& block_id );
+   /// Returns the block_id of a block_message without unpacking its block
+   block_id_type block_id_of_message( const message& block_msg );
+
+   /**
+    *  Short id of a transaction in a compact_block_message, taken from the hash of its trx_message, which is
+    *  the item id under which the transaction was relayed
+    */
+   uint64_t short_transaction_id( const message_hash_type& trx_message_hash );
+
+   struct compact_block_transaction
+   {
+      uint64_t                                        short_id = 0;
+      std::vector<graphene::chain::operation_result>  operation_results;
+   };
+
+   /**
+    *  A recently relayed block sent as its header and the short ids of its transactions.  The receiver
+    *  rebuilds the block_message from the transactions it already has and asks for the missing ones with
+    *  a get_compact_block_transactions_message.  The rebuilt block_message must hash to block_message_hash.
+    *
+    *  It is only sent in reply to a fetch_items_message whose item_type is compact_block_message_type, which
+    *  asks for blocks that may be sent compact.  Sync fetches ask for block_message_type and get full blocks.
+    */
+   struct compact_block_message
+   {
+      static const core_message_type_enum type;
+
+      compact_block_message() {}
+      compact_block_message( const block_message& full_block, const message_hash_type& block_message_hash );
+
+      message_hash_type                       block_message_hash;
+      block_id_type                           block_id;
+      graphene::chain::signed_block_header    header;
+      std::vector<compact_block_transaction>  transactions;
+   };
+
+   /**
+    *  Builds the block_message of a compact block from its transactions, in block order
+    */
+   message block_message_from_compact( const compact_block_message& compact_block,
+                                       const std::vector<signed_transaction>& transactions );
+
+   struct get_compact_block_transactions_message
+   {
+      static const core_message_type_enum type;
+
+      message_hash_type      block_message_hash;
+      std::vector<uint32_t>  transaction_indexes;
+
+      get_compact_block_transactions_message() {}
+      get_compact_block_transactions_message( const message_hash_type& block_message_hash,
+                                              const std::vector<uint32_t>& transaction_indexes ) :
+         block_message_hash(block_message_hash),
+         transaction_indexes(transaction_indexes)
+      {}
+   };
+
+   /// The transactions asked for by a get_compact_block_transactions_message, in the order asked
+   struct compact_block_transactions_message
+   {
+      static const core_message_type_enum type;
+
+      message_hash_type                block_message_hash;
+      std::vector<signed_transaction>  transactions;
+   };
+
   struct item_ids_inventory_message
   {
     static const core_message_type_enum type;
@@ -424,10 +499,17 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (get_compact_block_transactions_message_type)
+                 (compact_block_transactions_message_type)
                  (core_message_type_last) )
 
 FC_REFLECT( graphene::net::trx_message, (trx) )
 FC_REFLECT( graphene::net::block_message, (block)(block_id) )
+FC_REFLECT( graphene::net::compact_block_transaction, (short_id)(operation_results) )
+FC_REFLECT( graphene::net::compact_block_message, (block_message_hash)(block_id)(header)(transactions) )
+FC_REFLECT( graphene::net::get_compact_block_transactions_message, (block_message_hash)(transaction_indexes) )
+FC_REFLECT( graphene::net::compact_block_transactions_message, (block_message_hash)(transactions) )
 
 FC_REFLECT( graphene::net::item_id, (item_type)
                                (item_hash) )
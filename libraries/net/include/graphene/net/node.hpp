@@ -169,6 +169,12 @@ namespace graphene { namespace net {
          virtual void error_encountered(const std::string& message, const fc::oexception& error) = 0;
          virtual uint8_t get_current_block_interval_in_seconds() const = 0;
 
+         /**
+          *  Returns the transactions accepted by the client which are not in a block yet, used to
+          *  rebuild compact blocks from transactions that dropped out of the message cache
+          */
+         virtual std::vector<signed_transaction> get_pending_transactions() = 0;
+
    };
 
    /**
@@ -37,6 +37,7 @@
 #include <boost/multi_index/tag.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <map>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -251,6 +252,15 @@ namespace graphene { namespace net
       timestamped_items_set_type inventory_advertised_to_peer;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+      /// a compact block from this peer waiting for the transactions we asked the peer for
+      struct compact_block_in_progress
+      {
+        compact_block_message compact_block;
+        std::vector<fc::optional<signed_transaction>> transactions; /// in block order, unset for the ones we don't have yet
+        std::vector<uint32_t> requested_indexes;
+      };
+      std::map<message_hash_type, compact_block_in_progress> compact_blocks_in_progress; /// keyed by the hash of the full block_message
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
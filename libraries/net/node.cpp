@@ -254,6 +254,7 @@ namespace graphene { namespace net {
       struct message_hash_index{};
       struct message_contents_hash_index{};
       struct block_clock_index{};
+      struct short_transaction_id_index{};
       struct message_info
       {
         message_hash_type message_hash;
@@ -264,6 +265,8 @@ namespace graphene { namespace net {
         message_propagation_data propagation_data;
         fc::uint160_t     message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
 
+        uint64_t          short_transaction_id; // the short id of a transaction in compact blocks, 0 for other messages
+
         message_info( const message_hash_type& message_hash,
                       const message&           message_body,
                       uint32_t                 block_clock_when_received,
@@ -273,7 +276,8 @@ namespace graphene { namespace net {
           message_body( message_body ),
           block_clock_when_received( block_clock_when_received ),
           propagation_data( propagation_data ),
-          message_contents_hash( message_contents_hash )
+          message_contents_hash( message_contents_hash ),
+          short_transaction_id( message_body.msg_type == trx_message_type ? graphene::net::short_transaction_id( message_hash ) : 0 )
         {}
       };
       typedef boost::multi_index_container
@@ -283,7 +287,9 @@ namespace graphene { namespace net {
                              bmi::ordered_non_unique< bmi::tag<message_contents_hash_index>,
                                                       bmi::member<message_info, fc::uint160_t, &message_info::message_contents_hash> >,
                              bmi::ordered_non_unique< bmi::tag<block_clock_index>,
-                                                      bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> > >
+                                                      bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> >,
+                             bmi::ordered_non_unique< bmi::tag<short_transaction_id_index>,
+                                                      bmi::member<message_info, uint64_t, &message_info::short_transaction_id> > >
         > message_cache_container;
 
       message_cache_container _message_cache;
@@ -298,6 +304,7 @@ namespace graphene { namespace net {
       void cache_message( const message& message_to_cache, const message_hash_type& hash_of_message_to_cache,
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
       message get_message( const message_hash_type& hash_of_message_to_lookup );
+      fc::optional<message> find_transaction_message( uint64_t short_transaction_id ) const;
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
       size_t size() const { return _message_cache.size(); }
     };
@@ -331,6 +338,17 @@ namespace graphene { namespace net {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    fc::optional<message> blockchain_tied_message_cache::find_transaction_message( uint64_t short_transaction_id ) const
+    {
+      if( short_transaction_id != 0 )
+      {
+        auto iter = _message_cache.get<short_transaction_id_index>().find( short_transaction_id );
+        if( iter != _message_cache.get<short_transaction_id_index>().end() )
+          return iter->message_body;
+      }
+      return fc::optional<message>();
+    }
+
     message_propagation_data blockchain_tied_message_cache::get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const
     {
       if( hash_of_message_contents_to_lookup != fc::uint160_t() )
@@ -423,7 +441,8 @@ namespace graphene { namespace net { namespace detail {
                                    (get_head_block_id) \
                                    (estimate_last_known_fork_from_git_revision_timestamp) \
                                    (error_encountered) \
-                                   (get_current_block_interval_in_seconds)
+                                   (get_current_block_interval_in_seconds) \
+                                   (get_pending_transactions)
 
 
 #define DECLARE_ACCUMULATOR(r, data, method_name) \
@@ -524,6 +543,7 @@ namespace graphene { namespace net { namespace detail {
       uint32_t estimate_last_known_fork_from_git_revision_timestamp(uint32_t unix_timestamp) const override;
       void error_encountered(const std::string& message, const fc::oexception& error) override;
       uint8_t get_current_block_interval_in_seconds() const override;
+      std::vector<signed_transaction> get_pending_transactions() override;
     };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -652,6 +672,7 @@ namespace graphene { namespace net { namespace detail {
       std::vector<uint32_t> _hard_fork_block_numbers; /// list of all block numbers where there are hard forks
 
       blockchain_tied_message_cache _message_cache; /// cache message we have received and might be required to provide to other peers via inventory requests
+      fc::optional<compact_block_message> _most_recent_compact_block; /// the compact form of the block peers most likely fetch next
 
       fc::rate_limiting_group _rate_limiter;
 
@@ -779,6 +800,18 @@ namespace graphene { namespace net { namespace detail {
       void on_item_not_available_message( peer_connection* originating_peer,
                                           const item_not_available_message& item_not_available_message_received );
 
+      void on_compact_block_message( peer_connection* originating_peer,
+                                     const compact_block_message& compact_block_message_received );
+
+      void on_get_compact_block_transactions_message( peer_connection* originating_peer,
+                                                      const get_compact_block_transactions_message& get_compact_block_transactions_message_received );
+
+      void on_compact_block_transactions_message( peer_connection* originating_peer,
+                                                  const compact_block_transactions_message& compact_block_transactions_message_received );
+
+      bool process_compact_block( peer_connection* originating_peer,
+                                  const peer_connection::compact_block_in_progress& compact_block );
+
       void on_item_ids_inventory_message( peer_connection* originating_peer,
                                           const item_ids_inventory_message& item_ids_inventory_message_received );
 
@@ -1339,8 +1372,12 @@ namespace graphene { namespace net { namespace detail {
           // the item lists are heterogenous and
           // the fetch_items_message can only deal with one item type at a time.  
           std::map<uint32_t, std::vector<item_hash_t> > items_to_fetch_by_type;
+          // peers that relay compact blocks are told that these blocks may be sent compact, unlike sync items
+          const uint32_t block_fetch_type = peer_and_items.peer->core_protocol_version >= GRAPHENE_NET_COMPACT_BLOCK_PROTOCOL_VERSION ?
+                                            (uint32_t)core_message_type_enum::compact_block_message_type :
+                                            (uint32_t)graphene::net::block_message_type;
           for (const item_id& item : peer_and_items.item_ids)
-            items_to_fetch_by_type[item.item_type].push_back(item.item_hash);
+            items_to_fetch_by_type[item.item_type == graphene::net::block_message_type ? block_fetch_type : item.item_type].push_back(item.item_hash);
           for (auto& items_by_type : items_to_fetch_by_type)
           {
             dlog("requesting ${count} items of type ${type} from peer ${endpoint}: ${hashes}",
@@ -2019,6 +2056,15 @@ namespace graphene { namespace net { namespace detail {
       case core_message_type_enum::get_current_connections_reply_message_type:
         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::get_compact_block_transactions_message_type:
+        on_get_compact_block_transactions_message(originating_peer, received_message.as<get_compact_block_transactions_message>());
+        break;
+      case core_message_type_enum::compact_block_transactions_message_type:
+        on_compact_block_transactions_message(originating_peer, received_message.as<compact_block_transactions_message>());
+        break;
 
       default:
         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -3000,6 +3046,10 @@ namespace graphene { namespace net { namespace detail {
            ("type", fetch_items_message_received.item_type)
            ("endpoint", originating_peer->get_remote_endpoint()));
 
+      // blocks asked for as compact_block_message_type may be sent compact, all others are sent in full
+      const bool compact_blocks_accepted = fetch_items_message_received.item_type == core_message_type_enum::compact_block_message_type;
+      const uint32_t item_type = compact_blocks_accepted ? (uint32_t)graphene::net::block_message_type : fetch_items_message_received.item_type;
+
       fc::optional<message> last_block_message_sent;
 
       std::list<message> reply_messages;
@@ -3011,9 +3061,22 @@ namespace graphene { namespace net { namespace detail {
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
                ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
+          if (item_type == block_message_type)
+          {
             last_block_message_sent = requested_message;
+            // a block we just relayed: the peer most likely has its transactions already
+            if (compact_blocks_accepted)
+            {
+              if (!_most_recent_compact_block || _most_recent_compact_block->block_message_hash != item_hash)
+                _most_recent_compact_block = compact_block_message(requested_message.as<graphene::net::block_message>(), item_hash);
+              if (!_most_recent_compact_block->transactions.empty())
+              {
+                reply_messages.push_back(*_most_recent_compact_block);
+                continue;
+              }
+            }
+          }
+          reply_messages.push_back(requested_message);
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -3021,7 +3084,7 @@ namespace graphene { namespace net { namespace detail {
            // it wasn't in our local cache, that's ok ask the client
         }
 
-        item_id item_to_fetch(fetch_items_message_received.item_type, item_hash);
+        item_id item_to_fetch(item_type, item_hash);
         try
         {
           message requested_message = _delegate->get_item(item_to_fetch);
@@ -3030,7 +3093,7 @@ namespace graphene { namespace net { namespace detail {
                ("size", requested_message.size)
                ("endpoint", originating_peer->get_remote_endpoint()));
           reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
+          if (item_type == block_message_type)
             last_block_message_sent = requested_message;
           continue;
         }
@@ -3045,9 +3108,9 @@ namespace graphene { namespace net { namespace detail {
       // if we sent them a block, update our record of the last block they've seen accordingly
       if (last_block_message_sent)
       {
-        graphene::net::block_message block = last_block_message_sent->as<graphene::net::block_message>();
-        originating_peer->last_block_delegate_has_seen = block.block_id;
-        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
+        block_id_type last_block_id = block_id_of_message(*last_block_message_sent);
+        originating_peer->last_block_delegate_has_seen = last_block_id;
+        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(last_block_id);
       }
 
       for (const message& reply : reply_messages)
@@ -3067,6 +3130,8 @@ namespace graphene { namespace net { namespace detail {
       if (regular_item_iter != originating_peer->items_requested_from_peer.end())
       {
         originating_peer->items_requested_from_peer.erase( regular_item_iter );
+        if (requested_item.item_type == block_message_type)
+          originating_peer->compact_blocks_in_progress.erase(requested_item.item_hash);
         originating_peer->inventory_peer_advertised_to_us.erase( requested_item );
         if (is_item_in_any_peers_inventory(requested_item))
           _items_to_fetch.insert(prioritized_item_id(requested_item, _items_to_fetch_sequence_counter++));
@@ -3094,6 +3159,163 @@ namespace graphene { namespace net { namespace detail {
       dlog("Peer doesn't have an item we're looking for, which is fine because we weren't looking for it");
     }
 
+    void node_impl::on_compact_block_message(peer_connection* originating_peer, const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const message_hash_type& block_message_hash = compact_block_message_received.block_message_hash;
+      if (originating_peer->items_requested_from_peer.find(item_id(block_message_type, block_message_hash)) == originating_peer->items_requested_from_peer.end() ||
+          originating_peer->compact_blocks_in_progress.find(block_message_hash) != originating_peer->compact_blocks_in_progress.end())
+      {
+        wlog("received a compact block ${block_id} I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("endpoint", originating_peer->get_remote_endpoint())
+             ("block_id", compact_block_message_received.block_id));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me a block that I didn't ask for, block_id: ${block_id}",
+                                                    ("block_id", compact_block_message_received.block_id)));
+        disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true, detailed_error);
+        return;
+      }
+
+      // look the transactions up in the message cache, then among the pending transactions of the client,
+      // which also holds the transactions that dropped out of the cache
+      peer_connection::compact_block_in_progress compact_block;
+      compact_block.compact_block = compact_block_message_received;
+      compact_block.transactions.resize(compact_block_message_received.transactions.size());
+      bool pending_transactions_loaded = false;
+      std::unordered_map<uint64_t, signed_transaction> pending_transactions;
+      for (uint32_t i = 0; i < compact_block_message_received.transactions.size(); ++i)
+      {
+        const uint64_t short_id = compact_block_message_received.transactions[i].short_id;
+        fc::optional<message> transaction_message = _message_cache.find_transaction_message(short_id);
+        if (transaction_message)
+        {
+          compact_block.transactions[i] = transaction_message->as<trx_message>().trx;
+          continue;
+        }
+        if (!pending_transactions_loaded)
+        {
+          for (const signed_transaction& trx : _delegate->get_pending_transactions())
+            pending_transactions.emplace(short_transaction_id(message(trx_message(trx)).id()), trx);
+          pending_transactions_loaded = true;
+        }
+        auto pending_iter = pending_transactions.find(short_id);
+        if (pending_iter != pending_transactions.end())
+          compact_block.transactions[i] = pending_iter->second;
+        else
+          compact_block.requested_indexes.push_back(i);
+      }
+      dlog("received compact block ${block_id} from peer ${endpoint}, missing ${missing} of ${count} transactions",
+           ("block_id", compact_block_message_received.block_id)
+           ("endpoint", originating_peer->get_remote_endpoint())
+           ("missing", compact_block.requested_indexes.size())
+           ("count", compact_block_message_received.transactions.size()));
+
+      if (compact_block.requested_indexes.empty())
+      {
+        if (process_compact_block(originating_peer, compact_block))
+          return;
+        // one of the short ids matched another transaction, ask for all of them
+        for (uint32_t i = 0; i < compact_block.transactions.size(); ++i)
+          compact_block.requested_indexes.push_back(i);
+      }
+      originating_peer->send_message(get_compact_block_transactions_message(block_message_hash, compact_block.requested_indexes));
+      originating_peer->compact_blocks_in_progress[block_message_hash] = std::move(compact_block);
+    }
+
+    void node_impl::on_get_compact_block_transactions_message(peer_connection* originating_peer,
+                                                              const get_compact_block_transactions_message& get_compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const message_hash_type& block_message_hash = get_compact_block_transactions_message_received.block_message_hash;
+      graphene::net::block_message full_block;
+      try
+      {
+        full_block = _message_cache.get_message(block_message_hash).as<graphene::net::block_message>();
+      }
+      catch (fc::key_not_found_exception&)
+      {
+        // the block dropped out of our cache, the peer will fetch it from another peer
+        originating_peer->send_message(item_not_available_message(item_id(block_message_type, block_message_hash)));
+        return;
+      }
+
+      compact_block_transactions_message reply;
+      reply.block_message_hash = block_message_hash;
+      for (uint32_t index : get_compact_block_transactions_message_received.transaction_indexes)
+      {
+        if (index >= full_block.block.transactions.size())
+        {
+          fc::exception detailed_error(FC_LOG_MESSAGE(error, "You asked for transaction ${index} of block ${block_id}, which has ${count} transactions",
+                                                      ("index", index)("block_id", full_block.block_id)("count", full_block.block.transactions.size())));
+          disconnect_from_peer(originating_peer, "You asked for a transaction that is not in the block", true, detailed_error);
+          return;
+        }
+        reply.transactions.push_back(full_block.block.transactions[index]);
+      }
+      originating_peer->send_message(reply);
+    }
+
+    void node_impl::on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                          const compact_block_transactions_message& compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      auto iter = originating_peer->compact_blocks_in_progress.find(compact_block_transactions_message_received.block_message_hash);
+      if (iter == originating_peer->compact_blocks_in_progress.end() ||
+          iter->second.requested_indexes.size() != compact_block_transactions_message_received.transactions.size())
+      {
+        wlog("received transactions of a compact block I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me transactions that I didn't ask for, block message hash: ${hash}",
+                                                    ("hash", compact_block_transactions_message_received.block_message_hash)));
+        disconnect_from_peer(originating_peer, "You sent me transactions that I didn't ask for", true, detailed_error);
+        return;
+      }
+      peer_connection::compact_block_in_progress compact_block = std::move(iter->second);
+      originating_peer->compact_blocks_in_progress.erase(iter);
+
+      for (uint32_t i = 0; i < compact_block.requested_indexes.size(); ++i)
+        compact_block.transactions[compact_block.requested_indexes[i]] = compact_block_transactions_message_received.transactions[i];
+      if (process_compact_block(originating_peer, compact_block))
+        return;
+
+      if (compact_block.requested_indexes.size() == compact_block.transactions.size())
+      {
+        wlog("compact block ${block_id} from peer ${endpoint} doesn't match the block it was sent for, disconnecting from peer",
+             ("block_id", compact_block.compact_block.block_id)
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "Your compact block ${block_id} doesn't match the block it was sent for",
+                                                    ("block_id", compact_block.compact_block.block_id)));
+        disconnect_from_peer(originating_peer, "You sent me a compact block that doesn't match its block", true, detailed_error);
+        return;
+      }
+
+      // one of the short ids we resolved ourselves matched another transaction, ask for all of them
+      compact_block.requested_indexes.clear();
+      for (uint32_t i = 0; i < compact_block.transactions.size(); ++i)
+        compact_block.requested_indexes.push_back(i);
+      originating_peer->send_message(get_compact_block_transactions_message(compact_block.compact_block.block_message_hash,
+                                                                            compact_block.requested_indexes));
+      originating_peer->compact_blocks_in_progress[compact_block.compact_block.block_message_hash] = std::move(compact_block);
+    }
+
+    bool node_impl::process_compact_block(peer_connection* originating_peer,
+                                          const peer_connection::compact_block_in_progress& compact_block)
+    {
+      VERIFY_CORRECT_THREAD();
+      std::vector<signed_transaction> transactions;
+      transactions.reserve(compact_block.transactions.size());
+      for (const fc::optional<signed_transaction>& trx : compact_block.transactions)
+        transactions.push_back(*trx);
+
+      // the hash covers the whole block, so a match means we rebuilt exactly the block the peer relayed
+      message block_message_to_process = block_message_from_compact(compact_block.compact_block, transactions);
+      message_hash_type message_hash = block_message_to_process.id();
+      if (message_hash != compact_block.compact_block.block_message_hash)
+        return false;
+
+      process_block_message(originating_peer, block_message_to_process, message_hash);
+      return true;
+    }
+
     void node_impl::on_item_ids_inventory_message(peer_connection* originating_peer, const item_ids_inventory_message& item_ids_inventory_message_received)
     {
       VERIFY_CORRECT_THREAD();
@@ -5979,6 +6201,11 @@ namespace graphene { namespace net { namespace detail {
       INVOKE_AND_COLLECT_STATISTICS(get_current_block_interval_in_seconds);
     }
 
+    std::vector<signed_transaction> statistics_gathering_node_delegate_wrapper::get_pending_transactions()
+    {
+      INVOKE_AND_COLLECT_STATISTICS(get_pending_transactions);
+    }
+
 #undef INVOKE_AND_COLLECT_STATISTICS
 
   } // end namespace detail
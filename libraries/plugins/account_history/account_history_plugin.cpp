@@ -69,7 +69,7 @@ class account_history_plugin_impl
       uint32_t _max_ops_per_account = -1;
    private:
       /** add one history record, then check and remove the earliest history record */
-      void add_account_history( const account_id_type account_id, const operation_history_id_type op_id );
+      void add_account_history( const account_id_type account_id, const operation_history_object& op );
 
 };
 
@@ -170,7 +170,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                   // that indexing now happens in observers' post_evaluate()
 
                   // add history
-                  add_account_history( account_id, oho->id );
+                  add_account_history( account_id, *oho );
                }
             }
          }
@@ -190,7 +190,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                   {
                      if (!oho.valid()) { oho = create_oho(); }
                      // add history
-                     add_account_history( account_id, oho->id );
+                     add_account_history( account_id, *oho );
                   }
                }
             }
@@ -213,15 +213,16 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
    }
 }
 
-void account_history_plugin_impl::add_account_history( const account_id_type account_id, const operation_history_id_type op_id )
+void account_history_plugin_impl::add_account_history( const account_id_type account_id, const operation_history_object& op )
 {
    graphene::chain::database& db = database();
    const auto& stats_obj = account_id(db).statistics(db);
    // add new entry
    const auto& ath = db.create<account_transaction_history_object>( [&]( account_transaction_history_object& obj ){
-       obj.operation_id = op_id;
+       obj.operation_id = op.id;
        obj.account = account_id;
        obj.sequence = stats_obj.total_ops + 1;
+       obj.operation_type = op.op.which();
        obj.next = stats_obj.most_recent_op;
    });
    db.modify( stats_obj, [&]( account_statistics_object& obj ){
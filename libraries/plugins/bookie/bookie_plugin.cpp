@@ -144,15 +144,6 @@ class bookie_plugin_impl
       { }
       virtual ~bookie_plugin_impl();
 
-      /**
-       *  Called After a block has been applied and committed.  The callback
-       *  should not yield and should execute quickly.
-       */
-      void on_objects_changed(const vector<object_id_type>& changed_object_ids);
-
-      void on_objects_new(const vector<object_id_type>& new_object_ids);
-      void on_objects_removed(const vector<object_id_type>& removed_object_ids);
-
       /** this method is called as a callback after a block is applied
        * and will process/index all operations that were applied in the block.
        */
@@ -191,18 +182,6 @@ bookie_plugin_impl::~bookie_plugin_impl()
 {
 }
 
-void bookie_plugin_impl::on_objects_new(const vector<object_id_type>& new_object_ids)
-{
-}
-
-void bookie_plugin_impl::on_objects_removed(const vector<object_id_type>& removed_object_ids)
-{
-}
-
-void bookie_plugin_impl::on_objects_changed(const vector<object_id_type>& changed_object_ids)
-{
-}
-
 bool is_operation_history_object_stored(operation_history_id_type id)
 {
    if (id == operation_history_id_type())
@@ -412,9 +391,6 @@ void bookie_plugin::plugin_initialize(const boost::program_options::variables_ma
     ilog("bookie plugin: plugin_startup() begin");
     database().force_slow_replays();
     database().applied_block.connect( [&]( const signed_block& b){ my->on_block_applied(b); } );
-    database().changed_objects.connect([&](const vector<object_id_type>& changed_object_ids, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts){ my->on_objects_changed(changed_object_ids); });
-    database().new_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) { my->on_objects_new(ids); });
-    database().removed_objects.connect([this](const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) { my->on_objects_removed(ids); });
 
     const primary_index<bet_object_index>& bet_object_idx = database().get_index_type<primary_index<bet_object_index> >();
     primary_index<bet_object_index>& nonconst_bet_object_idx = const_cast<primary_index<bet_object_index>&>(bet_object_idx);
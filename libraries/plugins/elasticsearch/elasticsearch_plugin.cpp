@@ -67,6 +67,7 @@ class elasticsearch_plugin_impl
       std::string _elasticsearch_node_url = "http://localhost:9200/";
       uint32_t _elasticsearch_bulk_replay = 10000;
       uint32_t _elasticsearch_bulk_sync = 100;
+      uint32_t _elasticsearch_bulk_queue = 16;
       bool _elasticsearch_visitor = false;
       std::string _elasticsearch_basic_auth = "";
       std::string _elasticsearch_index_prefix = "peerplays-";
@@ -77,8 +78,8 @@ class elasticsearch_plugin_impl
       CURL *curl; // curl handler
       vector <string> bulk_lines; //  vector of op lines
       vector<std::string> prepare;
+      std::unique_ptr<graphene::utilities::BulkSender> sender;
 
-      graphene::utilities::ES es;
       uint32_t limit_documents;
       int16_t op_type;
       operation_history_struct os;
@@ -105,12 +106,14 @@ class elasticsearch_plugin_impl
       void cleanObjects(const account_transaction_history_id_type& ath, const account_id_type& account_id);
       void createBulkLine(const account_transaction_history_object& ath);
       void prepareBulk(const account_transaction_history_id_type& ath_id);
-      void populateESstruct();
+      bool sendBulk();
       void init_program_options(const boost::program_options::variables_map& options);
 };
 
 elasticsearch_plugin_impl::~elasticsearch_plugin_impl()
 {
+   // stores the batches still queued before the handle used for queries goes away
+   sender.reset();
    if (curl) {
       curl_easy_cleanup(curl);
       curl = nullptr;
@@ -196,27 +199,8 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
       }
    }
    // we send bulk at end of block when we are in sync for better real time client experience
-   if(is_sync)
-   {
-      populateESstruct();
-      if(es.bulk_lines.size() > 0)
-      {
-         prepare.clear();
-         if(!graphene::utilities::SendBulk(es))
-         {
-            // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
-            elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
-                  ("n",es.bulk_lines.size()) );
-            for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
-            {
-               edump( (es.bulk_lines[i]) );
-            }
-            return false;
-         }
-         else
-            bulk_lines.clear();
-      }
-   }
+   if(is_sync && !sendBulk())
+      return false;
 
    if(bulk_lines.size() != limit_documents)
       bulk_lines.reserve(limit_documents);
@@ -486,23 +470,8 @@ bool elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account
    }
    cleanObjects(ath.id, account_id);
 
-   if (curl && bulk_lines.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-      prepare.clear();
-      populateESstruct();
-      if(!graphene::utilities::SendBulk(es))
-      {
-         // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
-         elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
-               ("n",es.bulk_lines.size()) );
-         for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
-         {
-            edump( (es.bulk_lines[i]) );
-         }
-         return false;
-      }
-      else
-         bulk_lines.clear();
-   }
+   if (bulk_lines.size() >= limit_documents) // we are in bulk time, ready to add data to elasticsearech
+      return sendBulk();
 
    return true;
 }
@@ -524,6 +493,7 @@ const account_transaction_history_object& elasticsearch_plugin_impl::addNewEntry
       obj.operation_id = oho->id;
       obj.account = account_id;
       obj.sequence = stats_obj.total_ops + 1;
+      obj.operation_type = oho->op.which();
       obj.next = stats_obj.most_recent_op;
    });
 
@@ -595,15 +565,17 @@ void elasticsearch_plugin_impl::cleanObjects(const account_transaction_history_i
    }
 }
 
-void elasticsearch_plugin_impl::populateESstruct()
+bool elasticsearch_plugin_impl::sendBulk()
 {
-   es.curl = curl;
-   es.bulk_lines = std::move(bulk_lines);
-   es.elasticsearch_url = _elasticsearch_node_url;
-   es.auth = _elasticsearch_basic_auth;
-   es.index_prefix = _elasticsearch_index_prefix;
-   es.endpoint = "";
-   es.query = "";
+   prepare.clear();
+   // only blocks the chain while the sender already has a full queue of batches
+   if(!sender->send(std::move(bulk_lines)))
+   {
+      elog( "Elastic Search rejected bulk data, no more account history is sent" );
+      return false;
+   }
+   bulk_lines.clear();
+   return true;
 }
 
 void elasticsearch_plugin_impl::init_program_options(const boost::program_options::variables_map& options)
@@ -617,6 +589,9 @@ void elasticsearch_plugin_impl::init_program_options(const boost::program_option
    if (options.count("elasticsearch-bulk-sync")) {
       _elasticsearch_bulk_sync = options["elasticsearch-bulk-sync"].as<uint32_t>();
    }
+   if (options.count("elasticsearch-bulk-queue")) {
+      _elasticsearch_bulk_queue = options["elasticsearch-bulk-queue"].as<uint32_t>();
+   }
    if (options.count("elasticsearch-visitor")) {
       _elasticsearch_visitor = options["elasticsearch-visitor"].as<bool>();
    }
@@ -675,6 +650,8 @@ void elasticsearch_plugin::plugin_set_program_options(
                "Number of bulk documents to index on replay(10000)")
          ("elasticsearch-bulk-sync", boost::program_options::value<uint32_t>(),
                "Number of bulk documents to index on a syncronied chain(100)")
+         ("elasticsearch-bulk-queue", boost::program_options::value<uint32_t>(),
+               "Number of bulk requests queued for sending before block processing waits for them(16)")
          ("elasticsearch-visitor", boost::program_options::value<bool>(),
                "Use visitor to index additional data(slows down the replay(false))")
          ("elasticsearch-basic-auth", boost::program_options::value<std::string>(),
@@ -707,6 +684,9 @@ void elasticsearch_plugin::plugin_initialize(const boost::program_options::varia
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
                "If elasticsearch-mode is set to all then elasticsearch-operation-string need to be true");
 
+      my->sender.reset(new graphene::utilities::BulkSender(my->_elasticsearch_node_url, my->_elasticsearch_basic_auth,
+                                                          my->_elasticsearch_bulk_queue));
+
       database().applied_block.connect([this](const signed_block &b) {
          if (!my->update_account_histories(b))
             FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
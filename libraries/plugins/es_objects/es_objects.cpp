@@ -74,6 +74,7 @@ class es_objects_plugin_impl
       std::string _es_objects_auth = "";
       uint32_t _es_objects_bulk_replay = 10000;
       uint32_t _es_objects_bulk_sync = 100;
+      uint32_t _es_objects_bulk_queue = 16;
       bool _es_objects_proposals = true;
       bool _es_objects_accounts = true;
       bool _es_objects_assets = true;
@@ -95,6 +96,7 @@ class es_objects_plugin_impl
       CURL *curl; // curl handler
       vector <std::string> bulk;
       vector<std::string> prepare;
+      std::unique_ptr<graphene::utilities::BulkSender> sender;
 
       bool _es_objects_keep_only_current = true;
 
@@ -271,15 +273,10 @@ bool es_objects_plugin_impl::genesis()
       });
    }
 
-   graphene::utilities::ES es;
-   es.curl = curl;
-   es.bulk_lines = bulk;
-   es.elasticsearch_url = _es_objects_elasticsearch_url;
-   es.auth = _es_objects_auth;
-   if (!graphene::utilities::SendBulk(es))
-      FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Error inserting genesis data.");
-   else
-      bulk.clear();
+   // genesis objects must be stored before any update of them is indexed
+   if(!sender->send(std::move(bulk)) || !sender->flush())
+      return false;
+   bulk.clear();
 
    return true;
 }
@@ -503,18 +500,10 @@ bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, s
          }
       }
 
-      if (curl && bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-
-         graphene::utilities::ES es;
-         es.curl = curl;
-         es.bulk_lines = bulk;
-         es.elasticsearch_url = _es_objects_elasticsearch_url;
-         es.auth = _es_objects_auth;
-
-         if (!graphene::utilities::SendBulk(es))
+      if (bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
+         if (!sender->send(std::move(bulk)))
             return false;
-         else
-            bulk.clear();
+         bulk.clear();
       }
    }
 
@@ -568,6 +557,7 @@ void es_objects_plugin_impl::prepareTemplate(T blockchain_object, string index_n
 
 es_objects_plugin_impl::~es_objects_plugin_impl()
 {
+   sender.reset();
    if (curl) {
       curl_easy_cleanup(curl);
       curl = nullptr;
@@ -588,6 +578,9 @@ void es_objects_plugin_impl::init_program_options(const boost::program_options::
    if (options.count("es-objects-bulk-sync")) {
       _es_objects_bulk_sync = options["es-objects-bulk-sync"].as<uint32_t>();
    }
+   if (options.count("es-objects-bulk-queue")) {
+      _es_objects_bulk_queue = options["es-objects-bulk-queue"].as<uint32_t>();
+   }
    if (options.count("es-objects-proposals")) {
       _es_objects_proposals = options["es-objects-proposals"].as<bool>();
    }
@@ -674,6 +667,8 @@ void es_objects_plugin::plugin_set_program_options(
                "Number of bulk documents to index on replay(10000)")
          ("es-objects-bulk-sync", boost::program_options::value<uint32_t>(),
                "Number of bulk documents to index on a synchronized chain(100)")
+         ("es-objects-bulk-queue", boost::program_options::value<uint32_t>(),
+               "Number of bulk requests queued for sending before block processing waits for them(16)")
          ("es-objects-proposals", boost::program_options::value<bool>(), "Store proposal objects(true)")
          ("es-objects-accounts", boost::program_options::value<bool>(), "Store account objects(true)")
          ("es-objects-assets", boost::program_options::value<bool>(), "Store asset objects(true)")
@@ -704,6 +699,9 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
 
    my->init_program_options( options );
 
+   my->sender.reset(new graphene::utilities::BulkSender(my->_es_objects_elasticsearch_url, my->_es_objects_auth,
+                                                       my->_es_objects_bulk_queue));
+
    database().applied_block.connect([this](const signed_block &b) {
       if(b.block_num() == 1 && my->_es_objects_start_es_after_block == 0) {
          if (!my->genesis())
@@ -106,7 +106,41 @@ struct order_history_object : public abstract_object<order_history_object>
   fill_order_operation op;
 };
 
+/**
+ *  Rolling 24 hour statistics of a market, kept current as trades are filled and leave the window.
+ *  base is always the asset with the lower id.
+ */
+struct market_ticker_object : public abstract_object<market_ticker_object>
+{
+   static const uint8_t space_id = ACCOUNT_HISTORY_SPACE_ID;
+   static const uint8_t type_id  = 2;
+
+   asset_id_type       base;
+   asset_id_type       quote;
+   /// amounts of the most recent trade
+   share_type          latest_base;
+   share_type          latest_quote;
+   /// amounts of the most recent trade which is older than 24 hours
+   share_type          last_day_base;
+   share_type          last_day_quote;
+   /// volumes of the trades of the last 24 hours
+   share_type          base_volume;
+   share_type          quote_volume;
+};
+
+/// Tracks the newest order history object whose trade has been removed from the tickers
+struct market_ticker_meta_object : public abstract_object<market_ticker_meta_object>
+{
+   static const uint8_t space_id = ACCOUNT_HISTORY_SPACE_ID;
+   static const uint8_t type_id  = 3;
+
+   fc::time_point_sec  expired_time;
+   object_id_type      expired_id;
+};
+
 struct by_key;
+struct by_time;
+struct by_market;
 typedef multi_index_container<
    bucket_object,
    indexed_by<
@@ -119,13 +153,33 @@ typedef multi_index_container<
    order_history_object,
    indexed_by<
       hashed_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
-      ordered_unique< tag<by_key>, member< order_history_object, history_key, &order_history_object::key > >
+      ordered_unique< tag<by_key>, member< order_history_object, history_key, &order_history_object::key > >,
+      ordered_unique< tag<by_time>,
+         composite_key< order_history_object,
+            member< order_history_object, fc::time_point_sec, &order_history_object::time >,
+            member< object, object_id_type, &object::id >
+         >
+      >
    >
 > order_history_multi_index_type;
 
+typedef multi_index_container<
+   market_ticker_object,
+   indexed_by<
+      hashed_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_market>,
+         composite_key< market_ticker_object,
+            member< market_ticker_object, asset_id_type, &market_ticker_object::base >,
+            member< market_ticker_object, asset_id_type, &market_ticker_object::quote >
+         >
+      >
+   >
+> market_ticker_multi_index_type;
+
 
 typedef generic_index<bucket_object, bucket_object_multi_index_type> bucket_index;
 typedef generic_index<order_history_object, order_history_multi_index_type> history_index;
+typedef generic_index<market_ticker_object, market_ticker_multi_index_type> market_ticker_index;
 
 
 namespace detail
@@ -135,8 +189,9 @@ namespace detail
 
 /**
  *  The market history plugin can be configured to track any number of intervals via its configuration.  Once per block it
- *  will scan the virtual operations and look for fill_order_operations and then adjust the appropriate bucket objects for
- *  each fill order.
+ *  will scan the virtual operations and look for fill_order_operations, aggregate the fills of each bucket in memory and
+ *  then create or adjust each affected bucket object once.  While replaying irreversible blocks the fills of several
+ *  blocks are aggregated before the buckets are written.
  */
 class market_history_plugin : public graphene::app::plugin
 {
@@ -151,6 +206,7 @@ class market_history_plugin : public graphene::app::plugin
       virtual void plugin_initialize(
          const boost::program_options::variables_map& options) override;
       virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
 
       uint32_t                    max_history()const;
       const flat_set<uint32_t>&   tracked_buckets()const;
@@ -172,4 +228,11 @@ FC_REFLECT_DERIVED( graphene::market_history::bucket_object, (graphene::db::obje
                     (open_base)(open_quote)
                     (close_base)(close_quote)
                     (base_volume)(quote_volume) )
+FC_REFLECT_DERIVED( graphene::market_history::market_ticker_object, (graphene::db::object),
+                    (base)(quote)
+                    (latest_base)(latest_quote)
+                    (last_day_base)(last_day_quote)
+                    (base_volume)(quote_volume) )
+FC_REFLECT_DERIVED( graphene::market_history::market_ticker_meta_object, (graphene::db::object),
+                    (expired_time)(expired_id) )
 
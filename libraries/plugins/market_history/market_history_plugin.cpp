@@ -33,6 +33,8 @@
 #include <graphene/chain/transaction_evaluation_state.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
+#include <graphene/db/simple_index.hpp>
+
 #include <fc/thread/thread.hpp>
 
 namespace graphene { namespace market_history {
@@ -52,6 +54,16 @@ class market_history_plugin_impl
        */
       void update_market_histories( const signed_block& b );
 
+      /** writes the aggregated fills to the bucket objects and then removes the buckets
+       * which are too old from the affected markets
+       */
+      void flush_buckets();
+
+      /** removes the trades which are older than 24 hours from the market tickers, creating the
+       * tickers from the stored order history first if they do not exist yet
+       */
+      void update_tickers( fc::time_point_sec now );
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -60,16 +72,50 @@ class market_history_plugin_impl
       market_history_plugin&     _self;
       flat_set<uint32_t>         _tracked_buckets;
       uint32_t                   _maximum_history_per_bucket_size = 1000;
+      uint32_t                   _replay_flush_blocks = 100;
+
+      /// fills of the blocks applied since the last flush, aggregated per bucket
+      std::map<bucket_key, bucket_object> _pending_buckets;
+      uint32_t                            _pending_blocks = 0;
 };
 
 
+/// adds a trade to the ticker of its market, only called for the side of a match where pays has the lower asset id
+static void add_to_ticker( graphene::chain::database& db, const fill_order_operation& o )
+{
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   auto itr = ticker_idx.find( boost::make_tuple( o.pays.asset_id, o.receives.asset_id ) );
+   if( itr == ticker_idx.end() )
+   {
+      db.create<market_ticker_object>( [&o]( market_ticker_object& t ) {
+         t.base = o.pays.asset_id;
+         t.quote = o.receives.asset_id;
+         t.latest_base = o.pays.amount;
+         t.latest_quote = o.receives.amount;
+         t.base_volume = o.pays.amount;
+         t.quote_volume = o.receives.amount;
+      });
+   }
+   else
+   {
+      db.modify( *itr, [&o]( market_ticker_object& t ) {
+         t.latest_base = o.pays.amount;
+         t.latest_quote = o.receives.amount;
+         t.base_volume += o.pays.amount;
+         t.quote_volume += o.receives.amount;
+      });
+   }
+}
+
 struct operation_process_fill_order
 {
    market_history_plugin&    _plugin;
    fc::time_point_sec        _now;
+   std::map<bucket_key, bucket_object>& _pending_buckets;
 
-   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n )
-   :_plugin(mhp),_now(n) {}
+   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n,
+                                 std::map<bucket_key, bucket_object>& pending_buckets )
+   :_plugin(mhp),_now(n),_pending_buckets(pending_buckets) {}
 
    typedef void result_type;
 
@@ -82,7 +128,6 @@ struct operation_process_fill_order
       //ilog( "processing ${o}", ("o",o) );
       const auto& buckets = _plugin.tracked_buckets();
       auto& db         = _plugin.database();
-      const auto& bucket_idx = db.get_index_type<bucket_index>();
       const auto& history_idx = db.get_index_type<history_index>().indices().get<by_key>();
 
       auto time = db.head_block_time();
@@ -107,6 +152,9 @@ struct operation_process_fill_order
          ho.op = o;
       });
 
+      if( o.pays.asset_id < o.receives.asset_id )
+         add_to_ticker( db, o );
+
       hkey.sequence += 200;
       itr = history_idx.lower_bound( hkey );
       /*
@@ -122,11 +170,8 @@ struct operation_process_fill_order
       */
 
 
-      auto max_history = _plugin.max_history();
       for( auto bucket : buckets )
       {
-          auto cutoff      = (fc::time_point() + fc::seconds( bucket * max_history));
-
           bucket_key key;
           key.base    = o.pays.asset_id;
           key.quote   = o.receives.asset_id;
@@ -147,63 +192,39 @@ struct operation_process_fill_order
           key.seconds = bucket;
           key.open    = fc::time_point() + fc::seconds((_now.sec_since_epoch() / key.seconds) * key.seconds);
 
-          const auto& by_key_idx = bucket_idx.indices().get<by_key>();
-          auto itr = by_key_idx.find( key );
-          if( itr == by_key_idx.end() )
-          { // create new bucket
-            /* const auto& obj = */
-            db.create<bucket_object>( [&]( bucket_object& b ){
-                 b.key = key;
-                 b.quote_volume += trade_price.quote.amount;
-                 b.base_volume += trade_price.base.amount;
-                 b.open_base = trade_price.base.amount;
-                 b.open_quote = trade_price.quote.amount;
-                 b.close_base = trade_price.base.amount;
-                 b.close_quote = trade_price.quote.amount;
-                 b.high_base = b.close_base;
-                 b.high_quote = b.close_quote;
-                 b.low_base = b.close_base;
-                 b.low_quote = b.close_quote;
-            });
-            //wlog( "    creating bucket ${b}", ("b",obj) );
+          // the bucket objects are only written by flush_buckets(), here the fills are aggregated the same way
+          auto itr = _pending_buckets.find( key );
+          if( itr == _pending_buckets.end() )
+          { // first fill of this bucket since the last flush
+             bucket_object& b = _pending_buckets[key];
+             b.key = key;
+             b.quote_volume += trade_price.quote.amount;
+             b.base_volume += trade_price.base.amount;
+             b.open_base = trade_price.base.amount;
+             b.open_quote = trade_price.quote.amount;
+             b.close_base = trade_price.base.amount;
+             b.close_quote = trade_price.quote.amount;
+             b.high_base = b.close_base;
+             b.high_quote = b.close_quote;
+             b.low_base = b.close_base;
+             b.low_quote = b.close_quote;
           }
           else
-          { // update existing bucket
-             //wlog( "    before updating bucket ${b}", ("b",*itr) );
-             db.modify( *itr, [&]( bucket_object& b ){
-                  b.base_volume += trade_price.base.amount;
-                  b.quote_volume += trade_price.quote.amount;
-                  b.close_base = trade_price.base.amount;
-                  b.close_quote = trade_price.quote.amount;
-                  if( b.high() < trade_price ) 
-                  {
-                      b.high_base = b.close_base;
-                      b.high_quote = b.close_quote;
-                  }
-                  if( b.low() > trade_price ) 
-                  {
-                      b.low_base = b.close_base;
-                      b.low_quote = b.close_quote;
-                  }
-             });
-             //wlog( "    after bucket bucket ${b}", ("b",*itr) );
-          }
-
-          if( max_history != 0  )
           {
-             key.open = fc::time_point_sec();
-             auto itr = by_key_idx.lower_bound( key );
-
-             while( itr != by_key_idx.end() && 
-                    itr->key.base == key.base && 
-                    itr->key.quote == key.quote && 
-                    itr->key.seconds == bucket && 
-                    itr->key.open < cutoff )
+             bucket_object& b = itr->second;
+             b.base_volume += trade_price.base.amount;
+             b.quote_volume += trade_price.quote.amount;
+             b.close_base = trade_price.base.amount;
+             b.close_quote = trade_price.quote.amount;
+             if( b.high() < trade_price ) 
+             {
+                 b.high_base = b.close_base;
+                 b.high_quote = b.close_quote;
+             }
+             if( b.low() > trade_price ) 
              {
-              //  elog( "    removing old bucket ${b}", ("b", *itr) );
-                auto old_itr = itr;
-                ++itr;
-                db.remove( *old_itr );
+                 b.low_base = b.close_base;
+                 b.low_quote = b.close_quote;
              }
           }
       }
@@ -223,8 +244,145 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
    for( const optional< operation_history_object >& o_op : hist )
    {
       if( o_op.valid() )
-         o_op->op.visit( operation_process_fill_order( _self, b.timestamp ) );
+         o_op->op.visit( operation_process_fill_order( _self, b.timestamp, _pending_buckets ) );
    }
+
+   update_tickers( b.timestamp );
+
+   // Blocks which can be popped must leave nothing behind, because their fills would be counted again
+   // when they are reapplied.  Without undo history they are irreversible and the writes can be batched,
+   // the batch is written out by replayed_irreversible_blocks before undo is enabled again, and by
+   // saving_object_database before the state is written to disk.
+   ++_pending_blocks;
+   if( db.undo_enabled() || _pending_blocks >= _replay_flush_blocks )
+      flush_buckets();
+}
+
+void market_history_plugin_impl::update_tickers( fc::time_point_sec now )
+{
+   graphene::chain::database& db = database();
+   const auto& history_idx = db.get_index_type<history_index>().indices().get<by_time>();
+   const auto& meta_idx = db.get_index_type< simple_index< market_ticker_meta_object > >();
+
+   if( meta_idx.begin() == meta_idx.end() )
+   {
+      // first run with an existing order history, everything still in the history is added and then expired below
+      db.create<market_ticker_meta_object>( []( market_ticker_meta_object& ) {} );
+      for( const order_history_object& ho : history_idx )
+         if( ho.op.pays.asset_id < ho.op.receives.asset_id )
+            add_to_ticker( db, ho.op );
+   }
+   const market_ticker_meta_object& meta = *meta_idx.begin();
+
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   const fc::time_point_sec cutoff( now.sec_since_epoch() > 86400 ? now.sec_since_epoch() - 86400 : 0 );
+   const order_history_object* last_expired = nullptr;
+   // the order history ordered by time is the ring of the last 24 hours, starting after the last expired trade
+   for( auto itr = history_idx.upper_bound( boost::make_tuple( meta.expired_time, meta.expired_id ) );
+        itr != history_idx.end() && itr->time < cutoff; ++itr )
+   {
+      last_expired = &*itr;
+      const fill_order_operation& o = itr->op;
+      if( !( o.pays.asset_id < o.receives.asset_id ) )
+         continue;
+      auto ticker = ticker_idx.find( boost::make_tuple( o.pays.asset_id, o.receives.asset_id ) );
+      if( ticker == ticker_idx.end() )
+         continue;
+      db.modify( *ticker, [&o]( market_ticker_object& t ) {
+         t.last_day_base = o.pays.amount;
+         t.last_day_quote = o.receives.amount;
+         t.base_volume -= o.pays.amount;
+         t.quote_volume -= o.receives.amount;
+      });
+   }
+
+   if( last_expired != nullptr )
+   {
+      db.modify( meta, [last_expired]( market_ticker_meta_object& m ) {
+         m.expired_time = last_expired->time;
+         m.expired_id = last_expired->id;
+      });
+   }
+}
+
+void market_history_plugin_impl::flush_buckets()
+{
+   _pending_blocks = 0;
+   if( _pending_buckets.empty() )
+      return;
+
+   graphene::chain::database& db = database();
+   const auto& by_key_idx = db.get_index_type<bucket_index>().indices().get<by_key>();
+
+   for( const auto& pending : _pending_buckets )
+   {
+      const bucket_object& fills = pending.second;
+      auto itr = by_key_idx.find( pending.first );
+      if( itr == by_key_idx.end() )
+      { // create new bucket
+         db.create<bucket_object>( [&fills]( bucket_object& b ){
+            b.key = fills.key;
+            b.high_base = fills.high_base;
+            b.high_quote = fills.high_quote;
+            b.low_base = fills.low_base;
+            b.low_quote = fills.low_quote;
+            b.open_base = fills.open_base;
+            b.open_quote = fills.open_quote;
+            b.close_base = fills.close_base;
+            b.close_quote = fills.close_quote;
+            b.base_volume = fills.base_volume;
+            b.quote_volume = fills.quote_volume;
+         });
+      }
+      else
+      { // update existing bucket, the existing high and low were reached before any of the aggregated fills
+         db.modify( *itr, [&fills]( bucket_object& b ){
+            b.base_volume += fills.base_volume;
+            b.quote_volume += fills.quote_volume;
+            b.close_base = fills.close_base;
+            b.close_quote = fills.close_quote;
+            if( b.high() < fills.high() )
+            {
+               b.high_base = fills.high_base;
+               b.high_quote = fills.high_quote;
+            }
+            if( b.low() > fills.low() )
+            {
+               b.low_base = fills.low_base;
+               b.low_quote = fills.low_quote;
+            }
+         });
+      }
+   }
+
+   // prune once per market and bucket size instead of once per fill
+   const uint32_t max_history = _maximum_history_per_bucket_size;
+   bucket_key last_series;
+   for( const auto& pending : _pending_buckets )
+   {
+      bucket_key key = pending.first;
+      if( key.base == last_series.base && key.quote == last_series.quote && key.seconds == last_series.seconds )
+         continue;
+      last_series = key;
+
+      auto cutoff = (fc::time_point() + fc::seconds( key.seconds * max_history ));
+      key.open = fc::time_point_sec();
+      auto itr = by_key_idx.lower_bound( key );
+
+      while( itr != by_key_idx.end() && 
+             itr->key.base == key.base && 
+             itr->key.quote == key.quote && 
+             itr->key.seconds == key.seconds && 
+             itr->key.open < cutoff )
+      {
+         //  elog( "    removing old bucket ${b}", ("b", *itr) );
+         auto old_itr = itr;
+         ++itr;
+         db.remove( *old_itr );
+      }
+   }
+
+   _pending_buckets.clear();
 }
 
 } // end namespace detail
@@ -258,6 +416,8 @@ void market_history_plugin::plugin_set_program_options(
            "Track market history by grouping orders into buckets of equal size measured in seconds specified as a JSON array of numbers")
          ("history-per-size", boost::program_options::value<uint32_t>()->default_value(1000), 
            "How far back in time to track history for each bucket size, measured in the number of buckets (default: 1000)")
+         ("bucket-replay-flush-blocks", boost::program_options::value<uint32_t>()->default_value(100),
+           "Number of blocks whose fills are aggregated before the buckets are written while replaying irreversible blocks (default: 100)")
          ;
    cfg.add(cli);
 }
@@ -265,8 +425,12 @@ void market_history_plugin::plugin_set_program_options(
 void market_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 { try {
    database().applied_block.connect( [this]( const signed_block& b){ my->update_market_histories(b); } );
+   database().replayed_irreversible_blocks.connect( [this](){ my->flush_buckets(); } );
+   database().saving_object_database.connect( [this](){ my->flush_buckets(); } );
    database().add_index< primary_index< bucket_index  > >();
    database().add_index< primary_index< history_index  > >();
+   database().add_index< primary_index< market_ticker_index > >();
+   database().add_index< primary_index< simple_index< market_ticker_meta_object > > >();
 
    if( options.count( "bucket-size" ) )
    {
@@ -276,12 +440,19 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
    }
    if( options.count( "history-per-size" ) )
       my->_maximum_history_per_bucket_size = options["history-per-size"].as<uint32_t>();
+   if( options.count( "bucket-replay-flush-blocks" ) )
+      my->_replay_flush_blocks = options["bucket-replay-flush-blocks"].as<uint32_t>();
 } FC_CAPTURE_AND_RETHROW() }
 
 void market_history_plugin::plugin_startup()
 {
 }
 
+void market_history_plugin::plugin_shutdown()
+{
+   my->flush_buckets();
+}
+
 const flat_set<uint32_t>& market_history_plugin::tracked_buckets() const
 {
    return my->_tracked_buckets;
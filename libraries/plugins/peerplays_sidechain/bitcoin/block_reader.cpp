@@ -0,0 +1,280 @@
+#include <graphene/peerplays_sidechain/bitcoin/block_reader.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <fc/exception/exception.hpp>
+
+namespace graphene { namespace peerplays_sidechain { namespace bitcoin {
+
+namespace {
+
+/// Pull reader over a JSON text, members and elements are visited in order and unwanted values skipped
+class json_reader {
+public:
+   json_reader(const char *begin, const char *end) :
+         pos(begin),
+         end(end) {
+   }
+
+   char peek() {
+      skip_whitespace();
+      FC_ASSERT(pos < end, "Unexpected end of JSON");
+      return *pos;
+   }
+
+   void expect(char c) {
+      FC_ASSERT(peek() == c, "Expected '${c}' in JSON", ("c", std::string(1, c)));
+      ++pos;
+   }
+
+   /// Reads the key of the next member of the current object, returns false at the end of the object
+   bool next_member(std::string &key) {
+      if (!next_item('}'))
+         return false;
+      key = read_string();
+      expect(':');
+      return true;
+   }
+
+   /// Returns false at the end of the current array
+   bool next_element() {
+      return next_item(']');
+   }
+
+   std::string read_string() {
+      expect('"');
+      std::string result;
+      while (true) {
+         const char *stop = pos;
+         while (stop < end && *stop != '"' && *stop != '\\')
+            ++stop;
+         FC_ASSERT(stop < end, "Unterminated JSON string");
+         result.append(pos, stop);
+         pos = stop + 1;
+         if (*stop == '"')
+            return result;
+         read_escape(result);
+      }
+   }
+
+   /// Returns the text of a number or literal as it appears in the JSON
+   std::string read_scalar() {
+      peek();
+      const char *start = pos;
+      while (pos < end && !is_delimiter(*pos))
+         ++pos;
+      return std::string(start, pos);
+   }
+
+   void skip_value() {
+      const char c = peek();
+      if (c == '"') {
+         skip_string();
+      } else if (c == '{' || c == '[') {
+         size_t depth = 0;
+         do {
+            const char *stop = pos;
+            while (stop < end && *stop != '"' && *stop != '{' && *stop != '[' && *stop != '}' && *stop != ']')
+               ++stop;
+            FC_ASSERT(stop < end, "Unexpected end of JSON");
+            pos = stop;
+            if (*pos == '"') {
+               skip_string();
+               continue;
+            }
+            if (*pos == '{' || *pos == '[')
+               ++depth;
+            else
+               --depth;
+            ++pos;
+         } while (depth > 0);
+      } else {
+         while (pos < end && !is_delimiter(*pos))
+            ++pos;
+      }
+   }
+
+private:
+   static bool is_delimiter(char c) {
+      return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\n' || c == '\r';
+   }
+
+   void skip_whitespace() {
+      while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r'))
+         ++pos;
+   }
+
+   bool next_item(char closing) {
+      const char c = peek();
+      if (c == closing) {
+         ++pos;
+         return false;
+      }
+      if (c == ',')
+         ++pos;
+      return true;
+   }
+
+   void skip_string() {
+      ++pos;
+      while (true) {
+         const char *stop = static_cast<const char *>(memchr(pos, '"', end - pos));
+         FC_ASSERT(stop != nullptr, "Unterminated JSON string");
+         // the quote is escaped if it follows an odd number of backslashes
+         const char *backslash = stop;
+         while (backslash > pos && *(backslash - 1) == '\\')
+            --backslash;
+         pos = stop + 1;
+         if ((stop - backslash) % 2 == 0)
+            return;
+      }
+   }
+
+   void read_escape(std::string &result) {
+      FC_ASSERT(pos < end, "Unterminated JSON string");
+      const char c = *pos++;
+      switch (c) {
+      case 'b':
+         result += '\b';
+         break;
+      case 'f':
+         result += '\f';
+         break;
+      case 'n':
+         result += '\n';
+         break;
+      case 'r':
+         result += '\r';
+         break;
+      case 't':
+         result += '\t';
+         break;
+      case 'u': {
+         FC_ASSERT(end - pos >= 4, "Unterminated JSON string");
+         const uint32_t code = std::stoul(std::string(pos, pos + 4), nullptr, 16);
+         pos += 4;
+         if (code < 0x80) {
+            result += char(code);
+         } else if (code < 0x800) {
+            result += char(0xC0 | (code >> 6));
+            result += char(0x80 | (code & 0x3F));
+         } else {
+            result += char(0xE0 | (code >> 12));
+            result += char(0x80 | ((code >> 6) & 0x3F));
+            result += char(0x80 | (code & 0x3F));
+         }
+         break;
+      }
+      default:
+         result += c;
+      }
+   }
+
+   const char *pos;
+   const char *end;
+};
+
+/// Amounts are printed by bitcoind with all 8 decimals, so dropping the point gives satoshis
+uint64_t to_satoshis(std::string amount) {
+   amount.erase(std::remove(amount.begin(), amount.end(), '.'), amount.end());
+   return std::stoll(amount);
+}
+
+void read_output(json_reader &reader, const std::unordered_set<std::string> *watched_addresses, std::vector<info_for_vin> &outputs) {
+   std::string value;
+   std::string n;
+   std::vector<std::string> address_list;
+   bool has_address = false;
+
+   reader.expect('{');
+   std::string key;
+   while (reader.next_member(key)) {
+      if (key == "value") {
+         value = reader.read_scalar();
+      } else if (key == "n") {
+         n = reader.read_scalar();
+      } else if (key == "scriptPubKey") {
+         reader.expect('{');
+         std::string script_key;
+         while (reader.next_member(script_key)) {
+            if (script_key == "address") {
+               // a single address takes precedence over the address list of older versions
+               address_list.assign(1, reader.read_string());
+               has_address = true;
+            } else if (script_key == "addresses" && !has_address) {
+               reader.expect('[');
+               while (reader.next_element())
+                  address_list.emplace_back(reader.read_string());
+            } else {
+               reader.skip_value();
+            }
+         }
+      } else {
+         reader.skip_value();
+      }
+   }
+
+   for (auto &address : address_list) {
+      if (watched_addresses && !watched_addresses->count(address))
+         continue;
+      info_for_vin vin;
+      vin.out.amount = to_satoshis(value);
+      vin.out.n_vout = std::stoul(n);
+      vin.address = std::move(address);
+      outputs.push_back(std::move(vin));
+   }
+}
+
+void read_transaction(json_reader &reader, const std::unordered_set<std::string> *watched_addresses, std::vector<info_for_vin> &result) {
+   const size_t first_output = result.size();
+   std::string txid;
+
+   reader.expect('{');
+   std::string key;
+   while (reader.next_member(key)) {
+      if (key == "txid") {
+         txid = reader.read_string();
+      } else if (key == "vout") {
+         reader.expect('[');
+         while (reader.next_element())
+            read_output(reader, watched_addresses, result);
+      } else {
+         reader.skip_value();
+      }
+   }
+
+   for (size_t i = first_output; i < result.size(); i++)
+      result[i].out.hash_tx = txid;
+}
+
+} // namespace
+
+std::vector<info_for_vin> read_block_outputs(const std::string &reply, const std::unordered_set<std::string> *watched_addresses) {
+   std::vector<info_for_vin> result;
+   json_reader reader(reply.data(), reply.data() + reply.size());
+
+   reader.expect('{');
+   std::string key;
+   while (reader.next_member(key)) {
+      if (key != "result" || reader.peek() != '{') {
+         reader.skip_value();
+         continue;
+      }
+      reader.expect('{');
+      std::string block_key;
+      while (reader.next_member(block_key)) {
+         if (block_key != "tx") {
+            reader.skip_value();
+            continue;
+         }
+         reader.expect('[');
+         while (reader.next_element())
+            read_transaction(reader, watched_addresses, result);
+      }
+   }
+
+   return result;
+}
+
+}}} // namespace graphene::peerplays_sidechain::bitcoin
@@ -0,0 +1,126 @@
+#include <graphene/peerplays_sidechain/common/block_listener.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <future>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+namespace graphene { namespace peerplays_sidechain {
+
+block_listener::block_listener(const std::string &_name, const fc::path &_state_file, fetch_block_type _fetch_block, handle_block_type _handle_block,
+                               size_t _max_concurrent_fetches, uint64_t _max_blocks_per_catch_up) :
+      name(_name),
+      state_file(_state_file),
+      fetch_block(_fetch_block),
+      handle_block(_handle_block),
+      max_concurrent_fetches(std::max<size_t>(_max_concurrent_fetches, 1)),
+      max_blocks_per_catch_up(std::max<uint64_t>(_max_blocks_per_catch_up, 1)),
+      pool(max_concurrent_fetches),
+      last_handled_block(0) {
+   load_state();
+}
+
+void block_listener::start_after(uint64_t block_num) {
+   if (last_handled_block == 0)
+      last_handled_block = block_num;
+}
+
+uint64_t block_listener::get_last_handled_block() const {
+   return last_handled_block;
+}
+
+uint64_t block_listener::catch_up(uint64_t head_block_num) {
+   const uint64_t first = last_handled_block ? last_handled_block + 1 : head_block_num;
+   if (head_block_num < first)
+      return 0;
+   const uint64_t last = std::min(head_block_num, first + max_blocks_per_catch_up - 1);
+   if (last < head_block_num)
+      ilog("${name} listener is ${n} blocks behind, catching up", ("name", name)("n", head_block_num - first + 1));
+
+   std::deque<std::pair<uint64_t, std::future<std::string>>> fetches;
+   uint64_t next_fetch = first;
+   const auto fetch_more = [&]() {
+      while (fetches.size() < max_concurrent_fetches && next_fetch <= last) {
+         const uint64_t block_num = next_fetch++;
+         fetches.emplace_back(block_num, pool.post([this, block_num]() {
+                                 return fetch_block(block_num);
+                              }));
+      }
+   };
+
+   uint64_t handled = 0;
+   fetch_more();
+   while (!fetches.empty()) {
+      const uint64_t block_num = fetches.front().first;
+      std::future<std::string> fetch = std::move(fetches.front().second);
+      fetches.pop_front();
+      fetch_more();
+
+      std::string block;
+      try {
+         block = fetch.get();
+      } catch (const fc::exception &e) {
+         wlog("${name} listener failed to fetch block ${block_num}: ${e}", ("name", name)("block_num", block_num)("e", e.to_detail_string()));
+      } catch (const std::exception &e) {
+         wlog("${name} listener failed to fetch block ${block_num}: ${e}", ("name", name)("block_num", block_num)("e", e.what()));
+      }
+
+      if (block.empty()) {
+         // the following blocks must not be handled before this one, they are fetched again on the next catch up
+         for (auto &f : fetches)
+            f.second.wait();
+         break;
+      }
+
+      // a block that cannot be handled is skipped, retrying it would stop the listener for good
+      try {
+         handle_block(block_num, block);
+      } catch (const fc::exception &e) {
+         elog("${name} listener failed to handle block ${block_num}: ${e}", ("name", name)("block_num", block_num)("e", e.to_detail_string()));
+      } catch (const std::exception &e) {
+         elog("${name} listener failed to handle block ${block_num}: ${e}", ("name", name)("block_num", block_num)("e", e.what()));
+      }
+
+      last_handled_block = block_num;
+      save_state();
+      handled++;
+   }
+
+   return handled;
+}
+
+void block_listener::load_state() {
+   if (!fc::exists(state_file))
+      return;
+
+   std::ifstream in(state_file.generic_string());
+   uint64_t block_num = 0;
+   if (in >> block_num) {
+      last_handled_block = block_num;
+      ilog("${name} listener resumes after block ${block_num}", ("name", name)("block_num", block_num));
+   } else {
+      wlog("${name} listener ignores the unreadable state file ${file}", ("name", name)("file", state_file));
+   }
+}
+
+void block_listener::save_state() {
+   try {
+      if (!fc::exists(state_file.parent_path()))
+         fc::create_directories(state_file.parent_path());
+
+      // replace the file in one step, so that a crash never leaves a partly written block number
+      const fc::path tmp_file = state_file.generic_string() + ".tmp";
+      {
+         std::ofstream out(tmp_file.generic_string(), std::ios::trunc);
+         out << last_handled_block.load() << std::endl;
+      }
+      fc::rename(tmp_file, state_file);
+   } catch (const fc::exception &e) {
+      wlog("${name} listener failed to save its state: ${e}", ("name", name)("e", e.to_detail_string()));
+   }
+}
+
+}} // namespace graphene::peerplays_sidechain
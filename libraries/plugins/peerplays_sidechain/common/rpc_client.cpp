@@ -1,9 +1,11 @@
 #include <graphene/peerplays_sidechain/common/rpc_client.hpp>
 
+#include <atomic>
+#include <memory>
 #include <regex>
 #include <sstream>
+#include <stdexcept>
 
-#include <boost/asio/buffers_iterator.hpp>
 #include <boost/asio/connect.hpp>
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
@@ -23,13 +25,31 @@ struct rpc_reply {
    std::string body;
 };
 
+/// A connection to the endpoint, kept open between requests while the server allows it
+struct rpc_session {
+   rpc_session(boost::beast::net::io_context &ioc, boost::asio::ssl::context &ctx) :
+         ssl_tcp_stream(ioc, ctx) {
+   }
+
+   boost::beast::tcp_stream &tcp_stream() {
+      return boost::beast::get_lowest_layer(ssl_tcp_stream);
+   }
+
+   boost::beast::net::ssl::stream<boost::beast::tcp_stream> ssl_tcp_stream;
+   boost::beast::flat_buffer buffer;
+   bool connected = false;
+};
+
 class rpc_connection {
 public:
    rpc_connection(const rpc_credentials &_credentials, bool _debug_rpc_calls);
 
    std::string send_post_request(std::string method, std::string params, bool show_log);
+   std::vector<std::string> send_batch_request(const std::vector<rpc_request> &requests, bool show_log);
    std::string get_url() const;
 
+   rpc_connection_metrics get_metrics() const;
+
 protected:
    rpc_credentials credentials;
    bool debug_rpc_calls;
@@ -40,20 +60,37 @@ protected:
    std::string target;
    std::string authorization;
 
-   uint32_t request_id;
+   std::atomic<uint32_t> request_id;
 
 private:
+   static const size_t max_idle_sessions = 4;
+   static const uint64_t failed_request_latency = 5 * 1000 * 1000;
+
    rpc_reply send_post_request(std::string body, bool show_log);
 
+   std::unique_ptr<rpc_session> acquire_session();
+   void release_session(std::unique_ptr<rpc_session> session);
+   void connect(rpc_session &session);
+   rpc_reply exchange(rpc_session &session, const std::string &body, bool &keep_alive, bool &response_started);
+   void record_request(uint64_t latency, bool failed);
+
    boost::beast::net::io_context ioc;
+   boost::asio::ssl::context ctx;
    boost::beast::net::ip::tcp::resolver resolver;
    boost::asio::ip::basic_resolver_results<boost::asio::ip::tcp> results;
+
+   std::mutex sessions_mutex;
+   std::vector<std::unique_ptr<rpc_session>> idle_sessions;
+
+   mutable std::mutex metrics_mutex;
+   rpc_connection_metrics metrics;
 };
 
 rpc_connection::rpc_connection(const rpc_credentials &_credentials, bool _debug_rpc_calls) :
       credentials(_credentials),
       debug_rpc_calls(_debug_rpc_calls),
       request_id(0),
+      ctx(boost::asio::ssl::context::tlsv12_client),
       resolver(ioc) {
 
    std::string reg_expr = "^((?P<Protocol>https|http):\\/\\/)?(?P<Host>[a-zA-Z0-9\\-\\.]+)(:(?P<Port>\\d{1,5}))?(?P<Target>\\/.+)?";
@@ -86,6 +123,11 @@ rpc_connection::rpc_connection(const rpc_credentials &_credentials, bool _debug_
 
       results = resolver.resolve(host, port);
 
+      if (protocol == "https") {
+         ctx.set_default_verify_paths();
+         ctx.set_verify_mode(boost::asio::ssl::verify_peer);
+      }
+
    } else {
       elog("Invalid URL: ${url}", ("url", credentials.url));
    }
@@ -95,6 +137,27 @@ std::string rpc_connection::get_url() const {
    return credentials.url;
 }
 
+rpc_connection_metrics rpc_connection::get_metrics() const {
+   const std::lock_guard<std::mutex> lock(metrics_mutex);
+   rpc_connection_metrics result = metrics;
+   result.url = credentials.url;
+   return result;
+}
+
+void rpc_connection::record_request(uint64_t latency, bool failed) {
+   const std::lock_guard<std::mutex> lock(metrics_mutex);
+   if (failed) {
+      metrics.failures++;
+      latency = failed_request_latency;
+   }
+   if (metrics.requests == 0)
+      metrics.recent_latency = latency;
+   else
+      metrics.recent_latency = (metrics.recent_latency * 7 + latency) / 8;
+   metrics.requests++;
+   metrics.total_latency += latency;
+}
+
 std::string rpc_client::retrieve_array_value_from_reply(std::string reply_str, std::string array_path, uint32_t idx) {
    if (reply_str.empty()) {
       wlog("RPC call ${function}, empty reply string", ("function", __FUNCTION__));
@@ -162,9 +225,7 @@ std::string rpc_client::retrieve_value_from_reply(std::string reply_str, std::st
 std::string rpc_connection::send_post_request(std::string method, std::string params, bool show_log) {
    std::stringstream body;
 
-   request_id = request_id + 1;
-
-   body << "{ \"jsonrpc\": \"2.0\", \"id\": " << request_id << ", \"method\": \"" << method << "\"";
+   body << "{ \"jsonrpc\": \"2.0\", \"id\": " << ++request_id << ", \"method\": \"" << method << "\"";
 
    if (!params.empty()) {
       body << ", \"params\": " << params;
@@ -198,33 +259,140 @@ std::string rpc_connection::send_post_request(std::string method, std::string pa
    return "";
 }
 
-rpc_reply rpc_connection::send_post_request(std::string body, bool show_log) {
+/// Splits a JSON array into the raw text of its elements, so that the elements keep their types and formatting
+static std::vector<std::string> split_json_array(const std::string &json) {
+   std::vector<std::string> elements;
+   size_t pos = json.find_first_not_of(" \t\r\n");
+   if (pos == std::string::npos || json[pos] != '[')
+      throw std::invalid_argument("reply is not a JSON array");
+
+   int depth = 0;
+   bool in_string = false;
+   size_t element_start = std::string::npos;
+   for (++pos; pos < json.size(); ++pos) {
+      const char c = json[pos];
+      if (in_string) {
+         if (c == '\\')
+            ++pos;
+         else if (c == '"')
+            in_string = false;
+         continue;
+      }
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+         continue;
+      if (depth == 0 && (c == ',' || c == ']')) {
+         if (element_start != std::string::npos) {
+            size_t element_end = json.find_last_not_of(" \t\r\n", pos - 1);
+            elements.push_back(json.substr(element_start, element_end + 1 - element_start));
+            element_start = std::string::npos;
+         }
+         if (c == ']')
+            return elements;
+         continue;
+      }
+      if (element_start == std::string::npos)
+         element_start = pos;
+      if (c == '"')
+         in_string = true;
+      else if (c == '{' || c == '[')
+         ++depth;
+      else if (c == '}' || c == ']')
+         --depth;
+   }
+   throw std::invalid_argument("unterminated JSON array in reply");
+}
 
-   // These object is used as a context for ssl connection
-   boost::asio::ssl::context ctx(boost::asio::ssl::context::tlsv12_client);
+std::vector<std::string> rpc_connection::send_batch_request(const std::vector<rpc_request> &requests, bool show_log) {
+   std::vector<std::string> result(requests.size());
+   if (requests.empty())
+      return result;
 
-   boost::beast::net::ssl::stream<boost::beast::tcp_stream> ssl_tcp_stream(ioc, ctx);
-   boost::beast::tcp_stream tcp_stream(ioc);
+   const uint32_t first_id = request_id.fetch_add(requests.size()) + 1;
 
-   // Set SNI Hostname (many hosts need this to handshake successfully)
-   if (protocol == "https") {
-      if (!SSL_set_tlsext_host_name(ssl_tcp_stream.native_handle(), host.c_str())) {
-         boost::beast::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
-         throw boost::beast::system_error{ec};
+   std::stringstream body;
+   body << "[";
+   for (size_t i = 0; i < requests.size(); i++) {
+      body << (i ? ", " : " ") << "{ \"jsonrpc\": \"2.0\", \"id\": " << first_id + i << ", \"method\": \"" << requests[i].method << "\"";
+      if (!requests[i].params.empty()) {
+         body << ", \"params\": " << requests[i].params;
       }
-      ctx.set_default_verify_paths();
-      ctx.set_verify_mode(boost::asio::ssl::verify_peer);
+      body << " }";
    }
+   body << " ]";
+
+   try {
+      const auto reply = send_post_request(body.str(), show_log);
 
+      if (reply.body.empty() || reply.status != 200) {
+         wlog("RPC call ${function} failed", ("function", __FUNCTION__));
+         return result;
+      }
+
+      // replies may come in any order, they are matched to the calls by id and returned as sent by the server
+      for (std::string &element : split_json_array(reply.body)) {
+         std::stringstream ss(element);
+         boost::property_tree::ptree item;
+         boost::property_tree::read_json(ss, item);
+         const auto id = item.get_optional<uint32_t>("id");
+         if (!id || *id < first_id || *id - first_id >= requests.size()) {
+            wlog("RPC call ${function} with body ${body} failed with reply '${msg}'", ("function", __FUNCTION__)("body", body.str())("msg", reply.body));
+            continue;
+         }
+         if (item.count("error") && !item.get_child("error").empty()) {
+            wlog("RPC call ${function} ${method} failed with reply '${msg}'", ("function", __FUNCTION__)("method", requests[*id - first_id].method)("msg", element));
+         }
+         result[*id - first_id] = std::move(element);
+      }
+   } catch (const boost::system::system_error &e) {
+      elog("RPC call ${function} failed: ${e}", ("function", __FUNCTION__)("e", e.what()));
+   } catch (const boost::property_tree::ptree_error &e) {
+      elog("RPC call ${function} failed: ${e}", ("function", __FUNCTION__)("e", e.what()));
+   } catch (const std::invalid_argument &e) {
+      elog("RPC call ${function} failed: ${e}", ("function", __FUNCTION__)("e", e.what()));
+   }
+
+   return result;
+}
+
+std::unique_ptr<rpc_session> rpc_connection::acquire_session() {
+   {
+      const std::lock_guard<std::mutex> lock(sessions_mutex);
+      if (!idle_sessions.empty()) {
+         std::unique_ptr<rpc_session> session = std::move(idle_sessions.back());
+         idle_sessions.pop_back();
+         return session;
+      }
+   }
+   return std::unique_ptr<rpc_session>(new rpc_session(ioc, ctx));
+}
+
+void rpc_connection::release_session(std::unique_ptr<rpc_session> session) {
+   const std::lock_guard<std::mutex> lock(sessions_mutex);
+   if (idle_sessions.size() < max_idle_sessions)
+      idle_sessions.push_back(std::move(session));
+}
+
+void rpc_connection::connect(rpc_session &session) {
    // Make the connection on the IP address we get from a lookup
    if (protocol == "https") {
-      boost::beast::get_lowest_layer(ssl_tcp_stream).connect(results);
-      ssl_tcp_stream.handshake(boost::beast::net::ssl::stream_base::client);
+      // Set SNI Hostname (many hosts need this to handshake successfully)
+      if (!SSL_set_tlsext_host_name(session.ssl_tcp_stream.native_handle(), host.c_str())) {
+         boost::beast::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
+         throw boost::beast::system_error{ec};
+      }
+      session.tcp_stream().connect(results);
+      session.ssl_tcp_stream.handshake(boost::beast::net::ssl::stream_base::client);
    } else {
-      tcp_stream.connect(results);
+      session.tcp_stream().connect(results);
    }
+   session.connected = true;
+
+   const std::lock_guard<std::mutex> lock(metrics_mutex);
+   metrics.connects++;
+}
 
-   // Set up an HTTP GET request message
+rpc_reply rpc_connection::exchange(rpc_session &session, const std::string &body, bool &keep_alive, bool &response_started) {
+   // Set up an HTTP POST request message
    boost::beast::http::request<boost::beast::http::string_body> req{boost::beast::http::verb::post, target, 11};
    req.set(boost::beast::http::field::host, host + ":" + port);
    req.set(boost::beast::http::field::accept, "application/json");
@@ -232,50 +400,88 @@ rpc_reply rpc_connection::send_post_request(std::string body, bool show_log) {
    req.set(boost::beast::http::field::content_type, "application/json");
    req.set(boost::beast::http::field::content_encoding, "utf-8");
    req.set(boost::beast::http::field::content_length, body.length());
+   req.keep_alive(true);
    req.body() = body;
 
-   // Send the HTTP request to the remote host
-   if (protocol == "https")
-      boost::beast::http::write(ssl_tcp_stream, req);
-   else
-      boost::beast::http::write(tcp_stream, req);
+   // Declare a parser to hold the response, it tells whether any of the response was received
+   boost::beast::http::response_parser<boost::beast::http::string_body> parser;
 
-   // This buffer is used for reading and must be persisted
-   boost::beast::flat_buffer buffer;
+   // Send the HTTP request to the remote host and receive the response
+   try {
+      if (protocol == "https") {
+         boost::beast::http::write(session.ssl_tcp_stream, req);
+         boost::beast::http::read(session.ssl_tcp_stream, session.buffer, parser);
+      } else {
+         boost::beast::http::write(session.tcp_stream(), req);
+         boost::beast::http::read(session.tcp_stream(), session.buffer, parser);
+      }
+   } catch (const boost::system::system_error &) {
+      response_started = parser.got_some();
+      throw;
+   }
 
-   // Declare a container to hold the response
-   boost::beast::http::response<boost::beast::http::dynamic_body> res;
+   boost::beast::http::response<boost::beast::http::string_body> res = parser.release();
+   keep_alive = res.keep_alive();
 
-   // Receive the HTTP response
-   if (protocol == "https")
-      boost::beast::http::read(ssl_tcp_stream, buffer, res);
-   else
-      boost::beast::http::read(tcp_stream, buffer, res);
+   rpc_reply reply;
+   reply.status = 200;
+   reply.body = std::move(res.body());
+   return reply;
+}
 
-   // Gracefully close the socket
-   boost::beast::error_code ec;
-   if (protocol == "https") {
-      boost::beast::get_lowest_layer(ssl_tcp_stream).close();
-   } else {
-      tcp_stream.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
-   }
+/// Whether @ref ec is how a read or write fails on a connection the server has closed
+static bool is_closed_connection(const boost::system::error_code &ec) {
+   return ec == boost::beast::http::error::end_of_stream ||
+          ec == boost::asio::error::eof ||
+          ec == boost::asio::error::connection_reset ||
+          ec == boost::asio::error::connection_aborted ||
+          ec == boost::asio::error::broken_pipe ||
+          ec == boost::asio::ssl::error::stream_truncated;
+}
 
-   // not_connected happens sometimes. Also on ssl level some servers are managing
-   // connecntion close, so closing here will sometimes end up with error stream truncated
-   // so don't bother reporting it.
-   if (ec && ec != boost::beast::errc::not_connected && ec != boost::asio::ssl::error::stream_truncated)
-      throw boost::beast::system_error{ec};
+rpc_reply rpc_connection::send_post_request(std::string body, bool show_log) {
+   const fc::time_point t_sent = fc::time_point::now();
 
-   std::string rbody{boost::asio::buffers_begin(res.body().data()),
-                     boost::asio::buffers_end(res.body().data())};
+   std::unique_ptr<rpc_session> session = acquire_session();
+   bool keep_alive = false;
    rpc_reply reply;
-   reply.status = 200;
-   reply.body = rbody;
+   try {
+      const bool reused = session->connected;
+      bool response_started = false;
+      try {
+         if (!session->connected)
+            connect(*session);
+         reply = exchange(*session, body, keep_alive, response_started);
+      } catch (const boost::system::system_error &e) {
+         // The server may have closed the idle connection in the meantime. Writing to it then usually
+         // succeeds and the read fails, without a byte of the response. The request was not handled,
+         // so it is sent once more on a new connection. Other failures may follow a handled request.
+         if (!reused || response_started || !is_closed_connection(e.code()))
+            throw;
+         session.reset(new rpc_session(ioc, ctx));
+         connect(*session);
+         reply = exchange(*session, body, keep_alive, response_started);
+      }
+   } catch (const boost::system::system_error &) {
+      record_request(0, true);
+      throw;
+   }
+
+   record_request((fc::time_point::now() - t_sent).count(), false);
+
+   if (keep_alive) {
+      release_session(std::move(session));
+   } else {
+      // Gracefully close the socket. not_connected happens sometimes, and some servers close the
+      // ssl connection themselves, so errors are not reported.
+      boost::beast::error_code ec;
+      session->tcp_stream().socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+   }
 
    if (show_log) {
       ilog("### Request URL:    ${url}", ("url", credentials.url));
       ilog("### Request:        ${body}", ("body", body));
-      ilog("### Response:       ${rbody}", ("rbody", rbody));
+      ilog("### Response:       ${rbody}", ("rbody", reply.body));
    }
 
    return reply;
@@ -306,8 +512,6 @@ void rpc_client::schedule_connection_selection() {
 void rpc_client::select_connection() {
    FC_ASSERT(connections.size() > 1);
 
-   const std::lock_guard<std::mutex> lock(conn_mutex);
-
    static const int t_limit = 5 * 1000 * 1000, // 5 sec
          quality_diff_threshold = 10 * 1000;   // 10 ms
 
@@ -333,6 +537,12 @@ void rpc_client::select_connection() {
       fc::time_point t_received = fc::time_point::now();
       int t = (t_received - t_sent).count();
 
+      // weigh in the latency of the recent requests, so that a node answering pings but slow or failing
+      // on real calls is not preferred
+      const rpc_connection_metrics metrics = conn.get_metrics();
+      if (metrics.requests > 1)
+         t = (t + int(std::min<uint64_t>(metrics.recent_latency, t_limit))) / 2;
+
       // evaluate n'th node reply quality and switch to it if it's better
       if (head_block_number != std::numeric_limits<uint64_t>::max()) {
          if (simulate_connection_reselection)
@@ -352,6 +562,9 @@ void rpc_client::select_connection() {
    }
 
    FC_ASSERT(best_n != -1 && best_quality != -1);
+
+   // pings are done without the lock, so that requests are not held up by slow nodes
+   const std::lock_guard<std::mutex> lock(conn_mutex);
    if (best_n != n_active_conn) { // if the best client is not the current one, ...
       uint64_t active_head_block_number = head_block_numbers[n_active_conn];
       if ((active_head_block_number == std::numeric_limits<uint64_t>::max()      // ...and the current one has no known head block...
@@ -367,14 +580,26 @@ void rpc_client::select_connection() {
 }
 
 rpc_connection &rpc_client::get_active_connection() const {
+   // connections have their own sessions, the lock only guards the selection
+   const std::lock_guard<std::mutex> lock(conn_mutex);
    return *connections[n_active_conn];
 }
 
 std::string rpc_client::send_post_request(std::string method, std::string params, bool show_log) {
-   const std::lock_guard<std::mutex> lock(conn_mutex);
    return send_post_request(get_active_connection(), method, params, show_log);
 }
 
+std::vector<std::string> rpc_client::send_batch_request(const std::vector<rpc_request> &requests, bool show_log) {
+   return get_active_connection().send_batch_request(requests, show_log);
+}
+
+std::vector<rpc_connection_metrics> rpc_client::get_connection_metrics() const {
+   std::vector<rpc_connection_metrics> result;
+   for (const auto conn : connections)
+      result.push_back(conn->get_metrics());
+   return result;
+}
+
 std::string rpc_client::send_post_request(rpc_connection &conn, std::string method, std::string params, bool show_log) {
    return conn.send_post_request(method, params, show_log);
 }
@@ -388,6 +613,8 @@ rpc_client::~rpc_client() {
    } catch (fc::exception &e) {
       edump((e.to_detail_string()));
    }
+   for (auto conn : connections)
+      delete conn;
 }
 
 }} // namespace graphene::peerplays_sidechain
@@ -61,4 +61,22 @@ graphene::chain::object_id_type string_to_object_id(const std::string &id) {
    return graphene::chain::object_id_type{(uint8_t)s, (uint8_t)t, boost::lexical_cast<uint64_t>(strs.at(2))};
 }
 
+bool json_rpc_has_result(const std::string &reply) {
+   // looked up in the text, the reply can be a large block which is parsed later anyway
+   size_t pos = reply.find("\"result\"");
+   if (pos == std::string::npos)
+      return false;
+   pos = reply.find_first_not_of(" \t\r\n", pos + 8);
+   if (pos == std::string::npos || reply[pos] != ':')
+      return false;
+   pos = reply.find_first_not_of(" \t\r\n", pos + 1);
+   if (pos == std::string::npos || reply.compare(pos, 4, "null") == 0)
+      return false;
+   if (reply[pos] == '{') {
+      pos = reply.find_first_not_of(" \t\r\n", pos + 1);
+      return pos != std::string::npos && reply[pos] != '}';
+   }
+   return true;
+}
+
 }} // namespace graphene::peerplays_sidechain
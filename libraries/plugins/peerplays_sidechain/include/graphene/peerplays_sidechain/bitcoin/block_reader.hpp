@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <graphene/peerplays_sidechain/defs.hpp>
+
+namespace graphene { namespace peerplays_sidechain { namespace bitcoin {
+
+/**
+ * Extracts the transaction outputs paying to an address from the JSON-RPC reply of getblock with verbosity 2.
+ *
+ * The reply is scanned once without building a tree of it, values other than the txids, output numbers,
+ * amounts and addresses are skipped. When watched_addresses is given, only outputs paying to one of them
+ * are returned. Outputs are returned in block order, one entry per address of an output.
+ */
+std::vector<info_for_vin> read_block_outputs(const std::string &reply, const std::unordered_set<std::string> *watched_addresses = nullptr);
+
+}}} // namespace graphene::peerplays_sidechain::bitcoin
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include <fc/filesystem.hpp>
+
+#include <graphene/chain/worker_pool.hpp>
+
+namespace graphene { namespace peerplays_sidechain {
+
+/**
+ * Follows the blocks of a sidechain without gaps.
+ *
+ * Each call of catch_up fetches the blocks after the last handled one up to the reported head, several at a time
+ * on a fixed pool of threads, and hands them to the handler one by one in block order on the calling thread.
+ * The number of the last handled block is saved after each block, so that a restart resumes after it.
+ */
+class block_listener {
+public:
+   /// Returns the block, or an empty string if it is not available yet
+   typedef std::function<std::string(uint64_t)> fetch_block_type;
+   typedef std::function<void(uint64_t, const std::string &)> handle_block_type;
+
+   block_listener(const std::string &name, const fc::path &state_file, fetch_block_type fetch_block, handle_block_type handle_block,
+                  size_t max_concurrent_fetches = 4, uint64_t max_blocks_per_catch_up = 1000);
+
+   /// Starts after block_num when no block was handled yet, otherwise the first catch up starts at the head block
+   void start_after(uint64_t block_num);
+
+   /// Handles the blocks up to head_block_num that were not handled yet, returns how many were handled
+   uint64_t catch_up(uint64_t head_block_num);
+
+   /// Zero until the first block is handled
+   uint64_t get_last_handled_block() const;
+
+private:
+   void load_state();
+   void save_state();
+
+   const std::string name;
+   const fc::path state_file;
+   const fetch_block_type fetch_block;
+   const handle_block_type handle_block;
+   const size_t max_concurrent_fetches;
+   const uint64_t max_blocks_per_catch_up;
+
+   graphene::chain::worker_pool pool;
+   std::atomic<uint64_t> last_handled_block;
+};
+
+}} // namespace graphene::peerplays_sidechain
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <fc/thread/future.hpp>
 #include <fc/thread/thread.hpp>
@@ -21,6 +23,23 @@ struct rpc_credentials {
    std::string password;
 };
 
+/// One call of a JSON-RPC batch
+struct rpc_request {
+   std::string method;
+   std::string params;
+};
+
+/// Request statistics of one endpoint, latencies are in microseconds
+struct rpc_connection_metrics {
+   std::string url;
+   uint64_t requests = 0;
+   uint64_t failures = 0;
+   uint64_t connects = 0;
+   uint64_t total_latency = 0;
+   /// Exponentially weighted average of the recent request latencies, failed requests count as 5 seconds
+   uint64_t recent_latency = 0;
+};
+
 class rpc_client {
 public:
    const sidechain_type sidechain;
@@ -28,6 +47,8 @@ public:
    rpc_client(sidechain_type _sidechain, const std::vector<rpc_credentials> &_credentials, bool _debug_rpc_calls, bool _simulate_connection_reselection);
    ~rpc_client();
 
+   std::vector<rpc_connection_metrics> get_connection_metrics() const;
+
 protected:
    bool debug_rpc_calls;
    bool simulate_connection_reselection;
@@ -35,6 +56,9 @@ protected:
 
    static std::string send_post_request(rpc_connection &conn, std::string method, std::string params, bool show_log);
 
+   /// Sends all calls in one POST, returns the reply of each call in the same format as send_post_request
+   std::vector<std::string> send_batch_request(const std::vector<rpc_request> &requests, bool show_log);
+
    static std::string retrieve_array_value_from_reply(std::string reply_str, std::string array_path, uint32_t idx);
    static std::string retrieve_value_from_reply(std::string reply_str, std::string value_path);
 
@@ -42,7 +66,7 @@ private:
    std::vector<rpc_connection *> connections;
    int n_active_conn;
    fc::future<void> connection_selection_task;
-   std::mutex conn_mutex;
+   mutable std::mutex conn_mutex;
 
    rpc_connection &get_active_connection() const;
 
@@ -10,4 +10,7 @@ std::string base64_decode(const std::string &s);
 std::string object_id_to_string(graphene::chain::object_id_type id);
 graphene::chain::object_id_type string_to_object_id(const std::string &id);
 
+/// Returns false if the JSON-RPC reply is empty or its result is missing, null or an empty object
+bool json_rpc_has_result(const std::string &reply);
+
 }} // namespace graphene::peerplays_sidechain
@@ -5,6 +5,7 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_set>
 #include <zmq_addon.hpp>
 
 #include <boost/signals2.hpp>
@@ -64,7 +65,7 @@ public:
    };
 
    virtual uint64_t estimatesmartfee(uint16_t conf_target = 1) = 0;
-   virtual std::vector<info_for_vin> getblock(const block_data &block, int32_t verbosity = 2) = 0;
+   virtual std::vector<info_for_vin> getblock(const block_data &block, int32_t verbosity = 2, const std::unordered_set<std::string> *watched_addresses = nullptr) = 0;
    virtual btc_tx getrawtransaction(const std::string &txid, const bool verbose = false) = 0;
    virtual void getnetworkinfo() = 0;
    virtual std::string getblockchaininfo() = 0;
@@ -101,7 +102,7 @@ public:
    bitcoin_rpc_client(const std::vector<rpc_credentials> &_credentials, bool _debug_rpc_calls, bool _simulate_connection_reselection);
 
    uint64_t estimatesmartfee(uint16_t conf_target = 1);
-   std::vector<info_for_vin> getblock(const block_data &block, int32_t verbosity = 2);
+   std::vector<info_for_vin> getblock(const block_data &block, int32_t verbosity = 2, const std::unordered_set<std::string> *watched_addresses = nullptr);
    btc_tx getrawtransaction(const std::string &txid, const bool verbose = false);
    void getnetworkinfo();
    std::string getblockchaininfo();
@@ -128,7 +129,7 @@ class bitcoin_libbitcoin_client : public bitcoin_client_base, public libbitcoin_
 public:
    bitcoin_libbitcoin_client(std::string url);
    uint64_t estimatesmartfee(uint16_t conf_target = 1);
-   std::vector<info_for_vin> getblock(const block_data &block, int32_t verbosity = 2);
+   std::vector<info_for_vin> getblock(const block_data &block, int32_t verbosity = 2, const std::unordered_set<std::string> *watched_addresses = nullptr);
    btc_tx getrawtransaction(const std::string &txid, const bool verbose = false);
    void getnetworkinfo();
    std::string getblockchaininfo();
@@ -226,6 +227,7 @@ private:
    std::unique_ptr<bitcoin_client_base> bitcoin_client;
    std::unique_ptr<zmq_listener_base> listener;
 
+   uint64_t changed_objects_subscription = 0;
    fc::future<void> on_changed_objects_task;
 
    bitcoin::bitcoin_address::network network_type;
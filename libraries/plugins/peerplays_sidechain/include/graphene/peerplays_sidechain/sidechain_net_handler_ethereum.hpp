@@ -2,11 +2,13 @@
 
 #include <graphene/peerplays_sidechain/sidechain_net_handler.hpp>
 
+#include <memory>
 #include <string>
 
 #include <boost/bimap.hpp>
 #include <boost/signals2.hpp>
 
+#include <graphene/peerplays_sidechain/common/block_listener.hpp>
 #include <graphene/peerplays_sidechain/common/rpc_client.hpp>
 #include <graphene/peerplays_sidechain/ethereum/types.hpp>
 
@@ -35,6 +37,8 @@ public:
    std::string eth_send_transaction(const std::string &params);
    std::string eth_send_raw_transaction(const std::string &params);
    std::string eth_get_transaction_receipt(const std::string &params);
+   /// Gets the receipts of all transactions in one batch request, in the order of @ref transaction_hashes
+   std::vector<std::string> eth_get_transaction_receipts(const std::vector<std::string> &transaction_hashes);
    std::string eth_get_transaction_by_hash(const std::string &params);
 
    virtual uint64_t ping(rpc_connection &conn) const override;
@@ -72,12 +76,12 @@ private:
 
    std::string sign_transaction(const sidechain_transaction_object &sto);
 
-   uint64_t last_block_received;
+   std::unique_ptr<block_listener> listener;
    fc::future<void> _listener_task;
-   boost::signals2::signal<void(const std::string &)> event_received;
    void schedule_ethereum_listener();
    void ethereum_listener_loop();
-   void handle_event(const std::string &block_number);
+   std::string fetch_block(uint64_t block_num);
+   void handle_block(uint64_t block_num, const std::string &block);
 };
 
 }} // namespace graphene::peerplays_sidechain
@@ -2,10 +2,12 @@
 
 #include <graphene/peerplays_sidechain/sidechain_net_handler.hpp>
 
+#include <memory>
 #include <string>
 
 #include <boost/signals2.hpp>
 
+#include <graphene/peerplays_sidechain/common/block_listener.hpp>
 #include <graphene/peerplays_sidechain/common/rpc_client.hpp>
 #include <graphene/peerplays_sidechain/hive/types.hpp>
 
@@ -59,12 +61,12 @@ private:
    hive::chain_id_type chain_id;
    hive::network network_type;
 
-   uint64_t last_block_received;
+   std::unique_ptr<block_listener> listener;
    fc::future<void> _listener_task;
-   boost::signals2::signal<void(const std::string &)> event_received;
    void schedule_hive_listener();
    void hive_listener_loop();
-   void handle_event(const std::string &event_data);
+   std::string fetch_block(uint64_t block_num);
+   void handle_block(uint64_t block_num, const std::string &block);
 };
 
 }} // namespace graphene::peerplays_sidechain
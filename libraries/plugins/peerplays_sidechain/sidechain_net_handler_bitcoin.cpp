@@ -17,6 +17,7 @@
 #include <graphene/chain/son_wallet_object.hpp>
 #include <graphene/peerplays_sidechain/bitcoin/bitcoin_address.hpp>
 #include <graphene/peerplays_sidechain/bitcoin/bitcoin_transaction.hpp>
+#include <graphene/peerplays_sidechain/bitcoin/block_reader.hpp>
 #include <graphene/peerplays_sidechain/bitcoin/serialize.hpp>
 #include <graphene/peerplays_sidechain/bitcoin/sign_bitcoin_transaction.hpp>
 #include <graphene/utilities/key_conversion.hpp>
@@ -53,53 +54,23 @@ uint64_t bitcoin_rpc_client::estimatesmartfee(uint16_t conf_target) {
    return 20000;
 }
 
-std::vector<info_for_vin> bitcoin_rpc_client::getblock(const block_data &block, int32_t verbosity) {
+std::vector<info_for_vin> bitcoin_rpc_client::getblock(const block_data &block, int32_t verbosity, const std::unordered_set<std::string> *watched_addresses) {
    std::string params = std::string("[\"") + block.block_hash + std::string("\",") + std::to_string(verbosity) + std::string("]");
    std::string str = send_post_request("getblock", params, debug_rpc_calls);
-   std::vector<info_for_vin> result;
 
    if (str.empty()) {
-      return result;
+      return std::vector<info_for_vin>();
    }
 
-   std::stringstream ss(str);
-   boost::property_tree::ptree json;
-   boost::property_tree::read_json(ss, json);
-
-   auto json_result = json.get_child_optional("result");
-
-   for (const auto &tx_child : json_result.get().get_child("tx")) {
-      const auto &tx = tx_child.second;
-
-      for (const auto &o : tx.get_child("vout")) {
-         const auto script = o.second.get_child("scriptPubKey");
-         std::vector<std::string> address_list;
-
-         if (script.count("address")) {
-            address_list.emplace_back(script.get<std::string>("address"));
-         } else if (script.count("addresses")) {
-            for (const auto &addr : script.get_child("addresses")) {
-               address_list.emplace_back(addr.second.get_value<std::string>());
-            }
-         } else {
-            continue;
-         }
-
-         for (auto &address : address_list) {
-            const auto address_base58 = address;
-            info_for_vin vin;
-            vin.out.hash_tx = tx.get_child("txid").get_value<std::string>();
-            string amount = o.second.get_child("value").get_value<std::string>();
-            amount.erase(std::remove(amount.begin(), amount.end(), '.'), amount.end());
-            vin.out.amount = std::stoll(amount);
-            vin.out.n_vout = o.second.get_child("n").get_value<uint32_t>();
-            vin.address = address_base58;
-            result.push_back(vin);
-         }
-      }
+   try {
+      return bitcoin::read_block_outputs(str, watched_addresses);
+   } catch (const fc::exception &e) {
+      elog("Bitcoin RPC call ${function} returned an invalid block: ${e}", ("function", __FUNCTION__)("e", e.to_detail_string()));
+   } catch (const std::exception &e) {
+      elog("Bitcoin RPC call ${function} returned an invalid block: ${e}", ("function", __FUNCTION__)("e", e.what()));
    }
 
-   return result;
+   return std::vector<info_for_vin>();
 }
 
 void bitcoin_rpc_client::getnetworkinfo() {
@@ -355,7 +326,7 @@ uint64_t bitcoin_libbitcoin_client::estimatesmartfee(uint16_t conf_target) {
    return *std::min_element(accumulated_fees.begin(), accumulated_fees.end());
 }
 
-std::vector<info_for_vin> bitcoin_libbitcoin_client::getblock(const block_data &block, int32_t verbosity) {
+std::vector<info_for_vin> bitcoin_libbitcoin_client::getblock(const block_data &block, int32_t verbosity, const std::unordered_set<std::string> *watched_addresses) {
 
    std::unique_lock<std::mutex> lck(libbitcoin_event_mutex);
 
@@ -405,6 +376,8 @@ std::vector<info_for_vin> bitcoin_libbitcoin_client::getblock(const block_data &
 
          // addres list consists usual of one element
          for (auto &address : address_list) {
+            if (watched_addresses && !watched_addresses->count(address))
+               continue;
             const auto address_base58 = address;
             info_for_vin vin;
             vin.out.hash_tx = libbitcoin::config::hash256(tx.hash()).to_string();
@@ -755,12 +728,19 @@ sidechain_net_handler_bitcoin::sidechain_net_handler_bitcoin(peerplays_sidechain
 
    listener->start();
 
-   database.changed_objects.connect([this](const vector<object_id_type> &ids, const flat_set<account_id_type> &accounts) {
-      on_changed_objects(ids, accounts);
-   });
+   // only the wallet addresses are read, the impacted accounts are not needed
+   chain::object_change_filter son_wallets;
+   son_wallets.add_type<son_wallet_object>();
+   son_wallets.impacted_accounts = false;
+   changed_objects_subscription = database.subscribe_object_changes(
+         son_wallets, [this](const chain::object_changes &changes) {
+            if (!changes.changed_ids.empty())
+               on_changed_objects(changes.changed_ids, changes.changed_accounts_impacted);
+         });
 }
 
 sidechain_net_handler_bitcoin::~sidechain_net_handler_bitcoin() {
+   database.unsubscribe_object_changes(changed_objects_subscription);
    try {
       if (on_changed_objects_task.valid()) {
          on_changed_objects_task.cancel_and_wait(__FUNCTION__);
@@ -1657,12 +1637,23 @@ std::string sidechain_net_handler_bitcoin::send_transaction(const sidechain_tran
 
 void sidechain_net_handler_bitcoin::block_handle_event(const block_data &event_data) {
 
-   auto vins = bitcoin_client->getblock(event_data);
+   const auto &sidechain_addresses_idx = database.get_index_type<sidechain_address_index>().indices().get<by_sidechain_and_deposit_address_and_expires>();
+
+   // only the outputs paying to a deposit address are extracted from the block
+   std::unordered_set<std::string> deposit_addresses;
+   {
+      scoped_lock interlock(event_handler_mutex);
+      for (auto itr = sidechain_addresses_idx.lower_bound(std::make_tuple(sidechain)); itr != sidechain_addresses_idx.end() && itr->sidechain == sidechain; ++itr) {
+         if (itr->expires == time_point_sec::maximum())
+            deposit_addresses.insert(itr->get_deposit_address());
+      }
+   }
+
+   auto vins = bitcoin_client->getblock(event_data, 2, &deposit_addresses);
 
    add_to_son_listener_log("BLOCK   : " + event_data.block_hash);
 
    scoped_lock interlock(event_handler_mutex);
-   const auto &sidechain_addresses_idx = database.get_index_type<sidechain_address_index>().indices().get<by_sidechain_and_deposit_address_and_expires>();
 
    for (const auto &v : vins) {
       // !!! EXTRACT DEPOSIT ADDRESS FROM SIDECHAIN ADDRESS OBJECT
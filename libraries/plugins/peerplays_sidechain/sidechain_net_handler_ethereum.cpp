@@ -16,6 +16,7 @@
 #include <graphene/chain/sidechain_transaction_object.hpp>
 #include <graphene/chain/son_sidechain_info.hpp>
 #include <graphene/chain/son_wallet_object.hpp>
+#include <graphene/peerplays_sidechain/common/utils.hpp>
 #include <graphene/peerplays_sidechain/ethereum/decoders.hpp>
 #include <graphene/peerplays_sidechain/ethereum/encoders.hpp>
 #include <graphene/peerplays_sidechain/ethereum/transaction.hpp>
@@ -122,6 +123,14 @@ std::string ethereum_rpc_client::eth_get_transaction_receipt(const std::string &
    return send_post_request("eth_getTransactionReceipt", "[\"" + params + "\"]", debug_rpc_calls);
 }
 
+std::vector<std::string> ethereum_rpc_client::eth_get_transaction_receipts(const std::vector<std::string> &transaction_hashes) {
+   std::vector<rpc_request> requests;
+   requests.reserve(transaction_hashes.size());
+   for (const auto &hash : transaction_hashes)
+      requests.push_back(rpc_request{"eth_getTransactionReceipt", "[\"" + hash + "\"]"});
+   return send_batch_request(requests, debug_rpc_calls);
+}
+
 std::string ethereum_rpc_client::eth_get_transaction_by_hash(const std::string &params) {
    return send_post_request("eth_getTransactionByHash", "[\"" + params + "\"]", debug_rpc_calls);
 }
@@ -211,12 +220,18 @@ sidechain_net_handler_ethereum::sidechain_net_handler_ethereum(peerplays_sidecha
 
    ilog("Running on Ethereum network, chain id ${chain_id_str}, network id ${network_id_str}", ("chain_id_str", chain_id_str)("network_id_str", network_id_str));
 
+   listener.reset(new block_listener(
+         "Ethereum", plugin.app().data_dir() / "peerplays_sidechain" / "ethereum_last_block",
+         [this](uint64_t block_num) {
+            return fetch_block(block_num);
+         },
+         [this](uint64_t block_num, const std::string &block) {
+            handle_block(block_num, block);
+         }));
    const auto block_number = rpc_client->eth_blockNumber();
-   last_block_received = !block_number.empty() ? ethereum::from_hex<uint64_t>(block_number) : 0;
+   if (!block_number.empty())
+      listener->start_after(ethereum::from_hex<uint64_t>(block_number));
    schedule_ethereum_listener();
-   event_received.connect([this](const std::string &event_data) {
-      std::thread(&sidechain_net_handler_ethereum::handle_event, this, event_data).detach();
-   });
 }
 
 sidechain_net_handler_ethereum::~sidechain_net_handler_ethereum() {
@@ -741,10 +756,12 @@ bool sidechain_net_handler_ethereum::settle_sidechain_transaction(const sidechai
       return false;
    }
 
-   size_t count = 0;
-   for (const auto &entry : json.get_child("result_array")) {
-      const std::string receipt = rpc_client->eth_get_transaction_receipt(entry.second.get<std::string>("transaction_receipt"));
+   std::vector<std::string> transaction_hashes;
+   for (const auto &entry : json.get_child("result_array"))
+      transaction_hashes.push_back(entry.second.get<std::string>("transaction_receipt"));
 
+   size_t count = 0;
+   for (const std::string &receipt : rpc_client->eth_get_transaction_receipts(transaction_hashes)) {
       std::stringstream ss_receipt(receipt);
       boost::property_tree::ptree json_receipt;
       boost::property_tree::read_json(ss_receipt, json_receipt);
@@ -878,26 +895,25 @@ void sidechain_net_handler_ethereum::ethereum_listener_loop() {
    if (!reply.empty()) {
       const uint64_t head_block_number = ethereum::from_hex<uint64_t>(reply);
 
-      if (head_block_number != last_block_received) {
-         //! Check that current block number is greater than last one
-         if (head_block_number < last_block_received) {
-            wlog("Head block ${head_block_number} is greater than last received block ${last_block_received}", ("head_block_number", head_block_number)("last_block_received", last_block_received));
-            return;
-         }
-
-         //! Send event data for all blocks that passed
-         for (uint64_t i = last_block_received + 1; i <= head_block_number; ++i) {
-            const std::string block_number = ethereum::add_0x(ethereum::to_hex(i, false));
-            handle_event(block_number);
-         }
-
-         last_block_received = head_block_number;
+      //! Check that current block number is not less than the last one
+      if (head_block_number < listener->get_last_handled_block()) {
+         wlog("Head block ${head_block_number} is less than last received block ${last_block_received}", ("head_block_number", head_block_number)("last_block_received", listener->get_last_handled_block()));
+         return;
       }
+
+      //! Handle all blocks that passed
+      listener->catch_up(head_block_number);
    }
 }
 
-void sidechain_net_handler_ethereum::handle_event(const std::string &block_number) {
-   const std::string block = rpc_client->eth_get_block_by_number(block_number, true);
+std::string sidechain_net_handler_ethereum::fetch_block(uint64_t block_num) {
+   const std::string block = rpc_client->eth_get_block_by_number(ethereum::add_0x(ethereum::to_hex(block_num, false)), true);
+   // a block which is not available yet comes back as a null result
+   return json_rpc_has_result(block) ? block : std::string();
+}
+
+void sidechain_net_handler_ethereum::handle_block(uint64_t block_num, const std::string &block) {
+   const std::string block_number = ethereum::add_0x(ethereum::to_hex(block_num, false));
    if (block != "") {
       add_to_son_listener_log("BLOCK   : " + block_number);
       std::stringstream ss(block);
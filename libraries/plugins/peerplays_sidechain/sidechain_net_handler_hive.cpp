@@ -192,11 +192,15 @@ sidechain_net_handler_hive::sidechain_net_handler_hive(peerplays_sidechain_plugi
       hive::public_key_type::prefix = KEY_PREFIX_TST;
    }
 
-   last_block_received = 0;
+   listener.reset(new block_listener(
+         "Hive", plugin.app().data_dir() / "peerplays_sidechain" / "hive_last_block",
+         [this](uint64_t block_num) {
+            return fetch_block(block_num);
+         },
+         [this](uint64_t block_num, const std::string &block) {
+            handle_block(block_num, block);
+         }));
    schedule_hive_listener();
-   event_received.connect([this](const std::string &event_data) {
-      std::thread(&sidechain_net_handler_hive::handle_event, this, event_data).detach();
-   });
 }
 
 sidechain_net_handler_hive::~sidechain_net_handler_hive() {
@@ -910,11 +914,7 @@ void sidechain_net_handler_hive::hive_listener_loop() {
       boost::property_tree::read_json(ss, json);
       if (json.count("result")) {
          uint64_t head_block_number = json.get<uint64_t>("result.head_block_number");
-         if (head_block_number != last_block_received) {
-            std::string event_data = std::to_string(head_block_number);
-            handle_event(event_data);
-            last_block_received = head_block_number;
-         }
+         listener->catch_up(head_block_number);
       }
    }
 
@@ -929,10 +929,15 @@ void sidechain_net_handler_hive::hive_listener_loop() {
    //}
 }
 
-void sidechain_net_handler_hive::handle_event(const std::string &event_data) {
-   const std::string block = rpc_client->block_api_get_block(std::atoll(event_data.c_str()));
+std::string sidechain_net_handler_hive::fetch_block(uint64_t block_num) {
+   const std::string block = rpc_client->block_api_get_block(block_num);
+   // a block which is not produced yet comes back as an empty result
+   return json_rpc_has_result(block) ? block : std::string();
+}
+
+void sidechain_net_handler_hive::handle_block(uint64_t block_num, const std::string &block) {
    if (block != "") {
-      add_to_son_listener_log("BLOCK   : " + event_data);
+      add_to_son_listener_log("BLOCK   : " + std::to_string(block_num));
       std::stringstream ss(block);
       boost::property_tree::ptree block_json;
       boost::property_tree::read_json(ss, block_json);
@@ -28,11 +28,17 @@
 
 #include <fc/time.hpp>
 
+#include <future>
+#include <memory>
+
+namespace graphene { namespace chain { class worker_pool; } }
+
 namespace graphene { namespace snapshot_plugin {
 
 class snapshot_plugin : public graphene::app::plugin {
    public:
-      ~snapshot_plugin() {}
+      snapshot_plugin();
+      ~snapshot_plugin();
 
       std::string plugin_name()const override;
       std::string plugin_description()const override;
@@ -48,10 +54,18 @@ class snapshot_plugin : public graphene::app::plugin {
 
    private:
        void check_snapshot( const graphene::chain::signed_block& b);
+       void create_binary_snapshot( const graphene::chain::signed_block& head_block );
+       void load_binary_snapshot( const fc::path& source );
+       graphene::chain::worker_pool& workers();
 
        uint32_t           snapshot_block = -1, last_block = 0;
        fc::time_point_sec snapshot_time = fc::time_point_sec::maximum(), last_time = fc::time_point_sec(1);
        fc::path           dest;
+       bool               binary_format = false;
+
+       std::unique_ptr<graphene::chain::worker_pool> _workers;
+       /// Writing of the last binary snapshot, which continues after the chain thread has moved on
+       std::future<void>  _pending_write;
 };
 
 } } //graphene::snapshot_plugin
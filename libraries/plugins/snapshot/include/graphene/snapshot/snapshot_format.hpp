@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/types.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+namespace graphene { namespace snapshot_plugin {
+
+   /**
+    *  A binary snapshot is a snapshot_header, the packed head block and then one section per index.  The head
+    *  block seeds the block log of the node loading the snapshot, so that it can link the following blocks and
+    *  tell its peers where its chain ends.  Each section is a
+    *  snapshot_section_header followed by @ref snapshot_section_header::size bytes holding the packed objects of
+    *  the index exactly as index::save() writes them after its next id and version, so that a section can be
+    *  copied into an object database file without unpacking it.
+    */
+   struct snapshot_header
+   {
+      static const uint64_t current_magic   = 0x31504e5359505050ull; // "PPPYSNP1"
+      static const uint32_t current_version = 2;
+
+      uint64_t                        magic = current_magic;
+      uint32_t                        version = current_version;
+      graphene::chain::chain_id_type  chain_id;
+      uint32_t                        head_block_num = 0;
+      graphene::chain::block_id_type  head_block_id;
+      fc::time_point_sec              head_block_time;
+      uint32_t                        section_count = 0;
+   };
+
+   struct snapshot_section_header
+   {
+      graphene::db::object_id_type    index_id;
+      graphene::db::object_id_type    next_id;
+      fc::sha256                      object_version;
+      uint64_t                        object_count = 0;
+      uint64_t                        size = 0;
+      /// sha256 of the section's bytes
+      fc::sha256                      checksum;
+   };
+
+} } // graphene::snapshot_plugin
+
+FC_REFLECT( graphene::snapshot_plugin::snapshot_header,
+            (magic)(version)(chain_id)(head_block_num)(head_block_id)(head_block_time)(section_count) )
+FC_REFLECT( graphene::snapshot_plugin::snapshot_section_header,
+            (index_id)(next_id)(object_version)(object_count)(size)(checksum) )
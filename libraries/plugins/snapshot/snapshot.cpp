@@ -22,10 +22,23 @@
  * THE SOFTWARE.
  */
 #include <graphene/snapshot/snapshot.hpp>
+#include <graphene/snapshot/snapshot_format.hpp>
 
+#include <graphene/app/application.hpp>
+#include <graphene/chain/block_database.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/worker_pool.hpp>
 
+#include <fc/crypto/sha256.hpp>
+#include <fc/interprocess/file_mapping.hpp>
 #include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <thread>
 
 using namespace graphene::snapshot_plugin;
 using std::string;
@@ -36,6 +49,12 @@ namespace bpo = boost::program_options;
 static const char* OPT_BLOCK_NUM  = "snapshot-at-block";
 static const char* OPT_BLOCK_TIME = "snapshot-at-time";
 static const char* OPT_DEST       = "snapshot-to";
+static const char* OPT_FORMAT     = "snapshot-format";
+static const char* OPT_LOAD       = "snapshot-load-from";
+
+snapshot_plugin::snapshot_plugin() {}
+
+snapshot_plugin::~snapshot_plugin() {}
 
 void snapshot_plugin::plugin_set_program_options(
    boost::program_options::options_description& command_line_options,
@@ -44,7 +63,11 @@ void snapshot_plugin::plugin_set_program_options(
    command_line_options.add_options()
          (OPT_BLOCK_NUM, bpo::value<uint32_t>(), "Block number after which to do a snapshot")
          (OPT_BLOCK_TIME, bpo::value<string>(), "Block time (ISO format) after which to do a snapshot")
-         (OPT_DEST, bpo::value<string>(), "Pathname of JSON file where to store the snapshot")
+         (OPT_DEST, bpo::value<string>(), "Pathname of the file where to store the snapshot")
+         (OPT_FORMAT, bpo::value<string>()->default_value("json"),
+          "Format of the snapshot, \"binary\" (loadable with snapshot-load-from) or \"json\" (one object per line)")
+         (OPT_LOAD, bpo::value<string>(),
+          "Pathname of a binary snapshot to initialize an empty data directory from, instead of replaying from genesis")
          ;
    config_file_options.add(command_line_options);
 }
@@ -56,13 +79,23 @@ std::string snapshot_plugin::plugin_name()const
 
 std::string snapshot_plugin::plugin_description()const
 {
-   return "Create snapshots at a specified time or block number.";
+   return "Create snapshots at a specified time or block number, and bootstrap nodes from them.";
 }
 
 void snapshot_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 { try {
    ilog("snapshot plugin: plugin_initialize() begin");
 
+   if( options.count(OPT_FORMAT) )
+   {
+      const std::string format = options[OPT_FORMAT].as<std::string>();
+      FC_ASSERT( format == "binary" || format == "json", "Unknown snapshot-format ${f}", ("f",format) );
+      binary_format = ( format == "binary" );
+   }
+
+   if( options.count(OPT_LOAD) )
+      load_binary_snapshot( options[OPT_LOAD].as<std::string>() );
+
    if( options.count(OPT_BLOCK_NUM) || options.count(OPT_BLOCK_TIME) )
    {
       FC_ASSERT( options.count(OPT_DEST), "Must specify snapshot-to in addition to snapshot-at-block or snapshot-at-time!" );
@@ -82,9 +115,26 @@ void snapshot_plugin::plugin_initialize(const boost::program_options::variables_
 
 void snapshot_plugin::plugin_startup() {}
 
-void snapshot_plugin::plugin_shutdown() {}
+void snapshot_plugin::plugin_shutdown()
+{
+   if( _pending_write.valid() )
+      _pending_write.wait();
+   _workers.reset();
+}
 
-static void create_snapshot( const graphene::chain::database& db, const fc::path& dest )
+graphene::chain::worker_pool& snapshot_plugin::workers()
+{
+   if( !_workers )
+      _workers.reset( new graphene::chain::worker_pool( std::max( 1u, std::thread::hardware_concurrency() ) ) );
+   return *_workers;
+}
+
+static double megabytes_per_second( uint64_t bytes, const fc::microseconds& elapsed )
+{
+   return double(bytes) / 1024 / 1024 / std::max( 0.000001, elapsed.count() / 1000000.0 );
+}
+
+static void create_json_snapshot( const graphene::chain::database& db, const fc::path& dest )
 {
    ilog("snapshot plugin: creating snapshot");
    fc::ofstream out;
@@ -97,32 +147,223 @@ static void create_snapshot( const graphene::chain::database& db, const fc::path
       wlog( "Failed to open snapshot destination: ${ex}", ("ex",e) );
       return;
    }
-   for( uint32_t space_id = 0; space_id < 256; space_id++ )
-      for( uint32_t type_id = 0; type_id < 256; type_id++ )
+   db.inspect_all_indexes( [&out]( const graphene::db::index& index ) {
+      index.inspect_all_objects( [&out]( const graphene::db::object& o ) {
+         out << fc::json::to_string( o.to_variant() ) << '\n';
+      });
+   });
+   out.close();
+   ilog("snapshot plugin: created snapshot");
+}
+
+namespace {
+
+   struct packed_section
+   {
+      snapshot_section_header header;
+      vector<char>            data;
+   };
+
+   /// Packs the objects of @ref index the way primary_index::save() does, after its next id and version
+   packed_section pack_section( const graphene::db::index& index )
+   {
+      packed_section result;
+      result.header.index_id = graphene::db::object_id_type( index.object_space_id(), index.object_type_id(), 0 );
+      result.header.next_id = index.get_next_id();
+      result.header.object_version = index.get_object_version();
+      index.inspect_all_objects( [&]( const graphene::db::object& o ) {
+         const auto packed = fc::raw::pack( index.pack_object( o ) );
+         result.data.insert( result.data.end(), packed.begin(), packed.end() );
+         ++result.header.object_count;
+      });
+      result.header.size = result.data.size();
+      result.header.checksum = fc::sha256::hash( result.data.data(), result.data.size() );
+      return result;
+   }
+
+   void write_snapshot( const fc::path& dest, const snapshot_header& header,
+                        const graphene::chain::signed_block& head_block, const vector<packed_section>& sections )
+   {
+      const fc::time_point start = fc::time_point::now();
+      const fc::path tmp = dest.generic_string() + ".tmp";
       {
-         try
-         {
-            db.get_index( (uint8_t)space_id, (uint8_t)type_id );
-         }
-         catch (fc::assert_exception& e)
+         std::ofstream out( tmp.generic_string(), std::ofstream::binary | std::ofstream::trunc );
+         FC_ASSERT( out, "Failed to open snapshot destination ${d}", ("d",tmp) );
+         fc::raw::pack( out, header );
+         fc::raw::pack( out, head_block );
+         for( const auto& section : sections )
          {
-            continue;
+            fc::raw::pack( out, section.header );
+            out.write( section.data.data(), section.data.size() );
          }
-         auto& index = db.get_index( (uint8_t)space_id, (uint8_t)type_id );
-         index.inspect_all_objects( [&out]( const graphene::db::object& o ) {
-            out << fc::json::to_string( o.to_variant() ) << '\n';
-         });
+         out.flush();
+         FC_ASSERT( out, "Failed to write snapshot to ${d}", ("d",tmp) );
       }
-   out.close();
-   ilog("snapshot plugin: created snapshot");
+      fc::rename( tmp, dest );
+      const uint64_t bytes = fc::file_size( dest );
+      ilog( "snapshot plugin: wrote ${n} bytes to ${d} at ${r} MiB/s",
+            ("n",bytes)("d",dest)("r",megabytes_per_second( bytes, fc::time_point::now() - start )) );
+   }
+
+} // anonymous namespace
+
+/**
+ *  Packs all indexes in parallel while the chain thread waits, so that every section reflects the state after the
+ *  same block, then leaves writing the file to a background thread so that block application resumes.
+ */
+void snapshot_plugin::create_binary_snapshot( const graphene::chain::signed_block& head_block )
+{
+   if( _pending_write.valid() )
+      _pending_write.wait();
+
+   ilog("snapshot plugin: creating binary snapshot");
+   const graphene::chain::database& db = database();
+   const fc::time_point start = fc::time_point::now();
+
+   vector<const graphene::db::index*> indexes;
+   db.inspect_all_indexes( [&indexes]( const graphene::db::index& index ) {
+      indexes.push_back( &index );
+   });
+
+   vector< std::future<packed_section> > futures;
+   futures.reserve( indexes.size() );
+   for( const auto* index : indexes )
+      futures.push_back( workers().post( [index]() { return pack_section( *index ); } ) );
+
+   std::shared_ptr< vector<packed_section> > sections = std::make_shared< vector<packed_section> >();
+   sections->reserve( futures.size() );
+   uint64_t objects = 0;
+   uint64_t bytes = 0;
+   for( auto& f : futures )
+   {
+      sections->push_back( f.get() );
+      objects += sections->back().header.object_count;
+      bytes += sections->back().header.size;
+   }
+
+   snapshot_header header;
+   header.chain_id = db.get_chain_id();
+   header.head_block_num = db.head_block_num();
+   header.head_block_id = db.head_block_id();
+   header.head_block_time = db.head_block_time();
+   header.section_count = sections->size();
+
+   const fc::microseconds elapsed = fc::time_point::now() - start;
+   ilog( "snapshot plugin: packed ${o} objects of ${s} indexes at block ${b} in ${t} ms, ${r} MiB/s",
+         ("o",objects)("s",sections->size())("b",header.head_block_num)("t",elapsed.count() / 1000)
+         ("r",megabytes_per_second( bytes, elapsed )) );
+
+   const fc::path destination = dest;
+   _pending_write = std::async( std::launch::async, [destination, header, head_block, sections]() {
+      try
+      {
+         write_snapshot( destination, header, head_block, *sections );
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "Failed to write snapshot: ${e}", ("e",e.to_detail_string()) );
+      }
+   });
 }
 
+/**
+ *  Turns a binary snapshot into the object database files of a fresh data directory, one index file per section
+ *  written in parallel.  The block log only holds the snapshot's head block, the node starts there and syncs the
+ *  following blocks from its peers.
+ */
+void snapshot_plugin::load_binary_snapshot( const fc::path& source )
+{ try {
+   const fc::path data_dir = app().data_dir() / "blockchain";
+   FC_ASSERT( !fc::exists( data_dir / "object_database" ) && !fc::exists( data_dir / "database" ),
+              "Can only load a snapshot into an empty data directory, ${d} already holds a chain",
+              ("d",data_dir) );
+   FC_ASSERT( fc::exists( source ), "Snapshot ${s} does not exist", ("s",source) );
+
+   ilog( "snapshot plugin: loading snapshot ${s}", ("s",source) );
+   const fc::time_point start = fc::time_point::now();
+   const uint64_t file_size = fc::file_size( source );
+   fc::file_mapping fm( source.generic_string().c_str(), fc::read_only );
+   fc::mapped_region mr( fm, fc::read_only, 0, file_size );
+   fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
+
+   snapshot_header header;
+   fc::raw::unpack( ds, header );
+   FC_ASSERT( header.magic == snapshot_header::current_magic, "${s} is not a binary snapshot", ("s",source) );
+   FC_ASSERT( header.version == snapshot_header::current_version, "Unsupported snapshot version ${v}",
+              ("v",header.version) );
+   const graphene::chain::chain_id_type chain_id = app().genesis_chain_id();
+   FC_ASSERT( header.chain_id == chain_id, "Snapshot is of chain ${s}, but this node is configured for chain ${c}",
+              ("s",header.chain_id)("c",chain_id) );
+
+   graphene::chain::signed_block head_block;
+   fc::raw::unpack( ds, head_block );
+   FC_ASSERT( head_block.id() == header.head_block_id, "Head block of snapshot does not match its header" );
+
+   vector< std::pair<snapshot_section_header, const char*> > sections;
+   sections.reserve( header.section_count );
+   for( uint32_t i = 0; i < header.section_count; ++i )
+   {
+      snapshot_section_header section;
+      fc::raw::unpack( ds, section );
+      FC_ASSERT( ds.remaining() >= section.size, "Snapshot is truncated" );
+      sections.emplace_back( section, ds.pos() );
+      ds.skip( section.size );
+   }
+
+   const fc::path tmp_dir = data_dir / "object_database.tmp";
+   fc::remove_all( tmp_dir );
+   vector< std::future<void> > futures;
+   futures.reserve( sections.size() );
+   for( const auto& section : sections )
+      futures.push_back( workers().post( [&tmp_dir, &section]() {
+         const snapshot_section_header& h = section.first;
+         FC_ASSERT( fc::sha256::hash( section.second, h.size ) == h.checksum,
+                    "Checksum mismatch in section ${i} of snapshot", ("i",h.index_id) );
+         const fc::path dir = tmp_dir / fc::to_string( h.index_id.space() );
+         fc::create_directories( dir );
+         std::ofstream out( ( dir / fc::to_string( h.index_id.type() ) ).generic_string(),
+                            std::ofstream::binary | std::ofstream::trunc );
+         FC_ASSERT( out );
+         fc::raw::pack( out, h.next_id );
+         fc::raw::pack( out, h.object_version );
+         out.write( section.second, h.size );
+         out.flush();
+         FC_ASSERT( out, "Failed to write index ${i}", ("i",h.index_id) );
+      }) );
+   uint64_t objects = 0;
+   for( size_t i = 0; i < futures.size(); ++i )
+   {
+      futures[i].get();
+      objects += sections[i].first.object_count;
+   }
+
+   graphene::chain::block_database block_log;
+   block_log.open( data_dir / "database" / "block_num_to_block" );
+   block_log.store( head_block.id(), head_block );
+   block_log.close();
+
+   fc::rename( tmp_dir, data_dir / "object_database" );
+   std::ofstream version_file( ( data_dir / "db_version" ).generic_string(),
+                               std::ios::out | std::ios::binary | std::ios::trunc );
+   version_file.write( GRAPHENE_CURRENT_DB_VERSION, strlen( GRAPHENE_CURRENT_DB_VERSION ) );
+   version_file.close();
+
+   ilog( "snapshot plugin: loaded ${o} objects at block ${b} (${id}) of chain ${c} at ${r} MiB/s",
+         ("o",objects)("b",header.head_block_num)("id",header.head_block_id)("c",header.chain_id)
+         ("r",megabytes_per_second( file_size, fc::time_point::now() - start )) );
+} FC_CAPTURE_LOG_AND_RETHROW( (source) ) }
+
 void snapshot_plugin::check_snapshot( const graphene::chain::signed_block& b )
 { try {
     uint32_t current_block = b.block_num();
     if( (last_block < snapshot_block && snapshot_block <= current_block)
            || (last_time < snapshot_time && snapshot_time <= b.timestamp) )
-       create_snapshot( database(), dest );
+    {
+       if( binary_format )
+          create_binary_snapshot( b );
+       else
+          create_json_snapshot( database(), dest );
+    }
     last_block = current_block;
     last_time = b.timestamp;
 } FC_LOG_AND_RETHROW() }
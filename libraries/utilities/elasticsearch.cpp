@@ -27,6 +27,8 @@
 #include <fc/log/logger.hpp>
 #include <fc/io/json.hpp>
 
+#include <algorithm>
+
 size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
 {
    ((std::string*)userp)->append((char*)contents, size * nmemb);
@@ -106,6 +108,210 @@ bool SendBulk(ES& es)
    return false;
 }
 
+struct BulkSender::batch
+{
+   std::string body;
+   std::string response;
+   uint32_t attempts = 0;
+   fc::time_point next_attempt;
+   CURL* handler = nullptr;
+   struct curl_slist* headers = nullptr;
+};
+
+static const int64_t bulk_retry_min_backoff_ms = 100;
+static const int64_t bulk_retry_max_backoff_ms = 30000;
+static const int64_t bulk_shutdown_timeout_ms = 30000;
+
+BulkSender::BulkSender(const std::string& elasticsearch_url, const std::string& auth, uint32_t max_queued)
+   : _url(elasticsearch_url + "_bulk"),
+     _auth(auth),
+     _max_queued(std::max<uint32_t>(max_queued, 1))
+{
+   _thread = std::thread([this]() { run(); });
+}
+
+BulkSender::~BulkSender()
+{
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      if(!_queue_changed.wait_for(lock, std::chrono::milliseconds(bulk_shutdown_timeout_ms),
+                                  [this]() { return _rejected || (_queue.empty() && !_in_flight); }))
+         elog( "Dropping ${n} bulk requests not stored in Elastic Search on shutdown",
+               ("n", _queue.size() + (_in_flight ? 1 : 0)) );
+      _stopping = true;
+   }
+   _queue_changed.notify_all();
+   _thread.join();
+}
+
+bool BulkSender::send(std::vector<std::string>&& bulk_lines)
+{
+   if(bulk_lines.empty())
+      return true;
+   auto b = std::make_shared<batch>();
+   b->body = joinBulkLines(bulk_lines);
+   bulk_lines.clear();
+
+   std::unique_lock<std::mutex> lock(_mutex);
+   _queue_changed.wait(lock, [this]() { return _rejected || _queue.size() + (_in_flight ? 1 : 0) < _max_queued; });
+   if(_rejected)
+      return false;
+   _queue.push_back(b);
+   _queue_changed.notify_all();
+   return true;
+}
+
+bool BulkSender::flush()
+{
+   std::unique_lock<std::mutex> lock(_mutex);
+   _queue_changed.wait(lock, [this]() { return _rejected || (_queue.empty() && !_in_flight); });
+   return !_rejected;
+}
+
+void BulkSender::start_transfer(CURLM* multi)
+{
+   std::shared_ptr<batch> b = _queue.front();
+   _queue.pop_front();
+
+   b->response.clear();
+   b->handler = curl_easy_init();
+   b->headers = curl_slist_append(NULL, "Content-Type: application/json");
+   curl_easy_setopt(b->handler, CURLOPT_HTTPHEADER, b->headers);
+   curl_easy_setopt(b->handler, CURLOPT_URL, _url.c_str());
+   curl_easy_setopt(b->handler, CURLOPT_POST, true);
+   curl_easy_setopt(b->handler, CURLOPT_POSTFIELDS, b->body.c_str());
+   curl_easy_setopt(b->handler, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)b->body.size());
+   curl_easy_setopt(b->handler, CURLOPT_WRITEFUNCTION, WriteCallback);
+   curl_easy_setopt(b->handler, CURLOPT_WRITEDATA, (void *)&b->response);
+   curl_easy_setopt(b->handler, CURLOPT_USERAGENT, "libcrp/0.1");
+   if(!_auth.empty())
+      curl_easy_setopt(b->handler, CURLOPT_USERPWD, _auth.c_str());
+
+   curl_multi_add_handle(multi, b->handler);
+   _in_flight = b;
+}
+
+void BulkSender::log_rejected_batch(const std::shared_ptr<batch>& b)
+{
+   elog( "Elastic Search rejected ${n} bytes of bulk data, no more data is sent, the first lines are:",
+         ("n", b->body.size()) );
+   size_t pos = 0;
+   for( size_t i = 0; i < 10 && pos < b->body.size(); ++i )
+   {
+      const size_t end = std::min(b->body.find('\n', pos), b->body.size());
+      const std::string line = b->body.substr(pos, end - pos);
+      edump( (line) );
+      pos = end + 1;
+   }
+}
+
+void BulkSender::finish_transfer(const std::shared_ptr<batch>& b, transfer_result result)
+{
+   curl_slist_free_all(b->headers);
+   curl_easy_cleanup(b->handler);
+   b->headers = nullptr;
+   b->handler = nullptr;
+   ++b->attempts;
+
+   if(result == transfer_result::rejected)
+      log_rejected_batch(b);
+
+   std::lock_guard<std::mutex> lock(_mutex);
+   _in_flight.reset();
+   if(result == transfer_result::rejected)
+      _rejected = true;
+   else if(result == transfer_result::retry)
+   {
+      const int64_t backoff = std::min(bulk_retry_max_backoff_ms,
+                                       bulk_retry_min_backoff_ms << std::min<uint32_t>(b->attempts - 1, 16));
+      b->next_attempt = fc::time_point::now() + fc::milliseconds(backoff);
+      elog( "Error sending ${n} bytes of bulk data to Elastic Search (attempt ${a}), retrying in ${t} ms",
+            ("n", b->body.size())("a", b->attempts)("t", backoff) );
+      // the batch goes first again, the batches after it must not be stored before it
+      _queue.push_front(b);
+   }
+   _queue_changed.notify_all();
+}
+
+void BulkSender::run()
+{
+   CURLM* multi = curl_multi_init();
+   while(true)
+   {
+      {
+         std::unique_lock<std::mutex> lock(_mutex);
+         if(!_in_flight)
+         {
+            // nothing on the wire, sleep until a batch is queued or due for its retry
+            while(!_stopping && (_rejected || _queue.empty() || _queue.front()->next_attempt > fc::time_point::now()))
+            {
+               if(_rejected || _queue.empty())
+                  _queue_changed.wait(lock);
+               else
+                  _queue_changed.wait_for(lock, std::chrono::microseconds(
+                        (_queue.front()->next_attempt - fc::time_point::now()).count()));
+            }
+            if(_stopping)
+               break;
+            start_transfer(multi);
+         }
+         else if(_stopping)
+            break;
+      }
+
+      int running = 0;
+      curl_multi_perform(multi, &running);
+
+      int remaining = 0;
+      while(CURLMsg* msg = curl_multi_info_read(multi, &remaining))
+      {
+         if(msg->msg != CURLMSG_DONE)
+            continue;
+         std::shared_ptr<batch> b;
+         {
+            std::lock_guard<std::mutex> lock(_mutex);
+            b = _in_flight;
+         }
+         // only failures which may go away by themselves are retried, a rejected request would fail forever
+         transfer_result result = transfer_result::retry;
+         if(msg->data.result == CURLE_OK)
+         {
+            const long http_code = getResponseCode(msg->easy_handle);
+            if(http_code == 429 || http_code >= 500)
+               elog( "Elastic Search bulk request failed with HTTP ${c}", ("c", http_code) );
+            else
+            {
+               result = transfer_result::rejected;
+               try {
+                  if(handleBulkResponse(http_code, b->response))
+                     result = transfer_result::stored;
+               } catch(const fc::exception& e) {
+                  elog( "Unable to parse Elastic Search bulk response: ${e}", ("e", e.to_detail_string()) );
+               }
+            }
+         }
+         else
+            elog( "Elastic Search bulk request failed: ${e}", ("e", curl_easy_strerror(msg->data.result)) );
+         curl_multi_remove_handle(multi, msg->easy_handle);
+         finish_transfer(b, result);
+      }
+
+      curl_multi_wait(multi, NULL, 0, 100, NULL);
+   }
+
+   // shutting down, abort whatever is still on the wire
+   std::lock_guard<std::mutex> lock(_mutex);
+   if(_in_flight)
+   {
+      curl_multi_remove_handle(multi, _in_flight->handler);
+      curl_slist_free_all(_in_flight->headers);
+      curl_easy_cleanup(_in_flight->handler);
+      _in_flight.reset();
+   }
+   _queue.clear();
+   curl_multi_cleanup(multi);
+}
+
 const std::string joinBulkLines(const std::vector<std::string>& bulk)
 {
    auto bulking = boost::algorithm::join(bulk, "\n");
@@ -22,8 +22,13 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <curl/curl.h>
@@ -53,6 +58,49 @@ namespace graphene { namespace utilities {
          std::string query;
    };
 
+   /**
+    * Sends bulk requests to elasticsearch from a background thread.
+    *
+    * Batches are queued by send() and posted one at a time in the order they were queued, since elasticsearch
+    * may apply concurrent bulk requests in any order and an older version of a document could overwrite a
+    * newer one.  Batches failing with a transport error, a 429 or a 5xx response are retried with exponential
+    * backoff until they are stored.  Once elasticsearch rejects a batch, it is logged, nothing more is sent
+    * and send() and flush() return false, so that the caller can stop instead of leaving a gap in the index.
+    * send() only blocks the caller while max_queued batches are waiting or in flight.
+    */
+   class BulkSender {
+      public:
+         BulkSender(const std::string& elasticsearch_url, const std::string& auth, uint32_t max_queued);
+         /// Waits at most bulk_shutdown_timeout for the queued batches to be stored, then logs and drops the rest
+         ~BulkSender();
+
+         /// Queues the lines of one bulk request, waits while the queue is full, returns false if a batch was rejected
+         bool send(std::vector<std::string>&& bulk_lines);
+         /// Waits until all queued batches are stored, returns false if a batch was rejected
+         bool flush();
+
+      private:
+         struct batch;
+         enum class transfer_result { stored, retry, rejected };
+
+         void run();
+         void start_transfer(CURLM* multi);
+         void finish_transfer(const std::shared_ptr<batch>& b, transfer_result result);
+         void log_rejected_batch(const std::shared_ptr<batch>& b);
+
+         const std::string _url;
+         const std::string _auth;
+         const uint32_t _max_queued;
+
+         std::mutex _mutex;
+         std::condition_variable _queue_changed;
+         std::deque<std::shared_ptr<batch>> _queue;
+         std::shared_ptr<batch> _in_flight;
+         bool _rejected = false;
+         bool _stopping = false;
+         std::thread _thread;
+   };
+
    bool SendBulk(ES& es);
    const std::vector<std::string> createBulk(const fc::mutable_variant_object& bulk_header, const std::string&& data);
    bool checkES(ES& es);
@@ -34,6 +34,7 @@
 #include <graphene/accounts_list/accounts_list_plugin.hpp>
 #include <graphene/affiliate_stats/affiliate_stats_plugin.hpp>
 #include <graphene/market_history/market_history_plugin.hpp>
+#include <graphene/snapshot/snapshot.hpp>
 #include <fc/thread/thread.hpp>
 
 #include <boost/filesystem/path.hpp>
@@ -177,3 +178,162 @@ BOOST_AUTO_TEST_CASE( two_node_network )
       throw;
    }
 }
+
+BOOST_AUTO_TEST_CASE( binary_snapshot_round_trip )
+{
+   using namespace graphene::chain;
+   using namespace graphene::app;
+   try {
+      fc::temp_directory app_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory app2_dir( graphene::utilities::temp_directory_path() );
+      // both nodes need the same genesis, the example genesis starts at the current time
+      const boost::filesystem::path genesis = create_genesis_file(app_dir);
+      const fc::path snapshot = app_dir.path() / "snapshot.bin";
+      fc::ecc::private_key committee_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+
+      BOOST_TEST_MESSAGE( "Creating a snapshot at block 3 on app1" );
+      graphene::app::application app1;
+      app1.register_plugin<graphene::witness_plugin::witness_plugin>();
+      app1.register_plugin<graphene::bookie::bookie_plugin>();
+      auto snapshot1 = app1.register_plugin<graphene::snapshot_plugin::snapshot_plugin>();
+
+      boost::program_options::variables_map cfg;
+      cfg.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:0"), false));
+      cfg.emplace("plugins", boost::program_options::variable_value(string("snapshot"), false));
+      cfg.emplace("genesis-json", boost::program_options::variable_value(genesis, false));
+      cfg.emplace("snapshot-at-block", boost::program_options::variable_value(uint32_t(3), false));
+      cfg.emplace("snapshot-to", boost::program_options::variable_value(snapshot.generic_string(), false));
+      cfg.emplace("snapshot-format", boost::program_options::variable_value(string("binary"), false));
+      app1.initialize(app_dir.path(), cfg);
+      snapshot1->plugin_initialize(cfg);
+      app1.startup();
+
+      std::shared_ptr<chain::database> db1 = app1.chain_database();
+      std::vector<signed_block> blocks;
+      for( int i = 0; i < 4; ++i )
+         blocks.push_back( db1->generate_block( db1->get_slot_time(1), db1->get_scheduled_witness(1),
+                                                committee_key, database::skip_nothing ) );
+      // waits until the snapshot is written
+      snapshot1->plugin_shutdown();
+      BOOST_REQUIRE( fc::exists( snapshot ) );
+
+      BOOST_TEST_MESSAGE( "Starting app2 from the snapshot" );
+      graphene::app::application app2;
+      app2.register_plugin<graphene::witness_plugin::witness_plugin>();
+      app2.register_plugin<graphene::bookie::bookie_plugin>();
+      auto snapshot2 = app2.register_plugin<graphene::snapshot_plugin::snapshot_plugin>();
+
+      boost::program_options::variables_map cfg2;
+      cfg2.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:0"), false));
+      cfg2.emplace("plugins", boost::program_options::variable_value(string("snapshot"), false));
+      cfg2.emplace("genesis-json", boost::program_options::variable_value(genesis, false));
+      cfg2.emplace("snapshot-load-from", boost::program_options::variable_value(snapshot.generic_string(), false));
+      app2.initialize(app2_dir.path(), cfg2);
+      snapshot2->plugin_initialize(cfg2);
+      app2.startup();
+
+      std::shared_ptr<chain::database> db2 = app2.chain_database();
+      BOOST_CHECK_EQUAL( db2->head_block_num(), 3u );
+      BOOST_CHECK( db2->head_block_id() == blocks[2].id() );
+      BOOST_CHECK( db2->get_chain_id() == db1->get_chain_id() );
+      // the block a synopsis for the peers starts at
+      BOOST_CHECK( db2->get_block_id_for_num( db2->last_non_undoable_block_num() ) == blocks[2].id() );
+
+      BOOST_TEST_MESSAGE( "Pushing the next block to app2" );
+      db2->push_block( blocks[3] );
+      BOOST_CHECK_EQUAL( db2->head_block_num(), 4u );
+      BOOST_CHECK( db2->head_block_id() == db1->head_block_id() );
+      BOOST_CHECK( db2->get_block_id_for_num( 3 ) == blocks[2].id() );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( sync_recently_relayed_blocks )
+{
+   using namespace graphene::chain;
+   using namespace graphene::app;
+   try {
+      fc::temp_directory app_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory app2_dir( graphene::utilities::temp_directory_path() );
+      const boost::filesystem::path genesis = create_genesis_file(app_dir);
+      fc::ecc::private_key committee_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+
+      BOOST_TEST_MESSAGE( "Relaying blocks with transactions on app1" );
+      graphene::app::application app1;
+      app1.register_plugin<graphene::witness_plugin::witness_plugin>();
+      app1.register_plugin<graphene::bookie::bookie_plugin>();
+
+      boost::program_options::variables_map cfg;
+      cfg.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:0"), false));
+      cfg.emplace("plugins", boost::program_options::variable_value(string(" "), false));
+      cfg.emplace("genesis-json", boost::program_options::variable_value(genesis, false));
+      app1.initialize(app_dir.path(), cfg);
+      app1.startup();
+      string endpoint1 = app1.p2p_node()->get_actual_listening_endpoint();
+
+      std::shared_ptr<chain::database> db1 = app1.chain_database();
+      account_id_type nathan_id = db1->get_index_type<account_index>().indices().get<by_name>().find( "nathan" )->id;
+      for( int i = 0; i < 8; ++i )
+      {
+         signed_transaction trx;
+         if( i == 0 )
+         {
+            balance_claim_operation claim_op;
+            claim_op.deposit_to_account = nathan_id;
+            claim_op.balance_to_claim = balance_id_type();
+            claim_op.balance_owner_key = committee_key.get_public_key();
+            claim_op.total_claimed = balance_id_type()(*db1).balance;
+            trx.operations.push_back( claim_op );
+            db1->current_fee_schedule().set_fee( trx.operations.back() );
+         }
+         transfer_operation xfer_op;
+         xfer_op.from = nathan_id;
+         xfer_op.to = GRAPHENE_NULL_ACCOUNT;
+         xfer_op.amount = asset( 1000 + i );
+         trx.operations.push_back( xfer_op );
+         db1->current_fee_schedule().set_fee( trx.operations.back() );
+         trx.set_expiration( db1->get_slot_time( 10 ) );
+         trx.sign( committee_key, db1->get_chain_id() );
+         db1->push_transaction( trx );
+
+         signed_block b = db1->generate_block( db1->get_slot_time(1), db1->get_scheduled_witness(1),
+                                               committee_key, database::skip_nothing );
+         BOOST_REQUIRE_EQUAL( b.transactions.size(), 1u );
+         // puts the block in app1's message cache, as if it had been relayed
+         app1.p2p_node()->broadcast( graphene::net::block_message( b ) );
+      }
+
+      BOOST_TEST_MESSAGE( "Syncing app2 from app1" );
+      graphene::app::application app2;
+      app2.register_plugin<graphene::witness_plugin::witness_plugin>();
+      app2.register_plugin<graphene::bookie::bookie_plugin>();
+
+      boost::program_options::variables_map cfg2;
+      cfg2.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:0"), false));
+      cfg2.emplace("plugins", boost::program_options::variable_value(string(" "), false));
+      cfg2.emplace("genesis-json", boost::program_options::variable_value(genesis, false));
+      cfg2.emplace("seed-node", boost::program_options::variable_value(vector<string>{endpoint1}, false));
+      app2.initialize(app2_dir.path(), cfg2);
+      app2.startup();
+
+      std::shared_ptr<chain::database> db2 = app2.chain_database();
+      int counter = 0;
+      while( db2->head_block_num() < db1->head_block_num() )
+      {
+         fc::usleep(fc::milliseconds(100));
+         if( counter++ >= 300 )
+            break;
+      }
+
+      // the last blocks are fetched as sync items from app1's message cache, they must come in full
+      BOOST_CHECK_EQUAL( db2->head_block_num(), 8u );
+      BOOST_CHECK( db2->head_block_id() == db1->head_block_id() );
+      BOOST_CHECK_EQUAL( app1.p2p_node()->get_connection_count(), 1u );
+      BOOST_CHECK_EQUAL( app2.p2p_node()->get_connection_count(), 1u );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/block_database.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/crypto/digest.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using namespace graphene::chain;
+
+namespace {
+
+/// Reads blocks the way block_database used to: seek and read on one shared stream
+struct stream_block_reader
+{
+   stream_block_reader( const fc::path& dir )
+   {
+      index.open( (dir / "index").generic_string().c_str(), std::fstream::binary | std::fstream::in );
+      blocks.open( (dir / "blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in );
+   }
+
+   optional<signed_block> fetch_by_number( uint32_t block_num )
+   {
+      std::lock_guard<std::mutex> guard( mutex );
+      index_entry e;
+      index.seekg( sizeof(e) * block_num );
+      index.read( (char*)&e, sizeof(e) );
+      vector<char> data( e.block_size );
+      blocks.seekg( e.block_pos );
+      blocks.read( data.data(), e.block_size );
+      return fc::raw::unpack<signed_block>( data );
+   }
+
+   std::mutex    mutex;
+   std::ifstream index;
+   std::ifstream blocks;
+};
+
+template<typename Fetch>
+double random_reads_per_second( uint32_t block_count, uint32_t reads, uint32_t threads, Fetch&& fetch )
+{
+   fc::time_point start = fc::time_point::now();
+   std::vector<std::thread> workers;
+   for( uint32_t t = 0; t < threads; ++t )
+      workers.emplace_back( [&,t]() {
+         std::mt19937 rng( t );
+         std::uniform_int_distribution<uint32_t> dist( 1, block_count );
+         for( uint32_t i = 0; i < reads / threads; ++i )
+            FC_ASSERT( fetch( dist( rng ) ) );
+      });
+   for( auto& w : workers )
+      w.join();
+   const int64_t us = std::max<int64_t>( 1, ( fc::time_point::now() - start ).count() );
+   return double( reads / threads * threads ) * 1000000 / us;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( block_database_random_read_bench )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t block_count = 200000;
+      const uint32_t reads = 1000000;
+#else
+      const uint32_t block_count = 20000;
+      const uint32_t reads = 100000;
+#endif
+      const uint32_t threads = std::max( 2u, std::thread::hardware_concurrency() );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      signed_block b;
+      for( uint32_t i = 0; i < block_count; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type( i % 11 );
+         b.transactions.clear();
+         for( uint32_t t = 0; t < i % 8; ++t )
+         {
+            signed_transaction trx;
+            trx.ref_block_num = t;
+            trx.signatures.emplace_back();
+            b.transactions.push_back( trx );
+         }
+         bdb.store( b.id(), b );
+      }
+      bdb.flush();
+
+      stream_block_reader stream( data_dir.path() );
+
+      double rate = random_reads_per_second( block_count, reads, 1, [&]( uint32_t n ) {
+         return stream.fetch_by_number( n ).valid(); } );
+      ilog( "stream, 1 thread: ${r} blocks/s", ("r", uint64_t(rate)) );
+      rate = random_reads_per_second( block_count, reads, threads, [&]( uint32_t n ) {
+         return stream.fetch_by_number( n ).valid(); } );
+      ilog( "stream, ${t} threads: ${r} blocks/s", ("t", threads)("r", uint64_t(rate)) );
+
+      rate = random_reads_per_second( block_count, reads, 1, [&]( uint32_t n ) {
+         return bdb.fetch_by_number( n ).valid(); } );
+      ilog( "mapped, 1 thread: ${r} blocks/s", ("r", uint64_t(rate)) );
+      rate = random_reads_per_second( block_count, reads, threads, [&]( uint32_t n ) {
+         return bdb.fetch_by_number( n ).valid(); } );
+      ilog( "mapped, ${t} threads: ${r} blocks/s", ("t", threads)("r", uint64_t(rate)) );
+      rate = random_reads_per_second( block_count, reads, threads, [&]( uint32_t n ) {
+         return bdb.fetch_packed_by_number( n ).valid(); } );
+      ilog( "mapped packed (no unpack), ${t} threads: ${r} blocks/s", ("t", threads)("r", uint64_t(rate)) );
+
+      bdb.close();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
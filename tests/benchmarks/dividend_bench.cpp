@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/hardfork.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/vesting_balance_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+namespace {
+
+/// Creates holders of GPOS vesting balances of the core asset directly, without going through operations
+void add_synthetic_holders( database& db, uint32_t first, uint32_t count )
+{
+   const fc::time_point_sec now = db.head_block_time();
+   for( uint32_t i = first; i < first + count; ++i )
+   {
+      const share_type stake = 1000 + i % 1000;
+      const account_object& holder = db.create<account_object>( [&]( account_object& a ) {
+         a.name = "holder" + fc::to_string( i );
+         a.registrar = a.referrer = a.lifetime_referrer = GRAPHENE_COMMITTEE_ACCOUNT;
+         a.options.voting_account = GRAPHENE_PROXY_TO_SELF_ACCOUNT;
+         a.statistics = db.create<account_statistics_object>( [&]( account_statistics_object& s ) {
+            s.owner = a.id;
+            s.name = a.name;
+            s.last_vote_time = now;
+         }).id;
+      });
+
+      db.adjust_balance( GRAPHENE_COMMITTEE_ACCOUNT, -asset( stake ) );
+      db.create<vesting_balance_object>( [&]( vesting_balance_object& vbo ) {
+         vbo.owner = holder.id;
+         vbo.balance = asset( stake );
+         vbo.balance_type = vesting_balance_type::gpos;
+      });
+   }
+}
+
+/// Runs the next maintenance interval and returns how long it took in milliseconds
+int64_t run_maintenance( database_fixture& f )
+{
+   fc::time_point start = fc::time_point::now();
+   f.generate_blocks( f.db.get_dynamic_global_properties().next_maintenance_time );
+   return ( fc::time_point::now() - start ).count() / 1000;
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE( dividend_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const vector<uint32_t> holder_counts = { 100000, 1000000 };
+#else
+      const vector<uint32_t> holder_counts = { 10000, 100000 };
+#endif
+
+      generate_blocks( HARDFORK_GPOS_TIME + db.get_global_properties().parameters.gpos_subperiod() );
+      db.modify( db.get_global_properties(), [this]( global_property_object& p ) {
+         p.parameters.extensions.value.gpos_period_start = db.head_block_time().sec_since_epoch();
+      });
+      generate_block();
+
+      const asset_object& core = db.get_core_asset();
+      BOOST_REQUIRE( core.dividend_data_id );
+      const account_id_type distribution_account = core.dividend_data(db).dividend_distribution_account;
+      const auto& vesting_idx = db.get_index_type< primary_index< vesting_balance_index > >();
+      const auto& holder_idx = vesting_idx.get_secondary_index< vesting_balance_holder_index >();
+
+      uint32_t holders = 0;
+      for( uint32_t count : holder_counts )
+      {
+         add_synthetic_holders( db, holders, count - holders );
+         holders = count;
+
+         // what the scheduling used to rebuild for every dividend asset at every maintenance interval
+         fc::time_point start = fc::time_point::now();
+         std::map<account_id_type, share_type> walked_amounts;
+         share_type walked_total;
+         auto range = vesting_idx.indices().get<by_asset_balance>().equal_range(
+               boost::make_tuple( asset_id_type(), vesting_balance_type::gpos ) );
+         for( const vesting_balance_object& vbo : boost::make_iterator_range( range.first, range.second ) )
+         {
+            walked_amounts[vbo.owner] += vbo.balance.amount;
+            walked_total += vbo.balance.amount;
+         }
+         const int64_t walk_ms = ( fc::time_point::now() - start ).count() / 1000;
+
+         const auto& totals = holder_idx.get_holder_totals( asset_id_type(), vesting_balance_type::gpos );
+         BOOST_CHECK( totals.amounts == walked_amounts );
+         BOOST_CHECK( totals.total == walked_total );
+
+         const int64_t idle_ms = run_maintenance( *this );
+
+         db.adjust_balance( GRAPHENE_COMMITTEE_ACCOUNT, -asset( holders * 10 ) );
+         db.adjust_balance( distribution_account, asset( holders * 10 ) );
+         const int64_t payout_ms = run_maintenance( *this );
+
+         ilog( "${h} holders: walking vesting balances ${w} ms, maintenance without deposit ${i} ms, "
+               "with deposit ${p} ms", ("h", holders)("w", walk_ms)("i", idle_ms)("p", payout_ms) );
+      }
+   } catch( fc::exception& e ) {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/betting_market_object.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+namespace {
+
+const uint32_t sessions_per_block = 1000;
+
+/// Modifies what a transfer evaluator modifies: two balances and the payer's statistics, plus its history
+void transfer_session( database& db, const account_balance_object& from, const account_balance_object& to,
+                       const account_statistics_object& stats )
+{
+   auto session = db._undo_db.start_undo_session();
+   db.modify( from, []( account_balance_object& b ) { b.balance -= 10; } );
+   db.modify( to, []( account_balance_object& b ) { b.balance += 10; } );
+   db.modify( stats, []( account_statistics_object& s ) { s.pending_fees += 1; } );
+   db.create<operation_history_object>( []( operation_history_object& h ) { h.op = transfer_operation(); } );
+   session.merge();
+}
+
+/// Modifies what placing a bet modifies: the bettor's balance, a new bet and its history
+void bet_session( database& db, const account_balance_object& bettor, uint32_t i )
+{
+   auto session = db._undo_db.start_undo_session();
+   db.modify( bettor, []( account_balance_object& b ) { b.balance -= 10; } );
+   db.create<bet_object>( [&]( bet_object& bet ) {
+      bet.bettor_id = bettor.owner;
+      bet.betting_market_id = betting_market_id_type( i % 16 );
+      bet.amount_to_bet = asset( 10 );
+      bet.backer_multiplier = 2 * GRAPHENE_BETTING_ODDS_PRECISION;
+      bet.back_or_lay = bet_type::back;
+   });
+   db.create<operation_history_object>( []( operation_history_object& h ) { h.op = bet_place_operation(); } );
+   session.merge();
+}
+
+/// Runs sessions the way pending transactions are applied: nested in a pending session which is undone per block
+template<typename Session>
+double sessions_per_second( database& db, uint32_t blocks, Session&& run )
+{
+   fc::time_point start = fc::time_point::now();
+   for( uint32_t block = 0; block < blocks; ++block )
+   {
+      auto pending = db._undo_db.start_undo_session( true );
+      for( uint32_t i = 0; i < sessions_per_block; ++i )
+         run( i );
+      pending.undo();
+   }
+   fc::microseconds elapsed = fc::time_point::now() - start;
+   return double( blocks ) * sessions_per_block * 1000000.0 / std::max<int64_t>( elapsed.count(), 1 );
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE( undo_session_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t blocks = 1000;
+#else
+      const uint32_t blocks = 100;
+#endif
+      ACTORS( (alice)(bob) );
+      transfer( committee_account, alice_id, asset( 1000000 ) );
+      transfer( committee_account, bob_id, asset( 1000000 ) );
+      generate_block();
+
+      const account_balance_object& alice_balance = *db.get_index_type< primary_index< account_balance_index > >()
+            .get_secondary_index< balances_by_account_index >().get_account_balance( alice_id, asset_id_type() );
+      const account_balance_object& bob_balance = *db.get_index_type< primary_index< account_balance_index > >()
+            .get_secondary_index< balances_by_account_index >().get_account_balance( bob_id, asset_id_type() );
+      const account_statistics_object& alice_stats = alice_id( db ).statistics( db );
+      const share_type alice_amount = alice_balance.balance;
+
+      double transfers = sessions_per_second( db, blocks, [&]( uint32_t ) {
+         transfer_session( db, alice_balance, bob_balance, alice_stats );
+      });
+      ilog( "Transfer sessions: ${r}/sec", ("r", uint64_t(transfers)) );
+      BOOST_CHECK( alice_balance.balance == alice_amount );
+
+      double bets = sessions_per_second( db, blocks, [&]( uint32_t i ) {
+         bet_session( db, alice_balance, i );
+      });
+      ilog( "Bet sessions: ${r}/sec", ("r", uint64_t(bets)) );
+      BOOST_CHECK( alice_balance.balance == alice_amount );
+      BOOST_CHECK( db.get_index_type<bet_object_index>().indices().empty() );
+   } catch( fc::exception& e ) {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/hardfork.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/vesting_balance_object.hpp>
+#include <graphene/chain/witness_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+namespace {
+
+/// Creates voters holding GPOS vesting balances directly, without going through operations
+void add_synthetic_voters( database& db, uint32_t first, uint32_t count, const vector<vote_id_type>& candidates )
+{
+   const fc::time_point_sec now = db.head_block_time();
+   const share_type stake = 1000;
+   for( uint32_t i = first; i < first + count; ++i )
+   {
+      const account_object& voter = db.create<account_object>( [&]( account_object& a ) {
+         a.name = "voter" + fc::to_string( i );
+         a.registrar = a.referrer = a.lifetime_referrer = GRAPHENE_COMMITTEE_ACCOUNT;
+         a.options.voting_account = GRAPHENE_PROXY_TO_SELF_ACCOUNT;
+         a.options.num_witness = candidates.size();
+         a.options.votes.insert( candidates[i % candidates.size()] );
+         a.options.votes.insert( candidates[(i * 7) % candidates.size()] );
+         a.statistics = db.create<account_statistics_object>( [&]( account_statistics_object& s ) {
+            s.owner = a.id;
+            s.name = a.name;
+            s.is_voting = true;
+            s.core_in_balance = 1;
+            s.last_vote_time = now;
+         }).id;
+      });
+
+      db.adjust_balance( GRAPHENE_COMMITTEE_ACCOUNT, -asset( stake ) );
+      db.create<vesting_balance_object>( [&]( vesting_balance_object& vbo ) {
+         vbo.owner = voter.id;
+         vbo.balance = asset( stake );
+         vbo.balance_type = vesting_balance_type::gpos;
+      });
+   }
+}
+
+/// Runs the next maintenance interval and returns the votes of the witnesses
+vector<uint64_t> run_maintenance( database_fixture& f, size_t threads, uint32_t voters )
+{
+   f.db.set_precompute_threads( threads );
+
+   fc::time_point start = fc::time_point::now();
+   f.generate_blocks( f.db.get_dynamic_global_properties().next_maintenance_time );
+   fc::time_point end = fc::time_point::now();
+   ilog( "Maintenance with ${v} voters on ${t} worker threads took ${ms} ms",
+         ("v", voters)("t", threads)("ms", (end - start).count() / 1000) );
+
+   vector<uint64_t> votes;
+   for( const witness_object& wit : f.db.get_index_type<witness_index>().indices() )
+      votes.push_back( wit.total_votes );
+   return votes;
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE( vote_tally_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const vector<uint32_t> voter_counts = { 100000, 1000000 };
+#else
+      const vector<uint32_t> voter_counts = { 10000, 100000 };
+#endif
+      const size_t threads = std::max( 2u, std::thread::hardware_concurrency() );
+
+      // stake only consists of GPOS vesting balances half a subperiod after the hard fork,
+      // which is when the tally runs on the worker threads
+      generate_blocks( HARDFORK_GPOS_TIME + db.get_global_properties().parameters.gpos_subperiod() );
+      db.modify( db.get_global_properties(), [this]( global_property_object& p ) {
+         p.parameters.extensions.value.gpos_period_start = db.head_block_time().sec_since_epoch();
+      });
+      generate_block();
+
+      vector<vote_id_type> candidates;
+      for( const witness_object& wit : db.get_index_type<witness_index>().indices() )
+         candidates.push_back( wit.vote_id );
+
+      uint32_t voters = 0;
+      for( uint32_t count : voter_counts )
+      {
+         add_synthetic_voters( db, voters, count - voters, candidates );
+         voters = count;
+
+         const vector<uint64_t> serial_votes = run_maintenance( *this, 0, voters );
+         const vector<uint64_t> parallel_votes = run_maintenance( *this, threads, voters );
+         BOOST_CHECK( serial_votes == parallel_votes );
+         BOOST_CHECK( parallel_votes.front() > 0 );
+      }
+   } catch( fc::exception& e ) {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
@@ -118,6 +118,15 @@ database_fixture::database_fixture()
       options.insert(std::make_pair("track-account", boost::program_options::variable_value(track_account, false)));
       options.insert(std::make_pair("partial-operations", boost::program_options::variable_value(true, false)));
    }
+   // market history is only recorded when bucket sizes are configured
+   if( !options.count("bucket-size") && boost::unit_test::framework::current_test_case().p_name.value == "get_ticker") {
+      options.insert(std::make_pair("bucket-size", boost::program_options::variable_value(std::string("[15,60,300,3600,86400]"), false)));
+   }
+   // replayed buckets are only written out after this many blocks, unless the database is flushed first
+   if( !options.count("bucket-size") && boost::unit_test::framework::current_test_case().p_name.value == "flush_writes_replayed_buckets") {
+      options.insert(std::make_pair("bucket-size", boost::program_options::variable_value(std::string("[15,60,300,3600,86400]"), false)));
+      options.insert(std::make_pair("bucket-replay-flush-blocks", boost::program_options::variable_value(uint32_t(1000), false)));
+   }
    // account tracking 2 accounts
    if( !options.count("track-account") && boost::unit_test::framework::current_test_case().p_name.value == "track_account2") {
       std::vector<std::string> track_account;
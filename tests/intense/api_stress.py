@@ -48,19 +48,51 @@ def mainloop():
 
     yield from peek_random_account()
 
+    # read-only calls which can be served by the api-read-threads of the node, each client keeps one in flight
+    read_calls = [
+        ["list_assets", ["", 100]],
+        ["get_order_book", ["1.3.0", "1.3.1", 50]],
+        ["get_full_accounts", [["1.2."+str(my_account_id)], False]],
+    ]
+    read_call_ids = set()
+
+    def send_read_call():
+        nonlocal next_call_id
+        method, params = rand.choice(read_calls)
+        read_call_ids.add(next_call_id)
+        call = {"id" : next_call_id, "method" : "call", "params": [0, method, params]}
+        next_call_id += 1
+        yield from ws.send(json.dumps(call))
+
+    yield from send_read_call()
+
     while True:
         result = yield from ws.recv()
         #print(result)
         if result is None:
            break
+        call_id = json.loads(result).get("id")
+        if call_id in read_call_ids:
+            read_call_ids.remove(call_id)
+            read_stats["completed"] += 1
+            yield from send_read_call()
     yield from ws.close()
 
+read_stats = {"completed" : 0, "start" : time.time()}
+
+def report_read_calls(signum, frame):
+    elapsed = time.time() - read_stats["start"]
+    print("{} read-only calls in {:.1f}s, {:.1f}/s".format(read_stats["completed"], elapsed, read_stats["completed"] / elapsed))
+    sys.stdout.flush()
+    os._exit(0)
+
 child_procs = []
 
 # stress test with 200 instances
 while len(child_procs) < 200:
     pid = os.fork()
     if pid == 0:
+        signal.signal(signal.SIGTERM, report_read_calls)
         asyncio.get_event_loop().run_until_complete(mainloop())
         break
     else:
@@ -0,0 +1,179 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <graphene/peerplays_sidechain/bitcoin/block_reader.hpp>
+
+using namespace graphene::peerplays_sidechain;
+using namespace graphene::peerplays_sidechain::bitcoin;
+
+namespace {
+
+/// The outputs of a getblock reply read the way bitcoin_rpc_client::getblock used to, through a property tree
+std::vector<info_for_vin> read_block_outputs_with_ptree(const std::string &reply) {
+   std::stringstream ss(reply);
+   boost::property_tree::ptree json;
+   boost::property_tree::read_json(ss, json);
+
+   std::vector<info_for_vin> result;
+   for (const auto &tx_child : json.get_child("result.tx")) {
+      const auto &tx = tx_child.second;
+      for (const auto &o : tx.get_child("vout")) {
+         const auto script = o.second.get_child("scriptPubKey");
+         std::vector<std::string> address_list;
+         if (script.count("address")) {
+            address_list.emplace_back(script.get<std::string>("address"));
+         } else if (script.count("addresses")) {
+            for (const auto &addr : script.get_child("addresses"))
+               address_list.emplace_back(addr.second.get_value<std::string>());
+         }
+         for (const auto &address : address_list) {
+            info_for_vin vin;
+            vin.out.hash_tx = tx.get<std::string>("txid");
+            std::string amount = o.second.get<std::string>("value");
+            amount.erase(std::remove(amount.begin(), amount.end(), '.'), amount.end());
+            vin.out.amount = std::stoll(amount);
+            vin.out.n_vout = o.second.get<uint32_t>("n");
+            vin.address = address;
+            result.push_back(vin);
+         }
+      }
+   }
+   return result;
+}
+
+/// A getblock reply shaped like a mainnet block: segwit inputs, several outputs per transaction and full hex
+std::string make_getblock_reply(uint32_t tx_count) {
+   std::stringstream ss;
+   ss << "{\"result\":{\"hash\":\"" << std::string(64, '0') << "\",\"confirmations\":1,\"height\":800000,\"tx\":[";
+   for (uint32_t t = 0; t < tx_count; t++) {
+      std::stringstream txid;
+      txid << std::hex << std::setw(64) << std::setfill('0') << t * 2654435761u;
+      ss << (t ? "," : "") << "{\"txid\":\"" << txid.str() << "\",\"hash\":\"" << txid.str() << "\",\"version\":2,\"size\":222,\"vsize\":141,\"weight\":561,\"locktime\":0,"
+         << "\"vin\":[{\"txid\":\"" << txid.str() << "\",\"vout\":0,\"scriptSig\":{\"asm\":\"\",\"hex\":\"\"},"
+         << "\"txinwitness\":[\"" << std::string(142, 'a') << "\",\"" << std::string(66, 'b') << "\"],\"sequence\":4294967293}],\"vout\":[";
+      for (uint32_t o = 0; o < 3; o++) {
+         ss << (o ? "," : "") << "{\"value\":0." << std::setw(8) << std::setfill('0') << (t * 7919 + o * 104729) % 100000000
+            << ",\"n\":" << o << ",\"scriptPubKey\":{\"asm\":\"0 " << std::string(40, 'c') << "\",\"desc\":\"addr(bc1q)#x\",\"hex\":\"0014" << std::string(40, 'c') << "\",";
+         if (o == 2 && t % 2)
+            ss << "\"type\":\"nulldata\"}}";
+         else
+            ss << "\"address\":\"bc1q" << t << "x" << o << "\",\"type\":\"witness_v0_keyhash\"}}";
+      }
+      ss << "],\"fee\":0.00002000,\"hex\":\"" << std::string(444, 'f') << "\"}";
+   }
+   ss << "]},\"error\":null,\"id\":1}";
+   return ss.str();
+}
+
+bool same_outputs(const std::vector<info_for_vin> &a, const std::vector<info_for_vin> &b) {
+   if (a.size() != b.size())
+      return false;
+   for (size_t i = 0; i < a.size(); i++) {
+      if (a[i].out != b[i].out || a[i].address != b[i].address)
+         return false;
+   }
+   return true;
+}
+
+template <typename Functor>
+double time_ms(Functor &&f, int runs) {
+   const auto start = std::chrono::steady_clock::now();
+   for (int i = 0; i < runs; i++)
+      f();
+   return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(bitcoin_block_reader_tests)
+
+BOOST_AUTO_TEST_CASE(read_outputs) {
+   const std::string reply = R"({"result": {"hash": "00ab", "tx": [
+      {"txid": "t1", "vin": [{"coinbase": "03\"{[", "sequence": 1}], "vout": [
+         {"value": 6.25000000, "n": 0, "scriptPubKey": {"hex": "00", "address": "addr1", "type": "witness_v0_keyhash"}},
+         {"value": 0.00000000, "n": 1, "scriptPubKey": {"asm": "OP_RETURN aa", "type": "nulldata"}}]},
+      {"vout": [
+         {"n": 0, "scriptPubKey": {"addresses": ["addr2", "addr3"], "type": "multisig"}, "value": 0.00010000}],
+       "txid": "t2"}
+   ]}, "error": null, "id": 1})";
+
+   const auto outputs = read_block_outputs(reply);
+   BOOST_REQUIRE_EQUAL(outputs.size(), 3u);
+   BOOST_CHECK_EQUAL(outputs[0].out.hash_tx, "t1");
+   BOOST_CHECK_EQUAL(outputs[0].out.n_vout, 0u);
+   BOOST_CHECK_EQUAL(outputs[0].out.amount, 625000000u);
+   BOOST_CHECK_EQUAL(outputs[0].address, "addr1");
+   BOOST_CHECK_EQUAL(outputs[1].out.hash_tx, "t2");
+   BOOST_CHECK_EQUAL(outputs[1].out.amount, 10000u);
+   BOOST_CHECK_EQUAL(outputs[1].address, "addr2");
+   BOOST_CHECK_EQUAL(outputs[2].address, "addr3");
+   BOOST_CHECK(same_outputs(outputs, read_block_outputs_with_ptree(reply)));
+
+   const std::unordered_set<std::string> watched{"addr3", "unused"};
+   const auto watched_outputs = read_block_outputs(reply, &watched);
+   BOOST_REQUIRE_EQUAL(watched_outputs.size(), 1u);
+   BOOST_CHECK_EQUAL(watched_outputs[0].out.hash_tx, "t2");
+   BOOST_CHECK_EQUAL(watched_outputs[0].address, "addr3");
+
+   BOOST_CHECK(read_block_outputs(R"({"result": null, "error": {"code": -5}, "id": 1})").empty());
+   BOOST_CHECK_THROW(read_block_outputs(reply.substr(0, reply.size() / 2)), fc::exception);
+}
+
+BOOST_AUTO_TEST_CASE(matches_property_tree) {
+   const std::string reply = make_getblock_reply(500);
+   BOOST_CHECK(same_outputs(read_block_outputs(reply), read_block_outputs_with_ptree(reply)));
+}
+
+// Pass --getblock-payloads=<dir> to also time captured getblock replies, one per file
+BOOST_AUTO_TEST_CASE(benchmark_read_outputs) {
+   std::vector<std::pair<std::string, std::string>> payloads;
+   payloads.emplace_back("generated 3000 transactions", make_getblock_reply(3000));
+
+   int argc = boost::unit_test::framework::master_test_suite().argc;
+   char **argv = boost::unit_test::framework::master_test_suite().argv;
+   for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      const std::string option = "--getblock-payloads=";
+      if (arg.compare(0, option.size(), option) != 0)
+         continue;
+      for (boost::filesystem::directory_iterator itr(arg.substr(option.size())), end; itr != end; ++itr) {
+         boost::filesystem::ifstream file(itr->path(), std::ios::binary);
+         std::stringstream content;
+         content << file.rdbuf();
+         payloads.emplace_back(itr->path().filename().string(), content.str());
+      }
+   }
+
+   for (const auto &payload : payloads) {
+      const auto outputs = read_block_outputs(payload.second);
+      BOOST_CHECK(same_outputs(outputs, read_block_outputs_with_ptree(payload.second)));
+
+      // a handful of watched deposit addresses, as a SON has
+      std::unordered_set<std::string> watched;
+      for (size_t i = 0; i < outputs.size(); i += std::max<size_t>(1, outputs.size() / 10))
+         watched.insert(outputs[i].address);
+
+      const int runs = 5;
+      const double ptree_ms = time_ms([&] { read_block_outputs_with_ptree(payload.second); }, runs);
+      const double reader_ms = time_ms([&] { read_block_outputs(payload.second); }, runs);
+      const double watched_ms = time_ms([&] { read_block_outputs(payload.second, &watched); }, runs);
+
+      std::cout << payload.first << ": " << payload.second.size() / 1024 << " KiB, " << outputs.size() << " outputs, "
+                << "property_tree " << ptree_ms << " ms, reader " << reader_ms << " ms, reader with "
+                << watched.size() << " watched addresses " << watched_ms << " ms" << std::endl;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,147 @@
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <fc/filesystem.hpp>
+
+#include <graphene/peerplays_sidechain/common/block_listener.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+using namespace graphene::peerplays_sidechain;
+
+namespace {
+
+/// A sidechain node producing blocks on its own thread, failing the first fetch of some blocks
+class mock_node {
+public:
+   explicit mock_node(uint64_t start_head) :
+         head(start_head) {
+   }
+
+   ~mock_node() {
+      stop();
+   }
+
+   void produce(uint64_t blocks, std::chrono::microseconds interval) {
+      stop();
+      producer = std::thread([this, blocks, interval]() {
+         for (uint64_t i = 0; i < blocks; i++) {
+            std::this_thread::sleep_for(interval);
+            head++;
+         }
+      });
+   }
+
+   void stop() {
+      if (producer.joinable())
+         producer.join();
+   }
+
+   std::string fetch(uint64_t block_num) {
+      std::this_thread::sleep_for(std::chrono::microseconds(block_num % 7 * 100));
+      if (block_num > head)
+         return "";
+      std::lock_guard<std::mutex> lock(failed_mutex);
+      if (block_num % 13 == 0 && failed.insert(block_num).second)
+         throw std::runtime_error("connection reset");
+      if (block_num % 17 == 0 && failed.insert(block_num).second)
+         return "";
+      return "block " + std::to_string(block_num);
+   }
+
+   std::atomic<uint64_t> head;
+
+private:
+   std::thread producer;
+   std::mutex failed_mutex;
+   std::set<uint64_t> failed;
+};
+
+/// Polls the way the net handlers do until the listener reached the head of a node that stopped producing
+void poll_until_synced(block_listener &listener, mock_node &node) {
+   for (int i = 0; i < 10000; i++) {
+      listener.catch_up(node.head);
+      if (listener.get_last_handled_block() == node.head)
+         break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+   }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(block_listener_tests)
+
+BOOST_AUTO_TEST_CASE(handles_every_block_once_in_order) {
+   fc::temp_directory dir(graphene::utilities::temp_directory_path());
+   const fc::path state_file = dir.path() / "last_block";
+
+   mock_node node(100);
+   std::vector<uint64_t> handled;
+   const auto handle = [&](uint64_t block_num, const std::string &block) {
+      BOOST_CHECK_EQUAL(block, "block " + std::to_string(block_num));
+      handled.push_back(block_num);
+   };
+
+   {
+      block_listener listener("test", state_file, std::bind(&mock_node::fetch, &node, std::placeholders::_1), handle);
+      listener.start_after(100);
+
+      // blocks come faster than the listener polls, several arrive between two catch ups
+      node.produce(300, std::chrono::microseconds(500));
+      while (node.head < 400) {
+         listener.catch_up(node.head);
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+      node.stop();
+      poll_until_synced(listener, node);
+      BOOST_CHECK_EQUAL(listener.get_last_handled_block(), 400u);
+   }
+
+   // a restarted listener resumes after the last handled block, start_after does not move it back
+   node.produce(50, std::chrono::microseconds(0));
+   node.stop();
+   {
+      block_listener listener("test", state_file, std::bind(&mock_node::fetch, &node, std::placeholders::_1), handle);
+      BOOST_CHECK_EQUAL(listener.get_last_handled_block(), 400u);
+      listener.start_after(440);
+      poll_until_synced(listener, node);
+      BOOST_CHECK_EQUAL(listener.get_last_handled_block(), 450u);
+   }
+
+   BOOST_REQUIRE_EQUAL(handled.size(), 350u);
+   for (size_t i = 0; i < handled.size(); i++)
+      BOOST_CHECK_EQUAL(handled[i], 101 + i);
+}
+
+BOOST_AUTO_TEST_CASE(skips_block_the_handler_rejects) {
+   fc::temp_directory dir(graphene::utilities::temp_directory_path());
+
+   std::vector<uint64_t> handled;
+   block_listener listener(
+         "test", dir.path() / "last_block",
+         [](uint64_t block_num) {
+            return std::to_string(block_num);
+         },
+         [&](uint64_t block_num, const std::string &) {
+            if (block_num == 3)
+               throw std::runtime_error("malformed block");
+            handled.push_back(block_num);
+         },
+         2, 3);
+
+   // without a saved block the listener starts at the head
+   BOOST_CHECK_EQUAL(listener.catch_up(1), 1u);
+   // at most max_blocks_per_catch_up blocks are handled per call
+   BOOST_CHECK_EQUAL(listener.catch_up(10), 3u);
+   BOOST_CHECK_EQUAL(listener.get_last_handled_block(), 4u);
+   BOOST_CHECK_EQUAL(listener.catch_up(4), 0u);
+
+   BOOST_CHECK((handled == std::vector<uint64_t>{1, 2, 4}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
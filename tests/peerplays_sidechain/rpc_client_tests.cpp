@@ -0,0 +1,219 @@
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <graphene/peerplays_sidechain/common/rpc_client.hpp>
+
+using namespace graphene::peerplays_sidechain;
+
+namespace {
+
+/// JSON-RPC server on localhost which answers every call with its method name
+class mock_rpc_server {
+public:
+   enum class close_mode {
+      keep_alive,    // keeps the connection open
+      announce,      // answers with Connection: close
+      drop_silently, // closes the connection without announcing it, like an idle timeout
+   };
+
+   explicit mock_rpc_server(close_mode _mode = close_mode::keep_alive) :
+         mode(_mode),
+         acceptor(ioc, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+      accept_thread = std::thread([this] {
+         accept_loop();
+      });
+   }
+
+   ~mock_rpc_server() {
+      stopping = true;
+      // wake up the blocking accept
+      boost::asio::io_context wake_ioc;
+      boost::asio::ip::tcp::socket socket(wake_ioc);
+      boost::system::error_code ec;
+      socket.connect(acceptor.local_endpoint(), ec);
+      accept_thread.join();
+      for (auto &t : session_threads)
+         t.join();
+   }
+
+   std::string url() const {
+      return "http://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port());
+   }
+
+   std::atomic<uint32_t> accepted{0};
+   std::atomic<uint32_t> posts{0};
+
+private:
+   void accept_loop() {
+      while (true) {
+         boost::asio::ip::tcp::socket socket(ioc);
+         acceptor.accept(socket);
+         if (stopping)
+            return;
+         accepted++;
+         session_threads.emplace_back([this](boost::asio::ip::tcp::socket s) {
+            serve(std::move(s));
+         },
+                                      std::move(socket));
+      }
+   }
+
+   void serve(boost::asio::ip::tcp::socket socket) {
+      boost::beast::flat_buffer buffer;
+      boost::system::error_code ec;
+      while (true) {
+         boost::beast::http::request<boost::beast::http::string_body> req;
+         boost::beast::http::read(socket, buffer, req, ec);
+         if (ec)
+            return;
+         posts++;
+
+         boost::beast::http::response<boost::beast::http::string_body> res{boost::beast::http::status::ok, 11};
+         res.set(boost::beast::http::field::content_type, "application/json");
+         res.keep_alive(mode != close_mode::announce);
+         res.body() = reply_to(req.body());
+         res.prepare_payload();
+         boost::beast::http::write(socket, res, ec);
+         if (ec || mode != close_mode::keep_alive) {
+            socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+            return;
+         }
+      }
+   }
+
+   static std::string reply_to(const std::string &body) {
+      std::stringstream ss(body);
+      boost::property_tree::ptree json;
+      boost::property_tree::read_json(ss, json);
+      if (json.count("method"))
+         return reply_to_call(json);
+
+      // answer the calls of a batch in reverse order, replies are matched by id
+      std::string result = "[";
+      for (auto itr = json.rbegin(); itr != json.rend(); ++itr)
+         result += (itr == json.rbegin() ? "" : ",") + reply_to_call(itr->second);
+      return result + "]";
+   }
+
+   static std::string reply_to_call(const boost::property_tree::ptree &call) {
+      return "{\"jsonrpc\":\"2.0\",\"id\":" + call.get<std::string>("id") +
+             ",\"result\":\"" + call.get<std::string>("method") + "\",\"error\":null}";
+   }
+
+   const close_mode mode;
+   std::atomic<bool> stopping{false};
+   boost::asio::io_context ioc;
+   boost::asio::ip::tcp::acceptor acceptor;
+   std::thread accept_thread;
+   std::vector<std::thread> session_threads;
+};
+
+class test_rpc_client : public rpc_client {
+public:
+   test_rpc_client(const std::string &url) :
+         rpc_client(sidechain_type::bitcoin, {rpc_credentials{url, "user", "password"}}, false, false) {
+   }
+
+   std::string call(const std::string &method) {
+      return retrieve_value_from_reply(send_post_request(method, "[]", false), "");
+   }
+
+   using rpc_client::send_batch_request;
+
+   virtual uint64_t ping(rpc_connection &conn) const override {
+      return 0;
+   }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(rpc_client_tests)
+
+BOOST_AUTO_TEST_CASE(keep_alive_reuses_connection) {
+   mock_rpc_server server;
+   {
+      test_rpc_client client(server.url());
+      for (int i = 0; i < 10; i++)
+         BOOST_CHECK_EQUAL(client.call("getblockcount"), "getblockcount");
+
+      const auto metrics = client.get_connection_metrics();
+      BOOST_REQUIRE_EQUAL(metrics.size(), 1u);
+      BOOST_CHECK_EQUAL(metrics[0].requests, 10u);
+      BOOST_CHECK_EQUAL(metrics[0].failures, 0u);
+      BOOST_CHECK_EQUAL(metrics[0].connects, 1u);
+   }
+   BOOST_CHECK_EQUAL(server.accepted.load(), 1u);
+   BOOST_CHECK_EQUAL(server.posts.load(), 10u);
+}
+
+BOOST_AUTO_TEST_CASE(reconnects_when_server_closes) {
+   mock_rpc_server announcing(mock_rpc_server::close_mode::announce);
+   {
+      test_rpc_client client(announcing.url());
+      for (int i = 0; i < 3; i++)
+         BOOST_CHECK_EQUAL(client.call("getblockcount"), "getblockcount");
+      BOOST_CHECK_EQUAL(client.get_connection_metrics()[0].failures, 0u);
+   }
+   BOOST_CHECK_EQUAL(announcing.accepted.load(), 3u);
+
+   // the request written to the closed connection fails on read, and is sent again on a new one
+   mock_rpc_server dropping(mock_rpc_server::close_mode::drop_silently);
+   {
+      test_rpc_client client(dropping.url());
+      for (int i = 0; i < 3; i++)
+         BOOST_CHECK_EQUAL(client.call("getblockcount"), "getblockcount");
+      BOOST_CHECK_EQUAL(client.get_connection_metrics()[0].failures, 0u);
+      BOOST_CHECK_EQUAL(client.get_connection_metrics()[0].connects, 3u);
+   }
+   BOOST_CHECK_EQUAL(dropping.accepted.load(), 3u);
+   BOOST_CHECK_EQUAL(dropping.posts.load(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(batch_request) {
+   mock_rpc_server server;
+   {
+      test_rpc_client client(server.url());
+      std::vector<rpc_request> requests;
+      for (const auto &method : {"getblockcount", "getblockhash", "getblock", "getrawtransaction"})
+         requests.push_back(rpc_request{method, "[]"});
+
+      const auto replies = client.send_batch_request(requests, false);
+      BOOST_REQUIRE_EQUAL(replies.size(), requests.size());
+      for (size_t i = 0; i < requests.size(); i++) {
+         std::stringstream ss(replies[i]);
+         boost::property_tree::ptree json;
+         boost::property_tree::read_json(ss, json);
+         BOOST_CHECK_EQUAL(json.get<std::string>("result"), requests[i].method);
+      }
+
+      BOOST_CHECK(client.send_batch_request({}, false).empty());
+   }
+   BOOST_CHECK_EQUAL(server.posts.load(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(failures_are_counted) {
+   uint16_t closed_port;
+   {
+      mock_rpc_server server;
+      const std::string url = server.url();
+      closed_port = std::stoi(url.substr(url.rfind(':') + 1));
+   }
+   test_rpc_client client("http://127.0.0.1:" + std::to_string(closed_port));
+   BOOST_CHECK_EQUAL(client.call("getblockcount"), "");
+
+   const auto metrics = client.get_connection_metrics();
+   BOOST_CHECK_EQUAL(metrics[0].requests, 1u);
+   BOOST_CHECK_EQUAL(metrics[0].failures, 1u);
+   BOOST_CHECK_EQUAL(metrics[0].recent_latency, 5u * 1000 * 1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -29,6 +29,7 @@
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
+#include <graphene/chain/worker_pool.hpp>
 
 #include <graphene/db/simple_index.hpp>
 
@@ -50,6 +51,42 @@ BOOST_AUTO_TEST_CASE( sigcheck_benchmark )
    auto end = fc::time_point::now();
    auto elapsed = end-start;
    wdump( ((100000.0*1000000.0) / elapsed.count()) );
+
+   // recover the keys of a block worth of transactions serially and on the precompute worker pool
+   const chain_id_type chain_id = fc::sha256::hash("sigcheck");
+   const uint32_t trx_count = 2000;
+   signed_block block;
+   for( uint32_t i = 0; i < trx_count; ++i )
+   {
+      signed_transaction trx;
+      trx.ref_block_num = i;
+      trx.sign( nathan_key, chain_id );
+      block.transactions.push_back( trx );
+   }
+   auto clear_signees = [&block]() {
+      for( const auto& trx : block.transactions )
+         trx.signees.clear();
+   };
+
+   start = fc::time_point::now();
+   for( const auto& trx : block.transactions )
+      trx.get_signature_keys( chain_id );
+   const auto serial = fc::time_point::now() - start;
+
+   clear_signees();
+   worker_pool pool( std::max( 1u, std::thread::hardware_concurrency() ) );
+   start = fc::time_point::now();
+   pool.run_chunked( block.transactions.size(), [&block, &chain_id]( size_t begin, size_t end ) {
+      for( size_t i = begin; i < end; ++i )
+         block.transactions[i].get_signature_keys( chain_id );
+   });
+   const auto parallel = fc::time_point::now() - start;
+   for( const auto& trx : block.transactions )
+      BOOST_CHECK_EQUAL( trx.signees.size(), 1u );
+
+   ilog( "Recovered ${n} transaction keys serially in ${s} us, with ${t} threads in ${p} us, speedup ${x}",
+         ("n", trx_count)("s", serial.count())("t", pool.size() + 1)("p", parallel.count())
+         ("x", double(serial.count()) / std::max<int64_t>( 1, parallel.count() )) );
 }
 /*
 BOOST_AUTO_TEST_CASE( transfer_benchmark )
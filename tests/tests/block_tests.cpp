@@ -35,6 +35,8 @@
 #include <graphene/chain/witness_schedule_object.hpp>
 #include <graphene/chain/witness_object.hpp>
 
+#include <graphene/net/core_messages.hpp>
+
 #include <graphene/utilities/tempdir.hpp>
 
 #include <fc/crypto/digest.hpp>
@@ -95,6 +97,14 @@ BOOST_AUTO_TEST_CASE( block_database_test )
          fetch = bdb.fetch_optional( b.id() );
          FC_ASSERT( fetch.valid() );
          FC_ASSERT( fetch->witness ==  b.witness );
+
+         auto packed = bdb.fetch_packed( b.id() );
+         FC_ASSERT( packed.valid() );
+         FC_ASSERT( std::vector<char>( packed->data, packed->data + packed->size ) == fc::raw::pack( b ) );
+
+         graphene::net::message msg = graphene::net::packed_block_message( packed->data, packed->size, packed->id );
+         FC_ASSERT( msg.data == graphene::net::message( graphene::net::block_message( b ) ).data );
+         FC_ASSERT( graphene::net::block_id_of_message( msg ) == b.id() );
       }
 
       for( uint32_t i = 1; i < 5; ++i )
@@ -1519,4 +1529,55 @@ BOOST_FIXTURE_TEST_CASE( miss_many_blocks, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( compact_block_relay, database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      for( int i = 0; i < 5; ++i )
+         transfer( account_id_type(), i % 2 ? alice_id : bob_id, asset( 1000 + i ) );
+      signed_block b = generate_block();
+      BOOST_REQUIRE_GE( b.transactions.size(), 5u );
+
+      const graphene::net::message full_message = graphene::net::block_message( b );
+      const graphene::net::compact_block_message compact( graphene::net::block_message( b ), full_message.id() );
+      BOOST_CHECK( compact.block_id == b.id() );
+      BOOST_REQUIRE_EQUAL( compact.transactions.size(), b.transactions.size() );
+
+      // the short ids are those of the trx_messages the transactions were relayed in
+      std::vector<signed_transaction> transactions( b.transactions.begin(), b.transactions.end() );
+      std::set<uint64_t> short_ids;
+      for( size_t i = 0; i < transactions.size(); ++i )
+      {
+         graphene::net::message trx_msg = graphene::net::trx_message( transactions[i] );
+         BOOST_CHECK_EQUAL( compact.transactions[i].short_id, graphene::net::short_transaction_id( trx_msg.id() ) );
+         short_ids.insert( compact.transactions[i].short_id );
+      }
+      BOOST_CHECK_EQUAL( short_ids.size(), transactions.size() );
+
+      // a compact block is much smaller than the block
+      const graphene::net::message compact_message = compact;
+      BOOST_CHECK_LT( compact_message.size, full_message.size );
+
+      // the same transactions rebuild the block message exactly
+      graphene::net::message rebuilt = graphene::net::block_message_from_compact( compact, transactions );
+      BOOST_CHECK( rebuilt.data == full_message.data );
+      BOOST_CHECK( rebuilt.id() == compact.block_message_hash );
+
+      // another transaction under a short id, e.g. with other signatures, gives another hash
+      transactions[3].signatures.push_back( signature_type() );
+      BOOST_CHECK( graphene::net::block_message_from_compact( compact, transactions ).id() != compact.block_message_hash );
+      std::swap( transactions[0], transactions[1] );
+      BOOST_CHECK( graphene::net::block_message_from_compact( compact, transactions ).id() != compact.block_message_hash );
+
+      transactions.pop_back();
+      BOOST_CHECK_THROW( graphene::net::block_message_from_compact( compact, transactions ), fc::exception );
+   }
+   catch( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
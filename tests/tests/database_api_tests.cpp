@@ -24,7 +24,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <set>
+
 #include <graphene/app/database_api.hpp>
+#include <graphene/app/api.hpp>
+#include <graphene/market_history/market_history_plugin.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -68,4 +72,207 @@ BOOST_FIXTURE_TEST_SUITE(database_api_tests, database_fixture)
       } FC_LOG_AND_RETHROW()
   }
 
+  BOOST_AUTO_TEST_CASE(get_ticker) {
+      try {
+          ACTORS((seller)(buyer));
+          const asset_object& test_asset = create_user_issued_asset("TICKER");
+          const asset_object& core_asset = asset_id_type()(db);
+          issue_uia(seller, asset(10000, test_asset.id));
+          transfer(committee_account, buyer_id, asset(100000));
+
+          create_sell_order(seller_id, asset(1000, test_asset.id), asset(2000));
+          create_sell_order(buyer_id, asset(2000), asset(1000, test_asset.id));
+          generate_block();
+
+          graphene::app::database_api db_api(db);
+          const double test_volume = 1000 / pow(10, test_asset.precision);
+          const double core_volume = 2000 / pow(10, core_asset.precision);
+
+          auto ticker = db_api.get_ticker("TICKER", core_asset.symbol);
+          BOOST_CHECK_CLOSE(ticker.base_volume, test_volume, 0.0001);
+          BOOST_CHECK_CLOSE(ticker.quote_volume, core_volume, 0.0001);
+          BOOST_CHECK_CLOSE(ticker.latest, test_volume / core_volume, 0.0001);
+
+          auto inverted = db_api.get_24_volume(core_asset.symbol, "TICKER");
+          BOOST_CHECK_CLOSE(inverted.base_volume, core_volume, 0.0001);
+          BOOST_CHECK_CLOSE(inverted.quote_volume, test_volume, 0.0001);
+
+          // the trade leaves the 24 hour window, the latest price stays
+          generate_blocks(db.head_block_time() + fc::days(1) + fc::minutes(1));
+          ticker = db_api.get_ticker("TICKER", core_asset.symbol);
+          BOOST_CHECK_EQUAL(ticker.base_volume, 0);
+          BOOST_CHECK_EQUAL(ticker.quote_volume, 0);
+          BOOST_CHECK_CLOSE(ticker.latest, test_volume / core_volume, 0.0001);
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_AUTO_TEST_CASE(flush_writes_replayed_buckets) {
+      try {
+          ACTORS((seller)(buyer));
+          const asset_object& test_asset = create_user_issued_asset("REPLAY");
+          issue_uia(seller, asset(10000, test_asset.id));
+          transfer(committee_account, buyer_id, asset(100000));
+          generate_block();
+
+          const auto& buckets = db.get_index_type<graphene::market_history::bucket_index>().indices();
+          BOOST_CHECK(buckets.empty());
+
+          // blocks applied without undo history are irreversible, as while reindexing, so their buckets are batched
+          db._undo_db.disable();
+          create_sell_order(seller_id, asset(1000, test_asset.id), asset(2000));
+          create_sell_order(buyer_id, asset(2000), asset(1000, test_asset.id));
+          generate_block();
+          BOOST_CHECK(buckets.empty());
+
+          // the periodic flush of a reindex saves a state which must already contain them
+          db.flush();
+          BOOST_CHECK_EQUAL(buckets.size(), 5u);
+          for( const auto& b : buckets )
+          {
+             BOOST_CHECK_EQUAL(b.base_volume.value, 2000);
+             BOOST_CHECK_EQUAL(b.quote_volume.value, 1000);
+          }
+          db._undo_db.enable();
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_AUTO_TEST_CASE(get_asset_holders) {
+      try {
+          ACTORS((alice)(bob)(carol)(dan));
+          const asset_object& hold = create_user_issued_asset("HOLD");
+          issue_uia(alice, asset(400, hold.id));
+          issue_uia(bob, asset(300, hold.id));
+          issue_uia(carol, asset(200, hold.id));
+          issue_uia(dan, asset(100, hold.id));
+          transfer(committee_account, dan_id, asset(100000));
+          // dan keeps a zero balance, which is not listed
+          transfer(dan_id, alice_id, asset(100, hold.id));
+          generate_block();
+
+          graphene::app::asset_api asset_api(app);
+
+          auto holders = asset_api.get_asset_holders("HOLD", 0, 100);
+          BOOST_REQUIRE_EQUAL(holders.size(), 3u);
+          BOOST_CHECK(holders[0].account_id == alice_id);
+          BOOST_CHECK_EQUAL(holders[0].amount.value, 500);
+          BOOST_CHECK(holders[1].account_id == bob_id);
+          BOOST_CHECK(holders[2].account_id == carol_id);
+
+          holders = asset_api.get_asset_holders("HOLD", 1, 1);
+          BOOST_REQUIRE_EQUAL(holders.size(), 1u);
+          BOOST_CHECK(holders[0].account_id == bob_id);
+
+          holders = asset_api.get_asset_holders("HOLD", 2, 100);
+          BOOST_REQUIRE_EQUAL(holders.size(), 1u);
+          BOOST_CHECK(holders[0].account_id == carol_id);
+
+          BOOST_CHECK(asset_api.get_asset_holders("HOLD", 3, 100).empty());
+          BOOST_CHECK(asset_api.get_asset_holders("HOLD", 1000, 100).empty());
+
+          // the count keeps its original definition, all balance objects of the asset less one
+          BOOST_CHECK_EQUAL(asset_api.get_asset_holders_count("HOLD"), 3);
+      } FC_LOG_AND_RETHROW()
+  }
+
+  /// Collects the ids of the objects in the updates passed to a subscribe callback
+  static std::function<void(const variant&)> collect_ids(std::set<object_id_type>& ids) {
+      return [&ids](const variant& updates) {
+          for (const variant& update : updates.get_array())
+              ids.insert(update.is_object() ? update["id"].as<object_id_type>(1) : update.as<object_id_type>(1));
+      };
+  }
+
+  BOOST_AUTO_TEST_CASE(subscriptions_notify) {
+      try {
+          ACTORS((alice)(bob));
+          const asset_object& test_asset = create_user_issued_asset("SUBS");
+          issue_uia(alice, asset(10000, test_asset.id));
+          transfer(committee_account, alice_id, asset(100000));
+          transfer(committee_account, bob_id, asset(100000));
+          generate_block();
+
+          // an object subscription
+          std::set<object_id_type> object_updates;
+          graphene::app::database_api object_api(db);
+          object_api.set_subscribe_callback(collect_ids(object_updates), false);
+          object_api.get_objects({dynamic_global_property_id_type()});
+
+          // an account subscription
+          std::set<object_id_type> account_updates;
+          graphene::app::database_api account_api(db);
+          account_api.set_subscribe_callback(collect_ids(account_updates), false);
+          account_api.get_full_accounts({"bob"}, true);
+
+          // a market subscription
+          uint32_t market_updates = 0;
+          graphene::app::database_api market_api(db);
+          market_api.subscribe_to_market([&market_updates](const variant&) { ++market_updates; },
+                                         "SUBS", asset_id_type()(db).symbol);
+
+          // pending transactions are passed on at once
+          uint32_t pending_transactions = 0;
+          graphene::app::database_api pending_api(db);
+          pending_api.set_pending_transaction_callback([&pending_transactions](const variant&) { ++pending_transactions; });
+
+          transfer(alice_id, bob_id, asset(1000));
+          create_sell_order(alice_id, asset(1000, test_asset.id), asset(2000));
+          BOOST_CHECK_EQUAL(pending_transactions, 2u);
+
+          generate_block();
+          fc::usleep(fc::milliseconds(200)); // sleep a while to execute callbacks in another thread
+
+          BOOST_CHECK(object_updates.count(dynamic_global_property_id_type()));
+          const auto& balances = db.get_index_type<account_balance_index>().indices().get<by_account_asset>();
+          const object_id_type bob_balance = balances.find(boost::make_tuple(bob_id, asset_id_type()))->id;
+          BOOST_CHECK(account_updates.count(bob_balance));
+          BOOST_CHECK_GT(market_updates, 0u);
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_AUTO_TEST_CASE(unsubscribed_objects_do_not_notify) {
+      try {
+          ACTORS((alice)(bob));
+          const asset_object& test_asset = create_user_issued_asset("UNSUBS");
+          issue_uia(alice, asset(10000, test_asset.id));
+          transfer(committee_account, alice_id, asset(100000));
+          generate_block();
+
+          // subscribed to alice only, who is not touched below
+          std::set<object_id_type> object_updates;
+          graphene::app::database_api object_api(db);
+          object_api.set_subscribe_callback(collect_ids(object_updates), false);
+          object_api.get_objects({alice_id});
+
+          uint32_t market_updates = 0;
+          graphene::app::database_api market_api(db);
+          market_api.subscribe_to_market([&market_updates](const variant&) { ++market_updates; },
+                                         "UNSUBS", asset_id_type()(db).symbol);
+          market_api.unsubscribe_from_market("UNSUBS", asset_id_type()(db).symbol);
+
+          uint32_t pending_transactions = 0;
+          graphene::app::database_api pending_api(db);
+          pending_api.set_pending_transaction_callback([&pending_transactions](const variant&) { ++pending_transactions; });
+          pending_api.set_pending_transaction_callback(std::function<void(const variant&)>());
+
+          transfer(committee_account, bob_id, asset(1000));
+          create_sell_order(alice_id, asset(1000, test_asset.id), asset(2000));
+          generate_block();
+          fc::usleep(fc::milliseconds(200)); // sleep a while to execute callbacks in another thread
+
+          BOOST_CHECK(!object_updates.count(dynamic_global_property_id_type()));
+          const auto& balances = db.get_index_type<account_balance_index>().indices().get<by_account_asset>();
+          BOOST_CHECK(!object_updates.count(balances.find(boost::make_tuple(bob_id, asset_id_type()))->id));
+          BOOST_CHECK_EQUAL(market_updates, 0u);
+          BOOST_CHECK_EQUAL(pending_transactions, 0u);
+
+          // after cancelling, even the subscribed objects do not notify anymore
+          object_api.get_objects({dynamic_global_property_id_type()});
+          object_api.cancel_all_subscriptions();
+          object_updates.clear();
+          generate_block();
+          fc::usleep(fc::milliseconds(200));
+          BOOST_CHECK(object_updates.empty());
+      } FC_LOG_AND_RETHROW()
+  }
+
 BOOST_AUTO_TEST_SUITE_END()
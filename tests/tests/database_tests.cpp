@@ -27,9 +27,14 @@
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
 
 #include <fc/crypto/digest.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -81,6 +86,128 @@ BOOST_AUTO_TEST_CASE( merge_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( undo_id_table_test )
+{
+   graphene::db::undo_id_table<uint64_t> table;
+   std::map<uint64_t, uint64_t> expected;
+   uint64_t seed = 1;
+   for( uint32_t i = 0; i < 20000; ++i )
+   {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      object_id_type id( 1, uint8_t( (seed >> 60) & 3 ), (seed >> 33) % 512 );
+      if( (seed >> 20) % 3 == 0 )
+         BOOST_CHECK_EQUAL( table.erase( id ), expected.erase( id.number ) > 0 );
+      else
+      {
+         *table.insert( id ).first = i;
+         expected[id.number] = i;
+      }
+      if( i % 1000 == 0 )
+      {
+         table.clear();
+         expected.clear();
+      }
+   }
+   BOOST_CHECK_EQUAL( table.size(), expected.size() );
+   size_t seen = 0;
+   for( const auto& entry : table )
+   {
+      BOOST_REQUIRE( expected.count( entry.id.number ) );
+      BOOST_CHECK_EQUAL( entry.value, expected[entry.id.number] );
+      ++seen;
+   }
+   BOOST_CHECK_EQUAL( seen, expected.size() );
+}
+
+BOOST_AUTO_TEST_CASE( undo_nested_merge_test )
+{
+   try {
+      database db;
+      const auto& kept = db.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 1; } );
+      const auto& removed = db.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 2; } );
+      const object_id_type kept_id = kept.id;
+      const object_id_type removed_id = removed.id;
+
+      auto outer = db._undo_db.start_undo_session( true );
+      for( int i = 0; i < 100; ++i )
+      {
+         auto inner = db._undo_db.start_undo_session();
+         db.modify( kept, []( account_balance_object& obj ){ obj.balance += 10; } );
+         db.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 3; } );
+         if( i == 50 )
+         {
+            db.modify( removed, []( account_balance_object& obj ){ obj.balance = 20; } );
+            db.remove( removed );
+         }
+         inner.merge();
+      }
+      BOOST_CHECK_EQUAL( kept.balance.value, 1001 );
+      BOOST_CHECK( db.find_object( removed_id ) == nullptr );
+
+      outer.undo();
+      BOOST_CHECK_EQUAL( db.get<account_balance_object>( kept_id ).balance.value, 1 );
+      BOOST_REQUIRE( db.find_object( removed_id ) != nullptr );
+      BOOST_CHECK_EQUAL( db.get<account_balance_object>( removed_id ).balance.value, 2 );
+      BOOST_CHECK_EQUAL( db.get_index_type<account_balance_index>().indices().size(), 2u );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( object_change_filter_test )
+{ try {
+   ACTORS( (alice) );
+   generate_block();
+
+   vector<object_changes> balances_only;
+   object_change_filter balance_filter;
+   balance_filter.add_type<account_balance_object>();
+   balance_filter.impacted_accounts = false;
+   uint64_t balances_subscription = db.subscribe_object_changes( balance_filter, [&]( const object_changes& c ) {
+      balances_only.push_back( c );
+   });
+
+   vector<object_changes> everything;
+   uint64_t everything_subscription = db.subscribe_object_changes( object_change_filter(), [&]( const object_changes& c ) {
+      everything.push_back( c );
+   });
+
+   transfer( committee_account, alice_id, asset( 1000 ) );
+   generate_block();
+
+   BOOST_REQUIRE( !balances_only.empty() );
+   for( const auto& c : balances_only )
+   {
+      for( const auto& id : c.new_ids )
+         BOOST_CHECK( id.is<account_balance_object>() );
+      for( const auto& id : c.changed_ids )
+         BOOST_CHECK( id.is<account_balance_object>() );
+      BOOST_CHECK( c.new_accounts_impacted.empty() );
+      BOOST_CHECK( c.changed_accounts_impacted.empty() );
+   }
+
+   BOOST_REQUIRE( !everything.empty() );
+   bool alice_impacted = false;
+   for( const auto& c : everything )
+      alice_impacted |= c.new_accounts_impacted.count( alice_id ) || c.changed_accounts_impacted.count( alice_id );
+   BOOST_CHECK( alice_impacted );
+
+   // disabled and removed subscribers are not called any more
+   object_change_filter disabled;
+   disabled.enabled = false;
+   db.set_object_change_filter( balances_subscription, disabled );
+   db.unsubscribe_object_changes( everything_subscription );
+   balances_only.clear();
+   everything.clear();
+   transfer( committee_account, alice_id, asset( 1000 ) );
+   generate_block();
+   BOOST_CHECK( balances_only.empty() );
+   BOOST_CHECK( everything.empty() );
+   db.unsubscribe_object_changes( balances_subscription );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( flat_index_test )
 {
    ACTORS((sam));
@@ -195,4 +322,180 @@ BOOST_AUTO_TEST_CASE( direct_index_test )
    // but the secondary has not updated its representation
 } FC_LOG_AND_RETHROW() }
 
+
+BOOST_AUTO_TEST_CASE( incremental_checkpoint_test )
+{ try {
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   const fc::path segments = data_dir.path() / "object_database.delta";
+   account_id_type alice_id, bob_id, dave_id;
+
+   {
+      graphene::db::object_database odb;
+      odb.add_index< graphene::db::primary_index< account_index > >();
+      odb.open( data_dir.path() );
+      alice_id = odb.create<account_object>( []( account_object& a ) { a.name = "alice"; } ).id;
+      bob_id = odb.create<account_object>( []( account_object& a ) { a.name = "bob"; } ).id;
+      odb.flush(); // complete state
+      BOOST_CHECK( !fc::exists( segments ) );
+
+      odb.modify( alice_id(odb), []( account_object& a ) { a.name = "carol"; } );
+      odb.remove( bob_id(odb) );
+      dave_id = odb.create<account_object>( []( account_object& a ) { a.name = "dave"; } ).id;
+      odb.flush(); // only the three changed objects
+      BOOST_CHECK( fc::exists( segments / "1" ) );
+      odb.flush(); // nothing changed
+      BOOST_CHECK( !fc::exists( segments / "2" ) );
+      odb.close();
+   }
+
+   auto check_state = [&]( graphene::db::object_database& odb ) {
+      BOOST_CHECK_EQUAL( alice_id(odb).name, "carol" );
+      BOOST_CHECK( odb.find( bob_id ) == nullptr );
+      BOOST_CHECK_EQUAL( dave_id(odb).name, "dave" );
+      BOOST_CHECK( odb.get_index<account_object>().get_next_id() == object_id_type( dave_id ) + 1 );
+   };
+
+   {
+      graphene::db::object_database odb;
+      odb.add_index< graphene::db::primary_index< account_index > >();
+      odb.open( data_dir.path() );
+      check_state( odb );
+
+      // the second segment triggers merging both into the complete state
+      odb.set_max_checkpoint_segments( 2 );
+      odb.modify( dave_id(odb), []( account_object& a ) { a.name = "dave"; } );
+      odb.flush();
+      odb.close();
+      BOOST_CHECK( !fc::exists( segments / "1" ) );
+      BOOST_CHECK( !fc::exists( segments / "2" ) );
+   }
+
+   {
+      graphene::db::object_database odb;
+      odb.add_index< graphene::db::primary_index< account_index > >();
+      odb.open( data_dir.path() );
+      check_state( odb );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( apply_metrics_test )
+{ try {
+   latency_histogram histogram;
+   for( uint64_t ns = 1; ns <= 1000; ++ns )
+      histogram.record( ns );
+   BOOST_CHECK_EQUAL( histogram.count(), 1000u );
+   BOOST_CHECK_GE( histogram.percentile( 0.5 ), 500u );
+   BOOST_CHECK_LE( histogram.percentile( 0.5 ), 500u + 500u / 8 );
+   BOOST_CHECK_EQUAL( histogram.percentile( 1.0 ), 1000u );
+
+   BOOST_CHECK( db.get_apply_metrics().report().operations.empty() );
+   db.enable_apply_metrics( true );
+
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 ) );
+   generate_block();
+
+   apply_metrics_report report = db.get_apply_metrics().report();
+   BOOST_CHECK( report.enabled );
+   auto transfers = std::find_if( report.operations.begin(), report.operations.end(),
+                                  []( const apply_latency_stats& s ) { return s.name == "transfer_operation"; } );
+   BOOST_REQUIRE( transfers != report.operations.end() );
+   BOOST_CHECK_GE( transfers->count, 1u );
+   BOOST_CHECK_LE( transfers->p50_ns, transfers->p99_ns );
+   BOOST_CHECK_LE( transfers->p99_ns, transfers->max_ns );
+   BOOST_CHECK_LE( transfers->max_ns, transfers->total_ns );
+   auto blocks = std::find_if( report.phases.begin(), report.phases.end(),
+                               []( const apply_latency_stats& s ) { return s.name == "block"; } );
+   BOOST_REQUIRE( blocks != report.phases.end() );
+   BOOST_CHECK_GE( blocks->count, 1u );
+
+   db.enable_apply_metrics( false );
+   db.get_apply_metrics().reset();
+   generate_block();
+   BOOST_CHECK( db.get_apply_metrics().report().phases.empty() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( read_write_gate_test )
+{ try {
+   read_write_gate gate;
+   {
+      // the writer may enter again and read without waiting for itself
+      read_write_gate::write_guard outer( gate );
+      read_write_gate::write_guard inner( gate );
+      read_write_gate::read_guard read( gate );
+   }
+
+   std::atomic<bool> reader_done( false );
+   std::thread reader;
+   {
+      read_write_gate::write_guard write( gate );
+      reader = std::thread( [&]() {
+         read_write_gate::read_guard read( gate );
+         reader_done = true;
+      });
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+      BOOST_CHECK( !reader_done );
+   }
+   reader.join();
+   BOOST_CHECK( reader_done );
+
+   db.set_read_threads( 2 );
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 ) );
+   std::thread::id read_thread;
+   share_type balance;
+   db.run_read( [&]() {
+      read_thread = std::this_thread::get_id();
+      balance = db.get_balance( alice_id, asset_id_type() ).amount;
+   });
+   BOOST_CHECK( read_thread != std::this_thread::get_id() );
+   BOOST_CHECK_EQUAL( balance.value, 1000 );
+   generate_block();
+   db.set_read_threads( 0 );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( read_write_gate_preemption_test )
+{ try {
+   read_write_gate gate;
+   // outside of a read the check never throws
+   gate.check_preempted();
+
+   std::atomic<bool> reading( false );
+   std::atomic<uint32_t> attempts( 0 );
+   std::thread reader( [&]() {
+      while( true )
+      {
+         try
+         {
+            read_write_gate::read_guard read( gate );
+            // the first attempt is a read of 100 s, checking for writers between its steps
+            const uint32_t steps = ++attempts == 1 ? 100000 : 0;
+            reading = true;
+            for( uint32_t i = 0; i < steps; ++i )
+            {
+               gate.check_preempted();
+               std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+            }
+            return;
+         }
+         catch( const read_preempted_exception& )
+         {
+         }
+      }
+   });
+   while( !reading )
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+   // the writer only waits for the reader to reach its next check
+   const auto start = std::chrono::steady_clock::now();
+   {
+      read_write_gate::write_guard write( gate );
+      BOOST_CHECK_EQUAL( attempts.load(), 1u );
+   }
+   BOOST_CHECK( std::chrono::steady_clock::now() - start < std::chrono::seconds( 10 ) );
+   reader.join();
+   // the preempted read ran again after the write
+   BOOST_CHECK_EQUAL( attempts.load(), 2u );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -602,4 +602,86 @@ BOOST_AUTO_TEST_CASE(get_account_history_operations) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(get_account_history_operations_by_type) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      int transfer_op_id = operation::tag<transfer_operation>::value;
+      int account_create_op_id = operation::tag<account_create_operation>::value;
+
+      // transfers of the committee account interleaved with other operations
+      const account_id_type sam_id = create_account("sam").id;
+      for (int i = 0; i < 10; i++) {
+         transfer(account_id_type(), sam_id, asset(1000 + i));
+         if (i % 3 == 0)
+            create_account("alice" + std::to_string(i));
+      }
+
+      generate_block();
+      fc::usleep(fc::milliseconds(2000));
+
+      // the transfers found by type are the ones of the whole history, in the same order
+      vector<operation_history_object> all = hist_api.get_relative_account_history("committee-account", 0, 100, 0);
+      vector<operation_history_object> transfers;
+      for (const auto &op : all)
+         if (op.op.which() == transfer_op_id)
+            transfers.push_back(op);
+      BOOST_REQUIRE_EQUAL(transfers.size(), 10u);
+
+      vector<operation_history_object> histories = hist_api.get_account_history_operations("committee-account", transfer_op_id, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL(histories.size(), 10u);
+      for (size_t i = 0; i < histories.size(); i++)
+         BOOST_CHECK(histories[i].id == transfers[i].id);
+
+      // start and stop bound the operation ids, start inclusive and stop exclusive
+      histories = hist_api.get_account_history_operations("committee-account", transfer_op_id, transfers[2].id, transfers[6].id, 100);
+      BOOST_REQUIRE_EQUAL(histories.size(), 4u);
+      BOOST_CHECK(histories[0].id == transfers[2].id);
+      BOOST_CHECK(histories[3].id == transfers[5].id);
+
+      // a start on an account creation between two transfers continues with the older transfer
+      histories = hist_api.get_account_history_operations("committee-account", transfer_op_id, operation_history_id_type(transfers[6].id.instance() + 1), operation_history_id_type(), 2);
+      BOOST_REQUIRE_EQUAL(histories.size(), 2u);
+      BOOST_CHECK(histories[0].id == transfers[6].id);
+      BOOST_CHECK(histories[1].id == transfers[7].id);
+
+      histories = hist_api.get_account_history_operations("committee-account", account_create_op_id, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_CHECK_EQUAL(histories.size(), 5u);
+
+      // the relative variant takes account sequence numbers, both ends inclusive
+      const auto &stats = account_id_type()(db).statistics(db);
+      histories = hist_api.get_relative_account_history_operations("committee-account", transfer_op_id, 0, 100, 0);
+      BOOST_REQUIRE_EQUAL(histories.size(), 10u);
+      BOOST_CHECK(histories[0].id == transfers[0].id);
+      BOOST_CHECK(histories[9].id == transfers[9].id);
+
+      histories = hist_api.get_relative_account_history_operations("committee-account", transfer_op_id, 0, 3, 0);
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      BOOST_CHECK(histories[2].id == transfers[2].id);
+
+      // the most recent operation has sequence number total_ops
+      const auto seq_of = [&](operation_history_id_type id) -> uint32_t {
+         for (size_t i = 0; i < all.size(); i++)
+            if (all[i].id == id)
+               return stats.total_ops - i;
+         return 0;
+      };
+      const uint32_t seq_of_transfer_1 = seq_of(transfers[1].id);
+      const uint32_t seq_of_transfer_4 = seq_of(transfers[4].id);
+      histories = hist_api.get_relative_account_history_operations("committee-account", transfer_op_id, seq_of_transfer_4, 100, seq_of_transfer_1);
+      BOOST_REQUIRE_EQUAL(histories.size(), 4u);
+      BOOST_CHECK(histories[0].id == transfers[1].id);
+      BOOST_CHECK(histories[3].id == transfers[4].id);
+
+      histories = hist_api.get_relative_account_history_operations("sam", transfer_op_id, 0, 100, 0);
+      BOOST_CHECK_EQUAL(histories.size(), 10u);
+      histories = hist_api.get_relative_account_history_operations("sam", account_create_op_id, 0, 100, 0);
+      BOOST_CHECK_EQUAL(histories.size(), 1u);
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -328,6 +328,13 @@ BOOST_AUTO_TEST_CASE(track_votes_witnesses_enabled)
       BOOST_CHECK_EQUAL(voters_for_witness1.voters_for_witness->voters.size(), 1);
       BOOST_CHECK_EQUAL((uint32_t)voters_for_witness1.voters_for_witness->voters[0].instance, 18);
 
+      //! Check witness1 voters through the paged lookup
+      const auto voters_page = db_api1.list_voters_by_id(witness1_object->vote_id, account_id_type(), 10);
+      BOOST_REQUIRE_EQUAL(voters_page.size(), 1);
+      BOOST_CHECK_EQUAL((uint32_t)voters_page[0].id.instance(), 18);
+      BOOST_CHECK(db_api1.list_voters_by_id(witness1_object->vote_id, account_id_type(19), 10).empty());
+      GRAPHENE_REQUIRE_THROW(db_api1.list_voters_by_id(witness1_object->vote_id, account_id_type(), 1001), fc::exception);
+
       //! Check votes of account
       const auto account_votes = db_api1.get_votes("1.2.18");
       BOOST_REQUIRE(account_votes.votes_for_witnesses);
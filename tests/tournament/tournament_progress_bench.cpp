@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/chain/tournament_object.hpp>
+#include <graphene/chain/match_object.hpp>
+#include "../common/tournament_helper.hpp"
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_SUITE(tournament_progress_bench)
+
+// Many tournaments waiting on their players' moves must not make blocks more expensive: only the tournaments
+// whose matches changed are looked at, instead of all tournaments in progress
+BOOST_FIXTURE_TEST_CASE( idle_tournaments_block_overhead, database_fixture )
+{
+    try
+    {
+        const uint32_t tournament_count = 10000;
+        const uint32_t tournaments_per_block = 200;
+        const uint32_t idle_blocks = 20;
+
+        ACTORS((nathan)(alice)(bob));
+        fc::ecc::private_key nathan_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+        transfer(committee_account, nathan_id, asset(1000000000));
+        transfer(committee_account, alice_id, asset(1000000000));
+        transfer(committee_account, bob_id, asset(1000000000));
+        upgrade_to_lifetime_member(nathan);
+
+        // games time out after 600 seconds, which leaves time to start all tournaments and watch them idle
+        tournaments_helper tournament_helper(*this);
+        for (uint32_t i = 0; i < tournament_count; ++i)
+        {
+            asset buy_in = asset(1000 + i);
+            tournament_id_type tournament_id = tournament_helper.create_tournament(nathan_id, nathan_priv_key, buy_in,
+                                                                                   2, 600, 600, 3);
+            tournament_helper.join_tournament(tournament_id, alice_id, alice_id, alice_private_key, buy_in);
+            tournament_helper.join_tournament(tournament_id, bob_id, bob_id, bob_private_key, buy_in);
+            if ((i + 1) % tournaments_per_block == 0)
+                generate_block();
+        }
+        generate_blocks(db.head_block_time() + fc::seconds(10));
+
+        const auto& start_time_index = db.get_index_type<tournament_index>().indices().get<by_start_time>();
+        auto in_progress = start_time_index.equal_range(boost::make_tuple(tournament_state::in_progress));
+        BOOST_REQUIRE_EQUAL(uint32_t(std::distance(in_progress.first, in_progress.second)), tournament_count);
+
+        fc::time_point start = fc::time_point::now();
+        for (uint32_t i = 0; i < idle_blocks; ++i)
+            generate_block();
+        fc::microseconds idle_block_time = (fc::time_point::now() - start) / idle_blocks;
+
+        // what every block used to cost: checking every tournament in progress for matches to start
+        start = fc::time_point::now();
+        for (auto itr = in_progress.first; itr != in_progress.second; ++itr)
+            itr->check_for_new_matches_to_start(db);
+        fc::microseconds scan_time = fc::time_point::now() - start;
+
+        ilog("${n} tournaments in progress: ${b}us per idle block, a full scan takes ${s}us",
+             ("n", tournament_count)("b", idle_block_time.count())("s", scan_time.count()));
+
+        in_progress = start_time_index.equal_range(boost::make_tuple(tournament_state::in_progress));
+        BOOST_CHECK_EQUAL(uint32_t(std::distance(in_progress.first, in_progress.second)), tournament_count);
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()